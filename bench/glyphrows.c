@@ -0,0 +1,262 @@
+/*
+ *
+ *  Copyright (C) 2012 Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!\file	glyphrows.c
+ *!\brief	Times the kernels in pixelrows.c against the pixel at a time loops they replaced, in pixels a second, and
+ *!		checks they give the same bytes.
+ */
+
+#include "pixelrows.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const unsigned int GLYPH_W = 37;	/** Not a multiple of 16, so the ends of the rows are timed too. */
+static const unsigned int NUM_ROWS = 40000;
+static const unsigned int NUM_ROUNDS = 10;
+static const unsigned char COLOUR[3] = { 255, 0, 255 };
+static const unsigned int IMAGE_SIDE = 2048;	/** Big enough that a column of it doesn't fit in the cache. */
+static const unsigned int NUM_ROTATE_ROUNDS = 4;
+
+static double secondsNow(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/*!\brief	How glyphs were copied before they kept one channel: a switch, and a divide for each channel, every pixel. */
+static void oldGlyphRow(unsigned char *outRow, const unsigned char *refSrc, unsigned int w, int lcd){
+	unsigned int c;
+
+	for(c=0; c < w; ++c){
+		switch(lcd){
+			case 0:
+				memset(&outRow[c*4], refSrc[c], 4);
+				break;
+
+			default:
+				memcpy(&outRow[c*4], &refSrc[c*3], 3);
+				outRow[(c*4) +3] = (outRow[(c*4)] /3) + (outRow[(c*4) +1] /3) + (outRow[(c*4) +2] /3);
+				break;
+		}
+
+		outRow[(c*4)]    /= 255 -COLOUR[0] +1;
+		outRow[(c*4) +1] /= 255 -COLOUR[1] +1;
+		outRow[(c*4) +2] /= 255 -COLOUR[2] +1;
+	}
+}
+
+static void plainExpandRow(unsigned char *outRow, const unsigned char *refCoverage, unsigned int w, unsigned int sizePix){
+	unsigned int c;
+
+	memset(outRow, 0xFF, w * sizePix);
+	for(c=0; c < w; ++c)
+		outRow[(c * sizePix) + sizePix -1] = refCoverage[c];
+}
+
+/*!\brief	Turning an image a row at a time, so every pixel written is on a different row from the last. */
+static void plainRotate(unsigned char **outRows, const unsigned char * const *refRows, unsigned int w, unsigned int h, unsigned int sizeSrc, unsigned int sizePix){
+	unsigned int x, y;
+
+	for(y=0; y < h; ++y){
+		for(x=0; x < w; ++x){
+			if(sizeSrc == sizePix){
+				memcpy(&outRows[x][(h -1 -y) * sizePix], &refRows[y][x * sizePix], sizePix);
+			}else{
+				memset(&outRows[x][(h -1 -y) * sizePix], 0xFF, sizePix -1);
+				outRows[x][((h -1 -y) * sizePix) + sizePix -1] = refRows[y][x];
+			}
+		}
+	}
+}
+
+static void report(const char *strName, double numPixels, double secsOld, double secsNew){
+	printf("%-22s before %8.1f Mpix/s  after %8.1f Mpix/s  %5.2fx\n",
+		strName, numPixels / secsOld / 1e6, numPixels / secsNew / 1e6, (secsNew > 0) ? secsOld / secsNew : 0
+	);
+}
+
+int main(int argc, const char *argv[]){
+	unsigned char *dynarrGray = malloc(GLYPH_W * NUM_ROWS);
+	unsigned char *dynarrLCD = malloc(GLYPH_W * 3 * NUM_ROWS);
+	unsigned char *dynarrCoverage = malloc(GLYPH_W * NUM_ROWS);
+	unsigned char *dynarrOut = malloc(GLYPH_W * 4 * NUM_ROWS);
+	unsigned char rowA[64 * 4], rowB[64 * 4], lcd[3];
+	unsigned char *dynarrImg = malloc((size_t)IMAGE_SIDE * IMAGE_SIDE * 4);
+	unsigned char *dynarrTurnA = malloc((size_t)IMAGE_SIDE * IMAGE_SIDE * 4);
+	unsigned char *dynarrTurnB = malloc((size_t)IMAGE_SIDE * IMAGE_SIDE * 4);
+	unsigned char **dynarrImgRows = malloc(IMAGE_SIDE * sizeof(unsigned char*));
+	unsigned char **dynarrRowsA = malloc(IMAGE_SIDE * sizeof(unsigned char*));
+	unsigned char **dynarrRowsB = malloc(IMAGE_SIDE * sizeof(unsigned char*));
+	const double numGlyphPixels = (double)GLYPH_W * NUM_ROWS * NUM_ROUNDS;
+	const double numImagePixels = (double)IMAGE_SIDE * IMAGE_SIDE * NUM_ROTATE_ROUNDS;
+	unsigned int i, r, w, h, sum, sizeSrc, sizePix;
+	double start, secsOld, secsNew;
+	volatile unsigned char sink = 0;	/** So the loops aren't thrown away. */
+	int rtn = 0;
+
+	srand(1);
+	for(i=0; i < GLYPH_W * NUM_ROWS; ++i)	/** Mostly empty or solid, like a glyph. */
+		dynarrGray[i] = (rand() % 3 == 0) ? (unsigned char)rand() : (rand() % 2) * 255;
+	for(i=0; i < GLYPH_W * 3 * NUM_ROWS; ++i)
+		dynarrLCD[i] = dynarrGray[i / 3];
+
+	printf("%u pixels a row, %u rows, %u rounds\n", GLYPH_W, NUM_ROWS, NUM_ROUNDS);
+
+	/** Gray glyphs onto an RGBA sheet: the old copy into RGBA, against keeping the coverage and expanding it. */
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r)
+		oldGlyphRow(&dynarrOut[(r % NUM_ROWS) * GLYPH_W * 4], &dynarrGray[(r % NUM_ROWS) * GLYPH_W], GLYPH_W, 0);
+	secsOld = secondsNow() - start;
+	sink ^= dynarrOut[GLYPH_W];
+
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r){
+		memcpy(&dynarrCoverage[(r % NUM_ROWS) * GLYPH_W], &dynarrGray[(r % NUM_ROWS) * GLYPH_W], GLYPH_W);
+		expandCoverageRow(&dynarrOut[(r % NUM_ROWS) * GLYPH_W * 4], &dynarrCoverage[(r % NUM_ROWS) * GLYPH_W], GLYPH_W, 4);
+	}
+	secsNew = secondsNow() - start;
+	sink ^= dynarrOut[GLYPH_W];
+	report("gray to rgba", numGlyphPixels, secsOld, secsNew);
+
+	/** LCD glyphs. */
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r)
+		oldGlyphRow(&dynarrOut[(r % NUM_ROWS) * GLYPH_W * 4], &dynarrLCD[(r % NUM_ROWS) * GLYPH_W * 3], GLYPH_W, 1);
+	secsOld = secondsNow() - start;
+	sink ^= dynarrOut[GLYPH_W];
+
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r)
+		lcdRowToCoverage(&dynarrCoverage[(r % NUM_ROWS) * GLYPH_W], &dynarrLCD[(r % NUM_ROWS) * GLYPH_W * 3], GLYPH_W);
+	secsNew = secondsNow() - start;
+	sink ^= dynarrCoverage[GLYPH_W];
+	report("lcd to coverage", numGlyphPixels, secsOld, secsNew);
+
+	/** Just the expanding, a byte at a time against the kernel. */
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r)
+		plainExpandRow(&dynarrOut[(r % NUM_ROWS) * GLYPH_W * 4], &dynarrGray[(r % NUM_ROWS) * GLYPH_W], GLYPH_W, 4);
+	secsOld = secondsNow() - start;
+	sink ^= dynarrOut[GLYPH_W];
+
+	start = secondsNow();
+	for(r=0; r < NUM_ROUNDS * NUM_ROWS; ++r)
+		expandCoverageRow(&dynarrOut[(r % NUM_ROWS) * GLYPH_W * 4], &dynarrGray[(r % NUM_ROWS) * GLYPH_W], GLYPH_W, 4);
+	secsNew = secondsNow() - start;
+	sink ^= dynarrOut[GLYPH_W];
+	report("expand to rgba", numGlyphPixels, secsOld, secsNew);
+
+	/** Turning a whole RGBA image, a row at a time against a tile at a time. */
+	for(i=0; i < IMAGE_SIDE * IMAGE_SIDE * 4; ++i)
+		dynarrImg[i] = (unsigned char)rand();
+	memset(dynarrTurnA, 0, (size_t)IMAGE_SIDE * IMAGE_SIDE * 4);	/** So neither side is timing the pages being faulted in. */
+	memset(dynarrTurnB, 0, (size_t)IMAGE_SIDE * IMAGE_SIDE * 4);
+
+	start = secondsNow();
+	for(r=0; r < NUM_ROTATE_ROUNDS; ++r){
+		for(i=0; i < IMAGE_SIDE; ++i){
+			dynarrImgRows[i] = &dynarrImg[(size_t)i * IMAGE_SIDE * 4];
+			dynarrRowsA[i] = &dynarrTurnA[(size_t)i * IMAGE_SIDE * 4];
+		}
+		plainRotate(dynarrRowsA, (const unsigned char * const *)dynarrImgRows, IMAGE_SIDE, IMAGE_SIDE, 4, 4);
+	}
+	secsOld = secondsNow() - start;
+	sink ^= dynarrTurnA[IMAGE_SIDE];
+
+	start = secondsNow();
+	for(r=0; r < NUM_ROTATE_ROUNDS; ++r){
+		for(i=0; i < IMAGE_SIDE; ++i)
+			dynarrRowsB[i] = &dynarrTurnB[(size_t)i * IMAGE_SIDE * 4];
+		rotateRowsCW(dynarrRowsB, 0, (const unsigned char * const *)dynarrImgRows, IMAGE_SIDE, IMAGE_SIDE, 4, 4);
+	}
+	secsNew = secondsNow() - start;
+	sink ^= dynarrTurnB[IMAGE_SIDE];
+	report("rotate rgba", numImagePixels, secsOld, secsNew);
+
+	if(memcmp(dynarrTurnA, dynarrTurnB, (size_t)IMAGE_SIDE * IMAGE_SIDE * 4) != 0){
+		printf("rotateRowsCW is wrong for the whole image\n");
+		rtn = 1;
+	}
+
+	/** Every width up to 64, both sizes, and every sum of three sub pixels. */
+	for(w=0; w <= 64; ++w){
+		for(i=2; i <= 4; i += 2){
+			plainExpandRow(rowA, &dynarrGray[w], w, i);
+			expandCoverageRow(rowB, &dynarrGray[w], w, i);
+			if(memcmp(rowA, rowB, w * i) != 0){
+				printf("expandCoverageRow is wrong %u pixels wide, %u bytes a pixel\n", w, i);
+				rtn = 1;
+			}
+		}
+	}
+
+	/** Sizes either side of a tile, each way a pixel can be copied, and part way into the rows written. */
+	for(w=1; w <= 40; w += 3){
+		for(h=1; h <= 40; h += 3){
+			for(sizeSrc=1; sizeSrc <= 4; sizeSrc += 3){
+				for(sizePix=(sizeSrc == 1) ? 1 : 4; sizePix <= 4; ++sizePix){
+					for(i=0; i < h; ++i)
+						dynarrImgRows[i] = &dynarrImg[(size_t)i * w * sizeSrc];
+					for(i=0; i < w; ++i){
+						dynarrRowsA[i] = &dynarrTurnA[(size_t)i * (h +3) * sizePix];
+						dynarrRowsB[i] = &dynarrTurnB[(size_t)i * (h +3) * sizePix];
+					}
+
+					memset(dynarrTurnA, 0, (size_t)w * (h +3) * sizePix);
+					memset(dynarrTurnB, 0, (size_t)w * (h +3) * sizePix);
+					for(i=0; i < w; ++i)
+						dynarrRowsA[i] += 3 * sizePix;
+					plainRotate(dynarrRowsA, (const unsigned char * const *)dynarrImgRows, w, h, sizeSrc, sizePix);
+					rotateRowsCW(dynarrRowsB, 3 * sizePix, (const unsigned char * const *)dynarrImgRows, w, h, sizeSrc, sizePix);
+
+					if(memcmp(dynarrTurnA, dynarrTurnB, (size_t)w * (h +3) * sizePix) != 0){
+						printf("rotateRowsCW is wrong %u by %u, %u bytes to %u a pixel\n", w, h, sizeSrc, sizePix);
+						rtn = 1;
+					}
+				}
+			}
+		}
+	}
+
+	for(sum=0; sum <= 255 * 3; ++sum){
+		lcd[0] = (unsigned char)(sum / 3);
+		lcd[1] = (unsigned char)((sum +1) / 3);
+		lcd[2] = (unsigned char)((sum +2) / 3);
+		lcdRowToCoverage(rowA, lcd, 1);
+		if(rowA[0] != sum / 3){
+			printf("lcdRowToCoverage is wrong for a sum of %u\n", sum);
+			rtn = 1;
+		}
+	}
+
+	printf("%s\n", (rtn == 0) ? "Kernels agree" : "Kernels DISAGREE");
+
+	free(dynarrGray);
+	free(dynarrLCD);
+	free(dynarrCoverage);
+	free(dynarrOut);
+	free(dynarrImg);
+	free(dynarrTurnA);
+	free(dynarrTurnB);
+	free(dynarrImgRows);
+	free(dynarrRowsA);
+	free(dynarrRowsB);
+	return rtn;
+}
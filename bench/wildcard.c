@@ -0,0 +1,137 @@
+/*
+ *
+ *  Copyright (C) 2012 Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!\file	wildcard.c
+ *!\brief	Times hasWildStr against a compiled wildcard, over the sort of names a big directory scan sees, and checks
+ *!		they agree on every one.
+ */
+
+#include "strtools.h"
+
+#include <time.h>
+
+static const unsigned int NUM_NAMES = 30000;
+static const unsigned int NUM_ROUNDS = 20;
+
+static const char *arrPatterns[] = {
+	"*.png",	/** What we pack. */
+	"sheet*",	/** What we ignore, so we don't pack our own output. */
+	"walk_#*",
+	"*_#.png"
+};
+
+static double secondsNow(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static char** genNames(unsigned int num){
+	static const char *arrStems[] = { "walk_", "run_", "sheet", "background", "icon-", "font_" };
+	static const char *arrExts[] = { ".png", ".png", ".png", ".txt", ".png~", ".layout" };
+	char buff[128];
+	unsigned int i;
+	char **dynarrNames = calloc_chk(num, sizeof(char*));
+
+	srand(1);
+	for(i=0; i < num; ++i){
+		snprintf(buff, sizeof(buff), "%s%u%s",
+			arrStems[rand() % 6], (unsigned int)rand() % 1000, arrExts[rand() % 6]
+		);
+		copyString(&dynarrNames[i], buff);
+	}
+
+	return dynarrNames;
+}
+
+/*!\brief	sortTextures numbers frames on the assumption that sortStrings lists them highest first, and genTextures then
+ *!		reads them back to front. Checks the first half of that still holds.
+ */
+static bool checkFrameOrder(void){
+	static const char *arrWant[] = { "walk_10.png", "walk_3.png", "walk_2.png", "walk_1.png" };
+	char *arrNames[] = { "walk_2.png", "walk_10.png", "walk_1.png", "walk_3.png" };
+	unsigned int i;
+
+	sortStrings(arrNames, 4);
+	for(i=0; i < 4; ++i){
+		if(strcmp(arrNames[i], arrWant[i]) != 0){
+			printf("frame order: got %s at %u, wanted %s  <- DISAGREES\n", arrNames[i], i, arrWant[i]);
+			return FALSE;
+		}
+	}
+
+	printf("frame order: walk_10, walk_3, walk_2, walk_1\n");
+	return TRUE;
+}
+
+int main(int argc, const char *argv[]){
+	char **dynarrNames = genNames(NUM_NAMES);
+	unsigned int p, r, i, numMatched, numCompiled, numWrong;
+	double start, timeOld, timeNew;
+	sWildMatch match;
+	int rtn = 0;
+
+	printf("%u names, %u rounds\n", NUM_NAMES, NUM_ROUNDS);
+
+	for(p=0; p < sizeof(arrPatterns) / sizeof(arrPatterns[0]); ++p){
+		numMatched = numCompiled = numWrong = 0;
+
+		start = secondsNow();
+		for(r=0; r < NUM_ROUNDS; ++r){
+			for(i=0; i < NUM_NAMES; ++i)
+				numMatched += hasWildStr(dynarrNames[i], arrPatterns[p]);
+		}
+		timeOld = secondsNow() - start;
+
+		start = secondsNow();
+		for(r=0; r < NUM_ROUNDS; ++r){	/** Compiled once for each scan, the way getFiles does it. */
+			compileWildStr(arrPatterns[p], &match);
+			for(i=0; i < NUM_NAMES; ++i)
+				numCompiled += matchWildStr(dynarrNames[i], &match);
+			cleanupWildStr(&match);
+		}
+		timeNew = secondsNow() - start;
+
+		compileWildStr(arrPatterns[p], &match);
+		for(i=0; i < NUM_NAMES; ++i){
+			if(hasWildStr(dynarrNames[i], arrPatterns[p]) != matchWildStr(dynarrNames[i], &match))
+				++numWrong;
+		}
+		cleanupWildStr(&match);
+
+		printf("%-10s hasWildStr %7.1f ns  compiled %7.1f ns  %5.2fx  matched %u/%u%s\n",
+			arrPatterns[p],
+			timeOld * 1e9 / (NUM_NAMES * NUM_ROUNDS),
+			timeNew * 1e9 / (NUM_NAMES * NUM_ROUNDS),
+			(timeNew > 0) ? timeOld / timeNew : 0,
+			numCompiled / NUM_ROUNDS, NUM_NAMES,
+			(numWrong > 0 || numMatched != numCompiled) ? "  <- DISAGREES" : ""
+		);
+
+		if(numWrong > 0 || numMatched != numCompiled)
+			rtn = 1;
+	}
+
+	if(checkFrameOrder() == FALSE)
+		rtn = 1;
+
+	for(i=0; i < NUM_NAMES; ++i)
+		SAFE_DELETE(dynarrNames[i]);
+	SAFE_DELETE(dynarrNames);
+
+	return rtn;
+}
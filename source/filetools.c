@@ -18,16 +18,20 @@
 
 #include "filetools.h"
 
+#include <unistd.h>
+#include <sys/stat.h>
+
 
 #if defined __APPLE__
 	#include <CoreFoundation/CoreFoundation.h>
 	#include <CoreServices/CoreServices.h>
 #elif defined __linux
-	#include <glib.h>
-	#include <gio/gio.h>
-	#include <glib/gstdio.h>
+	#include <fcntl.h>
+	#include <sys/syscall.h>
 #endif
 
+#include <dirent.h>
+
 void getBaseDir(char **outputStr, const char *strFullPath){
 	if(outputStr==NULL || strFullPath==NULL)
 		return;
@@ -83,6 +87,10 @@ errCode getFiles(const char *strTargetDir, sFileList *output, const char *ignore
 	}
 
 	char buff[256];
+	sWildMatch matchIgnore, matchGetOnly;
+
+	compileWildStr(ignoreFiles, &matchIgnore);	/** Once for the whole directory. */
+	compileWildStr(strGetOnly, &matchGetOnly);
 
 	CFIndex numFiles = CFArrayGetCount(files);
 	while(numFiles > 0){
@@ -95,10 +103,10 @@ errCode getFiles(const char *strTargetDir, sFileList *output, const char *ignore
 		if(false == CFURLGetFileSystemRepresentation(tmp, false, (unsigned char*)buff, 256))
 			continue;
 
-		if(ignoreFiles != NULL && TRUE == hasWildStr(buff, ignoreFiles))
+		if(ignoreFiles != NULL && TRUE == matchWildStr(buff, &matchIgnore))
 			continue;
 
-		if(strGetOnly != NULL && FALSE == hasWildStr(buff, strGetOnly))
+		if(strGetOnly != NULL && FALSE == matchWildStr(buff, &matchGetOnly))
 			continue;
 
 		++output->num;
@@ -109,6 +117,8 @@ errCode getFiles(const char *strTargetDir, sFileList *output, const char *ignore
 		copyString(strmem, buff);
 	}
 
+	cleanupWildStr(&matchIgnore);
+	cleanupWildStr(&matchGetOnly);
 	CFRelease(files);
 
 	sortStrings(output->dynarrFiles, output->num);
@@ -194,120 +204,252 @@ void printAppleErrors(SInt32 code){
 
 #elif defined __linux
 
-static errCode getFSEntries(const char *strTargetDir, sFileList *output, const char *ignoreFiles, const char *strGetOnly, bool getDirs){
-	GError *errors=NULL;
-	gchar const **encodingList=NULL; /** Do NOT free */
-	gchar const *nativeEncoding=NULL;	/** Do NOT free */
-	gsize charsConverted=0;
-	gsize lengthNative=0;
-	GDir *handDir=NULL;	/**use glib to free */
-	size_t lenPlatformFName=0;
-	gchar const *refName = NULL;	/** Do NOT free */
-	GStatBuf stats;
-	gchar *platformFName=NULL;	/** free me */
-
-	const size_t lenTargetDir = strlen(strTargetDir);
+errCode getFiles(const char *strTargetDir, sFileList *output, const char *ignoreFiles, const char *strGetOnly){
+	sDirListing listing;
+	errCode rtn;
 
-	if(strTargetDir == NULL)
+	if(output == NULL)
 		return PROBLEM;
 
-	g_get_filename_charsets(&encodingList);
+	memset(output, 0, sizeof(sFileList));
 
-	if(encodingList==NULL || encodingList[0]==NULL)
+	if(scanDir(strTargetDir, &listing) != NOPROB)
 		return PROBLEM;
 
-	g_get_charset(&nativeEncoding);
+	rtn = filterFiles(&listing.files, output, ignoreFiles, strGetOnly);
+	cleanupDirListing(&listing);
+	return rtn;
+}
 
-	if(nativeEncoding==NULL)
+errCode getDirs(const char *strBaseDir, char ***dynarrDirs){
+	sDirListing listing;
+
+	if(dynarrDirs==NULL)
 		return PROBLEM;
 
-	platformFName = g_convert(
-		(const gchar*)strTargetDir, (const gssize)lenTargetDir,
-		encodingList[0], nativeEncoding,
-		&charsConverted, &lengthNative, &errors
-	);
+	if(scanDir(strBaseDir, &listing) != NOPROB)
+		return PROBLEM;
+
+	*dynarrDirs = realloc_chk(listing.dirs.dynarrFiles, sizeof(char*) * (listing.dirs.num + 1));
+	(*dynarrDirs)[listing.dirs.num] = NULL;
+
+	listing.dirs.dynarrFiles = NULL;
+	listing.dirs.num = 0;
+	cleanupDirListing(&listing);
+
+	return NOPROB;
+}
+
+#endif
+
+/*!\brief	Adds a copy of the name to the list, growing it by doubling. */
+static void pushFileName(sFileList *list, size_t *pCap, const char *strName){
+	if(list->num == *pCap){
+		*pCap = (*pCap == 0) ? 16 : *pCap * 2;
+		list->dynarrFiles = realloc_chk(list->dynarrFiles, *pCap * sizeof(char*));
+	}
 
-	if(platformFName==NULL)
+	copyString(&list->dynarrFiles[list->num], strName);
+	++list->num;
+}
+
+/*!\brief	Works out what an entry is when the directory didn't say, or it's a link and we want what it points at.
+ *!		Anything we can't stat, such as a broken link, is counted as a file.
+ */
+static bool isDirAt(int fdDir, const char *strDir, const char *strName){
+	struct stat info;
+
+#	if defined __linux
+		if(fstatat(fdDir, strName, &info, 0) != 0)
+			return FALSE;
+#	else
+		char buff[1024];
+		snprintf(buff, sizeof(buff), "%s/%s", strDir, strName);
+		if(stat(buff, &info) != 0)
+			return FALSE;
+#	endif
+
+	return S_ISDIR(info.st_mode) ? TRUE : FALSE;
+}
+
+/*!\brief	Files one entry under files or directories. */
+static void addScanEntry(sDirListing *listing, size_t *pCapFiles, size_t *pCapDirs, int fdDir, const char *strDir, const char *strName, unsigned char type){
+	bool isDir;
+
+	if(strName[0] == '.' && (strName[1] == '\0' || (strName[1] == '.' && strName[2] == '\0')))
+		return;
+
+	if(type == DT_DIR)
+		isDir = TRUE;
+	else if(type == DT_UNKNOWN || type == DT_LNK)
+		isDir = isDirAt(fdDir, strDir, strName);
+	else
+		isDir = FALSE;
+
+	if(isDir == TRUE)
+		pushFileName(&listing->dirs, pCapDirs, strName);
+	else
+		pushFileName(&listing->files, pCapFiles, strName);
+}
+
+#if defined __linux
+
+/*!\brief	What getdents64 fills its buffer with. */
+typedef struct defLinuxDirent64{
+	unsigned long long d_ino;
+	long long d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+} sLinuxDirent64;
+
+errCode scanDir(const char *strDir, sDirListing *outListing){
+	char buff[32768] __attribute__ ((aligned(8)));
+	sLinuxDirent64 const *refEntry;
+	size_t capFiles=0, capDirs=0;
+	long lenRead, offset;
+	int fdDir;
+
+	if(strDir == NULL || outListing == NULL)
 		return PROBLEM;
-	
-	handDir = g_dir_open(platformFName, 0, &errors);
-	
-	do{
-		char *nativeFName=NULL;
 
-		refName = g_dir_read_name(handDir);	/** Do not free */
+	memset(outListing, 0, sizeof(sDirListing));
+
+	fdDir = openat(AT_FDCWD, strDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fdDir < 0)
+		return PROBLEM;
 
-		if(refName==NULL)
+	for(;;){	/** A big buffer means most directories are read in one system call. */
+		lenRead = syscall(SYS_getdents64, fdDir, buff, sizeof(buff));
+		if(lenRead <= 0)
 			break;
 
-		{
-			bool goodEntry = FALSE;
-			gchar *fullPath = g_build_filename(platformFName, refName, NULL);		
-			
-			goodEntry = (g_file_test(fullPath, G_FILE_TEST_IS_DIR) == getDirs);
+		for(offset=0; offset < lenRead; offset += refEntry->d_reclen){
+			refEntry = (const sLinuxDirent64*)&buff[offset];
+			addScanEntry(outListing, &capFiles, &capDirs, fdDir, strDir, refEntry->d_name, refEntry->d_type);
+		}
+	}
 
-			g_free(fullPath);
+	close(fdDir);
 
-			if(goodEntry == FALSE)
-				continue;
-		}
+	if(lenRead < 0){
+		WARN("Unable to read all of %s", strDir);
+		cleanupDirListing(outListing);
+		return PROBLEM;
+	}
 
-		lenPlatformFName = strlen(refName);
+	sortStrings(outListing->dirs.dynarrFiles, outListing->dirs.num);
+	return NOPROB;
+}
 
-		nativeFName = (char*)g_convert(	/** nativeFName should be freed by the output file list */
-			refName, lenPlatformFName,
-			nativeEncoding, encodingList[0],
-			&charsConverted, &lengthNative, &errors
-		);
+#else
 
-		if(ignoreFiles != NULL && hasWildStr(nativeFName, ignoreFiles)==TRUE){	/** Skip ignore file */
-			SAFE_DELETE(nativeFName);
-			continue;
-		}
+errCode scanDir(const char *strDir, sDirListing *outListing){
+	struct dirent *refEntry;
+	size_t capFiles=0, capDirs=0;
+	DIR *handDir;
 
-		if(strGetOnly != NULL && hasWildStr(nativeFName, strGetOnly)==FALSE){
-			SAFE_DELETE(nativeFName);
-			continue;
-		}
+	if(strDir == NULL || outListing == NULL)
+		return PROBLEM;
 
-		++output->num;
-		output->dynarrFiles = (char**)realloc(output->dynarrFiles, sizeof(char*) * output->num);
-		output->dynarrFiles[output->num-1] = nativeFName;
+	memset(outListing, 0, sizeof(sDirListing));
 
-	}while(refName!=NULL);
+	handDir = opendir(strDir);
+	if(handDir == NULL)
+		return PROBLEM;
 
-	g_dir_close(handDir);
-	g_free(platformFName);
+	while((refEntry = readdir(handDir)) != NULL)
+		addScanEntry(outListing, &capFiles, &capDirs, dirfd(handDir), strDir, refEntry->d_name, refEntry->d_type);
 
-	sortStrings(output->dynarrFiles, output->num);
+	closedir(handDir);
 
+	sortStrings(outListing->dirs.dynarrFiles, outListing->dirs.num);
 	return NOPROB;
 }
 
+#endif
 
-errCode getFiles(const char *strTargetDir, sFileList *output, const char *ignoreFiles, const char *strGetOnly){
-	return getFSEntries(strTargetDir, output, ignoreFiles, strGetOnly, FALSE);
+static void scanDirTask(void *data){
+	sScanDir *refDir = (sScanDir*)data;
+
+	if(scanDir(refDir->strPath, &refDir->listing) != NOPROB)
+		WARN("Unable to read the directory %s", refDir->strPath);
 }
 
-errCode getDirs(const char *strBaseDir, char ***dynarrDirs){
-	if(dynarrDirs==NULL)
-		return PROBLEM;
+errCode scanTree(const char *strRoot, sThreadPool *pool, sScanDir **dynarrOut, unsigned int *outNum){
+	char buff[256];
+	unsigned int startLevel, endLevel, i, d, num;
+	sScanDir *dynarrDirs;
+	sTaskGroup group;	memset(&group, 0, sizeof(sTaskGroup));
 
-	sFileList dirs;		memset(&dirs, 0, sizeof(sFileList));
-	if(getFSEntries(strBaseDir, &dirs, NULL, NULL, TRUE)==PROBLEM){
-		cleanupFileList(&dirs);
+	if(strRoot == NULL || dynarrOut == NULL || outNum == NULL)
 		return PROBLEM;
+
+	num = 1;
+	dynarrDirs = calloc_chk(1, sizeof(sScanDir));
+	copyString(&dynarrDirs[0].strPath, strRoot);
+
+	for(startLevel=0; startLevel < num; startLevel = endLevel){
+		endLevel = num;
+
+		for(i=startLevel; i < endLevel; ++i){
+			if(pool != NULL)
+				submitTask(pool, &group, scanDirTask, &dynarrDirs[i]);
+			else
+				scanDirTask(&dynarrDirs[i]);
+		}
+
+		if(pool != NULL)
+			waitTaskGroup(pool, &group);
+
+		for(i=startLevel; i < endLevel; ++i){	/** Only once the level is done, so the array isn't moved under the tasks. */
+			if(dynarrDirs[i].listing.dirs.num == 0)
+				continue;
+
+			dynarrDirs = realloc_chk(dynarrDirs, (num + dynarrDirs[i].listing.dirs.num) * sizeof(sScanDir));
+			for(d=0; d < dynarrDirs[i].listing.dirs.num; ++d){
+				snprintf(buff, 245, "%s/%s", dynarrDirs[i].strPath, dynarrDirs[i].listing.dirs.dynarrFiles[d]);
+				memset(&dynarrDirs[num], 0, sizeof(sScanDir));
+				copyString(&dynarrDirs[num].strPath, buff);
+				++num;
+			}
+		}
 	}
-	
-	*dynarrDirs = dirs.dynarrFiles;
-	*dynarrDirs = realloc(*dynarrDirs, sizeof(char*) * (dirs.num + 1));
-	(*dynarrDirs)[dirs.num] = NULL;
 
+	*dynarrOut = dynarrDirs;
+	*outNum = num;
 	return NOPROB;
 }
 
+errCode filterFiles(const sFileList *refFiles, sFileList *output, const char *ignoreFiles, const char *strGetOnly){
+	size_t i, cap=0;
+	sWildMatch matchIgnore, matchGetOnly;
+
+	if(refFiles == NULL || output == NULL)
+		return PROBLEM;
+
+	memset(output, 0, sizeof(sFileList));
+
+	compileWildStr(ignoreFiles, &matchIgnore);
+	compileWildStr(strGetOnly, &matchGetOnly);
+
+	for(i=0; i < refFiles->num; ++i){
+		if(ignoreFiles != NULL && matchWildStr(refFiles->dynarrFiles[i], &matchIgnore) == TRUE)
+			continue;
+
+		if(strGetOnly != NULL && matchWildStr(refFiles->dynarrFiles[i], &matchGetOnly) == FALSE)
+			continue;
+
+		pushFileName(output, &cap, refFiles->dynarrFiles[i]);
+	}
+
+	cleanupWildStr(&matchIgnore);
+	cleanupWildStr(&matchGetOnly);
+
+	sortStrings(output->dynarrFiles, output->num);	/** After filtering, so it's in the same order getFiles always gave. */
+	return NOPROB;
+}
 
-#endif
 
 errCode genConfigFileEntries(const char *strFile, sCfgFileEntry ***dynarrOut, char delineator){
 	char buff[512];
@@ -355,9 +497,33 @@ errCode genConfigFileEntries(const char *strFile, sCfgFileEntry ***dynarrOut, ch
 			(*dynarrOut)[numEntries] = NULL;
 		}
 	}
+	fclose(f);
 	return NOPROB;
 }
 
+void cleanupDirListing(sDirListing *listing){
+	if(listing == NULL)
+		return;
+
+	cleanupFileList(&listing->files);
+	cleanupFileList(&listing->dirs);
+}
+
+void cleanupScanDirs(sScanDir **pDirs, unsigned int *pNum){
+	unsigned int i;
+
+	if(pDirs == NULL || *pDirs == NULL)
+		return;
+
+	for(i=0; i < *pNum; ++i){
+		SAFE_DELETE((*pDirs)[i].strPath);
+		cleanupDirListing(&(*pDirs)[i].listing);
+	}
+
+	SAFE_DELETE(*pDirs);
+	*pNum = 0;
+}
+
 errCode cleanupCfgFileEntries(sCfgFileEntry ***pEntries){
 	if(pEntries == NULL || *pEntries == NULL)
 		return NOPROB;
@@ -368,6 +534,39 @@ errCode cleanupCfgFileEntries(sCfgFileEntry ***pEntries){
 		free((*itr)->strValue);
 		free(*itr);
 	}
+	SAFE_DELETE(*pEntries);
+	return NOPROB;
+}
+
+bool fileExists(const char *strPath){
+	if(strPath == NULL)
+		return FALSE;
+
+	return (access(strPath, F_OK) == 0) ? TRUE : FALSE;
+}
+
+long getFileSize(const char *strPath){
+	struct stat info;
+
+	if(strPath == NULL || stat(strPath, &info) != 0)
+		return -1;
+
+	return (long)info.st_size;
+}
+
+errCode getFileStamp(const char *strPath, sFileStamp *outStamp){
+	struct stat info;
+
+	if(strPath == NULL || outStamp == NULL || stat(strPath, &info) != 0)
+		return PROBLEM;
+
+#	if defined __APPLE__
+		outStamp->mtime = (long long)info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#	else
+		outStamp->mtime = (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#	endif
+	outStamp->size = (long)info.st_size;
+
 	return NOPROB;
 }
 
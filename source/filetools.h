@@ -2,6 +2,7 @@
 #define FILETOOLS_H
 
 #include "strtools.h"
+#include "threadpool.h"
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -17,6 +18,24 @@ typedef struct defCfgFileEntry{
 	char *strValue;
 } sCfgFileEntry;
 
+	/*!\brief Enough to tell if a file has been touched since we last looked at it. */
+typedef struct defFileStamp{
+	long long mtime;	/*!< Modification time in nanoseconds. */
+	long size;
+} sFileStamp;
+
+	/*!\brief What was in a directory, from one read of it. */
+typedef struct defDirListing{
+	sFileList files;	/*!< Every entry that isn't a directory, in the order the file system gave them. */
+	sFileList dirs;		/*!< Names of the nested directories, sorted. */
+} sDirListing;
+
+	/*!\brief A directory found by scanTree. */
+typedef struct defScanDir{
+	char *strPath;		/*!< Cleanup. */
+	sDirListing listing;	/*!< Cleanup. */
+} sScanDir;
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -42,6 +61,25 @@ errCode getDirs(
 	const char *strBaseDir, char ***dynarrDirs
 );
 
+	/*!\brief	Reads a directory once, splitting it into files and nested directories. Uses the type the directory
+	 *!		entry gives, so nothing is stat'd unless the file system doesn't say, or it's a link.
+	 *!\return	PROBLEM if the directory can't be read.
+	 */
+errCode scanDir(const char *strDir, sDirListing *outListing);
+
+	/*!\brief	Scans a directory and every directory nested in it. Each level of the tree is scanned in parallel.
+	 *!\param	pool		Can be null, to scan on this thread.
+	 *!\param	dynarrOut	Gets the directories, the root first, then each level in turn in sorted order. Cleanup
+	 *!				with cleanupScanDirs.
+	 */
+errCode scanTree(const char *strRoot, sThreadPool *pool, sScanDir **dynarrOut, unsigned int *outNum);
+
+	/*!\brief	Copies the names that pass the filters into a sorted list, the same as getFiles gives.
+	 *!\param	ignoreFiles	Can be null.
+	 *!\param	strGetOnly	Can be null.
+	 */
+errCode filterFiles(const sFileList *refFiles, sFileList *output, const char *ignoreFiles, const char *strGetOnly);
+
 	/*!\brief 	Generates a null terminated list of entries from a config file.
 	 *!\note	A config file has any number of lines that has a 'name' and a 'value' that are separated by a delineator.
 	 *!\note	Ignores lines that have no delineator.
@@ -50,9 +88,26 @@ errCode genConfigFileEntries(
 	const char *strFile, sCfgFileEntry ***dynarrOut, char delineator
 );
 
+	/*!\brief Returns TRUE if there is something at the path. */
+bool fileExists(const char *strPath);
+
+	/*!\brief Returns the size of the file in bytes, or a negative if it can't be found. */
+long getFileSize(const char *strPath);
+
+	/*!\brief Gets the modification time and size of a file.
+	 *!\return PROBLEM if the file can't be found.
+	 */
+errCode getFileStamp(const char *strPath, sFileStamp *outStamp);
+
 	/*!\brief Cleans up the file list, duh!	*/
 errCode cleanupFileList(sFileList *files);
 
+	/*!\brief */
+void cleanupDirListing(sDirListing *listing);
+
+	/*!\brief */
+void cleanupScanDirs(sScanDir **pDirs, unsigned int *pNum);
+
 	/*!\brief cleanup list of file entries. */
 errCode cleanupCfgFileEntries(sCfgFileEntry ***dynarrEntries);
 
@@ -1,4 +1,5 @@
 #include "font.h"
+#include "pixelrows.h"
 #include <ft2build.h>
 
 #ifdef FREETYPE_2
@@ -8,6 +9,10 @@
 #endif
 
 #include FT_FREETYPE_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+#include <math.h>
+#include <limits.h>
 
 const char * FONT_SEARCH_PATTERN = "*.txt";
 const char * FONT_FILEHEADER = "make font file";
@@ -15,14 +20,129 @@ const char   FONT_CONFIG_DELIM = '=';
 const char * FONT_FILE = "file";
 const char * FONT_SIZE = "size";
 const char * FONT_COLOUR = "colour";
+const char * FONT_SDF = "sdf";
+const char * FONT_CHARS = "chars";
+const char * FONT_RANGES = "ranges";
+const char * FONT_CHARSET = "charset";
+
+static const unsigned int FONT_DPI = 300;	/*!< 300 is a common DPI for photos. */
+static const unsigned int SDF_SUPERSAMPLE = 4;	/*!< Distance fields are worked out from a glyph rendered this many times bigger. */
+static const double SDF_FAR = 1e20;
+
+/*!\brief	Adds every codepoint in the UTF-8 text, leaving out control characters such as line endings. */
+static void addWantedText(sListUint *wanted, const char *strText){
+	const unsigned char *itr = (const unsigned char*)strText;
+	unsigned int code, numMore;
+
+	while(*itr != '\0'){
+		if(*itr < 0x80){
+			code = *itr;	numMore = 0;
+		}else if((*itr & 0xE0) == 0xC0){
+			code = *itr & 0x1F;	numMore = 1;
+		}else if((*itr & 0xF0) == 0xE0){
+			code = *itr & 0x0F;	numMore = 2;
+		}else if((*itr & 0xF8) == 0xF0){
+			code = *itr & 0x07;	numMore = 3;
+		}else{
+			++itr;	/** not the start of a character. */
+			continue;
+		}
+
+		for(++itr; numMore > 0 && (*itr & 0xC0) == 0x80; ++itr, --numMore)
+			code = (code << 6) | (*itr & 0x3F);
+
+		if(numMore == 0 && code >= 0x20 && code != 0x7F)
+			pushListUint(wanted, code);
+	}
+}
+
+/*!\brief	Adds ranges like '0x20-0x7E, 0x400-0x4FF, 169', where a number on its own is one codepoint. */
+static void addWantedRanges(sListUint *wanted, const char *strRanges, const char *strFont){
+	const char *itr = strRanges;
+	char *end;
+	unsigned long first, last, code;
+
+	while(*itr != '\0'){
+		if(*itr == ',' || *itr == ' ' || *itr == '\t' || *itr == '\r'){
+			++itr;
+			continue;
+		}
+
+		first = last = strtoul(itr, &end, 0);
+		if(end != itr && *end == '-')
+			last = strtoul(&end[1], &end, 0);
+
+		if(end == itr || last < first || last > 0x10FFFF){
+			WARN("Bad range '%s' for font %s", itr, strFont);
+			return;
+		}
+
+		for(code = first; code <= last; ++code)
+			pushListUint(wanted, (unsigned int)code);
 
-sFontInfo** genFontInfos(const char *strDir, const char *strIgnores){
+		itr = end;
+	}
+}
+
+/*!\brief	Adds every codepoint in a UTF-8 text file, such as the game's strings. */
+static errCode addWantedFile(sListUint *wanted, const char *strPath){
+	FILE *handFile = fopen(strPath, "rb");
+	char *dynarrText;
+	long size;
+
+	if(handFile == NULL)
+		return PROBLEM;
+
+	fseek(handFile, 0, SEEK_END);
+	size = ftell(handFile);
+	fseek(handFile, 0, SEEK_SET);
+
+	if(size < 0){
+		fclose(handFile);
+		return PROBLEM;
+	}
+
+	dynarrText = malloc_chk((size_t)size +1);
+	size = (long)fread(dynarrText, 1, (size_t)size, handFile);
+	dynarrText[size] = '\0';
+	fclose(handFile);
+
+	addWantedText(wanted, dynarrText);
+	SAFE_DELETE(dynarrText);
+	return NOPROB;
+}
+
+static int compareCodepoints(const void *a, const void *b){
+	const unsigned int codeA = *(const unsigned int*)a, codeB = *(const unsigned int*)b;
+	return (codeA > codeB) - (codeA < codeB);
+}
+
+/*!\brief	Sorts the codepoints into the order the charmap would give them, and drops the repeats. */
+static void sortWanted(sListUint *wanted){
+	size_t i, num = 0;
+
+	if(wanted->num == 0)
+		return;
+
+	qsort(wanted->arr, wanted->num, sizeof(unsigned int), compareCodepoints);
+
+	for(i=0; i < wanted->num; ++i){
+		if(num == 0 || wanted->arr[num -1] != wanted->arr[i])
+			wanted->arr[num++] = wanted->arr[i];
+	}
+	wanted->num = num;
+}
+
+sFontInfo** genFontInfos(const char *strDir, const sFileList *refFiles, const char *strIgnores){
 	char buff[256];
 	unsigned int i, lenFts = 0;
 	sFontInfo **dynarrFts = NULL;
 	sFileList files;	memset(&files, 0, sizeof(sFileList));
 
-	getFiles(strDir, &files, strIgnores, FONT_SEARCH_PATTERN);
+	if(refFiles != NULL)
+		filterFiles(refFiles, &files, strIgnores, FONT_SEARCH_PATTERN);
+	else
+		getFiles(strDir, &files, strIgnores, FONT_SEARCH_PATTERN);
 	for(i=0; i < files.num; ++i){
 		sCfgFileEntry **entries = NULL;
 		sprintf(buff, "%s/%s", strDir, files.dynarrFiles[i]); 
@@ -43,6 +163,20 @@ sFontInfo** genFontInfos(const char *strDir, const char *strIgnores){
 					else if(strcmp(FONT_SIZE, entries[e]->strName)==0){
 						fnt->size = atoi(entries[e]->strValue);
 					}
+					else if(strcmp(FONT_SDF, entries[e]->strName)==0){
+						fnt->sdfSpread = atoi(entries[e]->strValue);
+					}
+					else if(strcmp(FONT_CHARS, entries[e]->strName)==0){
+						addWantedText(&fnt->wanted, entries[e]->strValue);
+					}
+					else if(strcmp(FONT_RANGES, entries[e]->strName)==0){
+						addWantedRanges(&fnt->wanted, entries[e]->strValue, fnt->strName);
+					}
+					else if(strcmp(FONT_CHARSET, entries[e]->strName)==0){
+						snprintf(buff, 246, "%s/%s", strDir, entries[e]->strValue);
+						if(addWantedFile(&fnt->wanted, buff) != NOPROB)
+							WARN("Unable to read the charset %s for font %s", buff, fnt->strName);
+					}
 					else if(strcmp(FONT_COLOUR, entries[e]->strName)==0){
 						size_t end;
 						short channel;
@@ -65,6 +199,8 @@ sFontInfo** genFontInfos(const char *strDir, const char *strIgnores){
 					}
 				}
 
+				sortWanted(&fnt->wanted);
+
 				if(fnt->strFile != NULL && fnt->size > 0){
 					++lenFts;
 					dynarrFts = realloc_chk(dynarrFts, sizeof(sFontInfo*) * (lenFts +1));
@@ -82,24 +218,478 @@ sFontInfo** genFontInfos(const char *strDir, const char *strIgnores){
 }
 
 
-errCode genTexFromFonts(sFontInfo **pArrFntIfo, sTex ***pDynarrOutTex, sFontList *pOutList){
-	static const size_t MAX_STRBUFF = 256, MAX_FNTNAME = 128, MAX_CHARCODE = 127;
+/*!\brief	One pass of the exact euclidean distance transform, from Felzenszwalb and Huttenlocher. Each sample becomes the
+ *!		squared distance to the nearest zero along the line, taken from the lower envelope of the parabolas rooted at
+ *!		every sample, so it's linear in the number of samples.
+ *!\param	stride	Gap between the samples, so the columns can be done in place as well as the rows.
+ *!\param	f, z, v	Room for n, n+1 and n values.
+ */
+static void passDistance(double *samples, size_t stride, unsigned int n, double *f, double *z, int *v){
+	unsigned int q;
+	int k = 0;
+	double s;
+
+	for(q=0; q < n; ++q)
+		f[q] = samples[q * stride];
+
+	v[0] = 0;
+	z[0] = -SDF_FAR;
+	z[1] = SDF_FAR;
+
+	for(q=1; q < n; ++q){
+		do{
+			s = ((f[q] + (double)q*q) - (f[v[k]] + (double)v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+		}while(s <= z[k] && --k >= 0);
+
+		++k;
+		v[k] = (int)q;
+		z[k] = s;
+		z[k +1] = SDF_FAR;
+	}
+
+	k = 0;
+	for(q=0; q < n; ++q){
+		while(z[k +1] < q)
+			++k;
+		samples[q * stride] = ((double)q - v[k]) * ((double)q - v[k]) + f[v[k]];
+	}
+}
+
+/*!\brief	Squared distance from every sample to the nearest zero, columns then rows. */
+static void genDistances(double *grid, unsigned int w, unsigned int h, double *f, double *z, int *v){
+	unsigned int x, y;
+
+	for(x=0; x < w; ++x)
+		passDistance(&grid[x], w, h, f, z, v);
+
+	for(y=0; y < h; ++y)
+		passDistance(&grid[y * w], 1, w, f, z, v);
+}
+
+/*!\brief	Turns a glyph rendered SDF_SUPERSAMPLE times bigger into a signed distance field, padded by the spread on
+ *!		every side. Each pixel of the field is the average distance over the block of the big glyph it covers.
+ *!\return	A byte for each pixel, where 128 is the edge of the glyph, higher is inside, and 0 or 255 is the spread
+ *!		away or more. Null when the glyph is blank. Cleanup.
+ */
+static unsigned char* genDistanceField(const FT_Bitmap *refBitmap, unsigned int spread, unsigned int *outW, unsigned int *outH){
+	const unsigned int pad = spread * SDF_SUPERSAMPLE;
+	unsigned int w, h, x, y, bx, by, i;
+	double *dynarrToIn, *dynarrToOut, *dynarrF, *dynarrZ;
+	int *dynarrV;
+	unsigned char *dynarrField;
+	double sum, alpha;
+	bool inside;
+
+	*outW = 0;
+	*outH = 0;
+	if(refBitmap->width == 0 || refBitmap->rows == 0)
+		return NULL;
+
+	*outW = (refBitmap->width + pad *2 + SDF_SUPERSAMPLE -1) / SDF_SUPERSAMPLE;
+	*outH = (refBitmap->rows + pad *2 + SDF_SUPERSAMPLE -1) / SDF_SUPERSAMPLE;
+	w = *outW * SDF_SUPERSAMPLE;
+	h = *outH * SDF_SUPERSAMPLE;
+
+	dynarrToIn = malloc_chk(sizeof(double) * w * h);
+	dynarrToOut = malloc_chk(sizeof(double) * w * h);
+	dynarrF = malloc_chk(sizeof(double) * (w > h ? w : h));
+	dynarrZ = malloc_chk(sizeof(double) * ((w > h ? w : h) +1));
+	dynarrV = malloc_chk(sizeof(int) * (w > h ? w : h));
+	dynarrField = malloc_chk(*outW * *outH);
+
+	/** Anything at least half covered is inside. */
+	for(y=0; y < h; ++y){
+		for(x=0; x < w; ++x){
+			inside = (x >= pad && y >= pad && x - pad < refBitmap->width && y - pad < refBitmap->rows
+				&& refBitmap->buffer[((int)(y - pad) * refBitmap->pitch) + (x - pad)] >= 128);
+			dynarrToIn[(y * w) + x] = inside ? 0 : SDF_FAR;
+			dynarrToOut[(y * w) + x] = inside ? SDF_FAR : 0;
+		}
+	}
+
+	genDistances(dynarrToIn, w, h, dynarrF, dynarrZ, dynarrV);
+	genDistances(dynarrToOut, w, h, dynarrF, dynarrZ, dynarrV);
+
+	/** The edge runs between the last pixel in and the first out, so it's half a pixel nearer than either. */
+	for(y=0; y < *outH; ++y){
+		for(x=0; x < *outW; ++x){
+			sum = 0;
+			for(by=0; by < SDF_SUPERSAMPLE; ++by){
+				for(bx=0; bx < SDF_SUPERSAMPLE; ++bx){
+					i = (((y * SDF_SUPERSAMPLE) + by) * w) + (x * SDF_SUPERSAMPLE) + bx;
+					if(dynarrToIn[i] > 0)
+						sum -= sqrt(dynarrToIn[i]) - 0.5;
+					else
+						sum += sqrt(dynarrToOut[i]) - 0.5;
+				}
+			}
+
+			alpha = 128.0 + (sum / (SDF_SUPERSAMPLE * SDF_SUPERSAMPLE * SDF_SUPERSAMPLE)) * 128.0 / spread;
+			dynarrField[(y * *outW) + x] = (alpha <= 0) ? 0 : (alpha >= 255) ? 255 : (unsigned char)(alpha + 0.5);
+		}
+	}
+
+	free(dynarrToIn);
+	free(dynarrToOut);
+	free(dynarrF);
+	free(dynarrZ);
+	free(dynarrV);
+	return dynarrField;
+}
+
+/*!\brief	A run of glyphs from one font, rendered on a FreeType library of its own, so runs can be rendered at the same time. */
+typedef struct defGlyphJob{
+	const sFontInfo *refInfo;
+	const char *refstrPrefix;		/*!< Start of every glyph's name. */
+	const FT_ULong *refCharcodes;	/*!< Every glyph in the font, in the order they came from the charmap. */
+	const FT_UInt *refIdxGlyphs;
+	unsigned int start, num;
+	sTex **refResults;		/*!< Null for glyphs that failed. */
+	unsigned int *refOffsetY;
+	sGlyphMetrics *refMetrics;
+	sLogContext logContext;	/*!< Whoever wanted the font rendered. */
+} sGlyphJob;
+
+static const unsigned int GLYPHS_PER_JOB = 256;	/*!< Each job opens the font again, so they shouldn't be too small. */
+
+/*!\brief	Sets the size the font is rendered at, bigger for distance fields. */
+static errCode setFontSize(FT_Face face, const sFontInfo *refInfo){
+	const FT_F26Dot6 size = refInfo->size *64 *(refInfo->sdfSpread > 0 ? SDF_SUPERSAMPLE : 1);
+
+	return (FT_Set_Char_Size(face, size, size, FONT_DPI, FONT_DPI) == 0) ? NOPROB : PROBLEM;
+}
+
+/*!\brief	The glyph cache key, from the font file and everything that changes how its glyphs come out.
+ *!\return	Zero if the font file can't be read, so it isn't cached.
+ */
+static unsigned long long genGlyphCacheKey(const sFontInfo *refInfo){
+	const unsigned int arrSettings[] = {
+		refInfo->size, FONT_DPI, refInfo->sdfSpread, SDF_SUPERSAMPLE, FT_LOAD_DEFAULT, FT_RENDER_MODE_NORMAL,
+		FREETYPE_MAJOR, FREETYPE_MINOR, FREETYPE_PATCH
+	};
+	const long sizeFile = getFileSize(refInfo->strFile);
+	unsigned long long key;
+	unsigned char *dynarrFile;
+	FILE *handFile;
+
+	if(sizeFile <= 0 || (handFile = fopen(refInfo->strFile, "rb")) == NULL)
+		return 0;
+
+	dynarrFile = malloc_chk((size_t)sizeFile);
+	if(fread(dynarrFile, 1, (size_t)sizeFile, handFile) != (size_t)sizeFile){
+		fclose(handFile);
+		free(dynarrFile);
+		return 0;
+	}
+	fclose(handFile);
+
+	key = hashMem64(dynarrFile, (size_t)sizeFile, HASH64_START);
+	key = hashMem64(arrSettings, sizeof(arrSettings), key);
+	key = hashMem64(refInfo->wanted.arr, refInfo->wanted.num * sizeof(unsigned int), key);
+	free(dynarrFile);
+
+	return (key != 0) ? key : 1;
+}
+
+/*!\brief	Pixels at the size the glyphs go on the sheets, from pixels at the size they were rendered. */
+static int toSheetPixels(double rendered, const sFontInfo *refInfo){
+	return (int)floor((refInfo->sdfSpread > 0 ? rendered / SDF_SUPERSAMPLE : rendered) + 0.5);
+}
+
+/*!\brief	Renders one glyph. Glyphs with no graphics, such as spaces, are a single clear pixel, so they keep their advance.
+ *!\param	outOffsetY	Taken from the glyph the face last loaded, before this one is loaded.
+ *!\return	Null if it failed. Cleanup.
+ */
+static sTex* renderGlyph(FT_Face face, const sFontInfo *refInfo, const char *strPrefix, FT_ULong charcode, FT_UInt idxGlyph, unsigned int idxChar, unsigned int *outOffsetY, sGlyphMetrics *outMetrics){
+	static const size_t MAX_STRBUFF = 256;
+
+	sTex *		refTexCur;
+	FT_Glyph	glyph;
+	FT_BitmapGlyph  bitmap;
+	char		strBuff[MAX_STRBUFF];
+	unsigned int	r;
+	unsigned char *	dynarrField =NULL;
+
+	refTexCur = malloc_chk(sizeof(sTex));
+	memset(refTexCur, 0, sizeof(sTex));
+
+	snprintf(strBuff, MAX_STRBUFF, "%s%lu", strPrefix, charcode);
+	copyString(&refTexCur->name, strBuff);
+
+	*outOffsetY = (face->glyph->metrics.vertBearingY) / 64;
+	if(refInfo->sdfSpread > 0)	/** rendered bigger, and the field is padded by the spread. */
+		*outOffsetY = (*outOffsetY / SDF_SUPERSAMPLE) + refInfo->sdfSpread;
+
+	if(FT_Load_Glyph(face, idxGlyph, FT_LOAD_DEFAULT) != 0){
+		WARN("failed to load glyph %i, for font %s", idxChar, refInfo->strName);
+		goto renderGlyph_fail;
+	}
+
+	if(FT_Get_Glyph(face->glyph, &glyph) != 0){
+		WARN("Failed to get glyph %i, from font %s", idxChar, refInfo->strName);
+		goto renderGlyph_fail;
+	}
+
+	if(FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, 0, 1) != 0){
+		WARN("Failed to render glyph %i, from font %s", idxChar, refInfo->strName);
+		goto renderGlyph_fail;
+	}
+
+	bitmap = (FT_BitmapGlyph)glyph;
+
+	outMetrics->advance = toSheetPixels(face->glyph->advance.x / 64.0, refInfo);
+	outMetrics->bearingX = toSheetPixels(bitmap->left, refInfo) - (int)refInfo->sdfSpread;	/** the field is padded by the spread. */
+	outMetrics->bearingY = toSheetPixels(bitmap->top, refInfo) + (int)refInfo->sdfSpread;
+
+	if(bitmap->bitmap.width == 0 || bitmap->bitmap.rows == 0){	/** it's not unusual for there to be glyphs with no graphics. */
+		outMetrics->bearingX = 0;
+		outMetrics->bearingY = 0;
+		refTexCur->w = refTexCur->h = 1;
+		refTexCur->dynarrRows = calloc_chk(1, sizeof(png_byte*));
+		refTexCur->dynarrRows[0] = calloc_chk(1, sizeof(png_byte));
+		refTexCur->colorType = PNG_COLOR_TYPE_GRAY;
+		FT_Done_Glyph(glyph);
+		return refTexCur;
+	}
+
+	switch(bitmap->bitmap.pixel_mode){
+		case FT_PIXEL_MODE_GRAY:
+		case FT_PIXEL_MODE_LCD:
+			break;
+
+		default:
+			WARN("Mode %i unsupported. Font %s", bitmap->bitmap.pixel_mode, refInfo->strName);
+			FT_Done_Glyph(glyph);
+			goto renderGlyph_fail;
+	}
+
+	if(refInfo->sdfSpread > 0){
+		dynarrField = genDistanceField(&bitmap->bitmap, refInfo->sdfSpread, &refTexCur->w, &refTexCur->h);
+	}else{
+		refTexCur->w = bitmap->bitmap.width;
+		refTexCur->h = bitmap->bitmap.rows;
+		if(bitmap->bitmap.pixel_mode == FT_PIXEL_MODE_LCD)	/** three bytes a pixel, one for each sub pixel. */
+			refTexCur->w /= 3;
+	}
+
+	refTexCur->dynarrRows = calloc_chk(refTexCur->h, sizeof(png_byte*));
+
+	for(r=0; r < refTexCur->h; ++r){	/** only the coverage is kept, and the colour goes in the manifest. */
+		refTexCur->dynarrRows[r] = calloc_chk(refTexCur->w, sizeof(png_byte));
+
+		if(dynarrField != NULL){
+			memcpy(refTexCur->dynarrRows[r], &dynarrField[r * refTexCur->w], refTexCur->w);
+			continue;
+		}
+
+		switch(bitmap->bitmap.pixel_mode){
+			case FT_PIXEL_MODE_GRAY:
+				memcpy(refTexCur->dynarrRows[r], &bitmap->bitmap.buffer[r *bitmap->bitmap.pitch], refTexCur->w);
+				break;
+
+			case FT_PIXEL_MODE_LCD:
+				lcdRowToCoverage(refTexCur->dynarrRows[r], &bitmap->bitmap.buffer[r *bitmap->bitmap.pitch], refTexCur->w);
+				break;
+		}
+	}
+
+	refTexCur->pngptrData = NULL;	/** these shouldn't matter at the moment because they aren't needed for copying onto the sprite. */
+	refTexCur->pngptrInfo = NULL;
+	refTexCur->colorType = PNG_COLOR_TYPE_GRAY;
+
+	SAFE_DELETE(dynarrField);
+	FT_Done_Glyph(glyph);
+	return refTexCur;
+
+renderGlyph_fail:
+	cleanupTex(refTexCur);
+	free(refTexCur);
+	WARN("Char %i failed", idxChar);
+	return NULL;
+}
+
+/*!\brief	FreeType libraries can't be shared between threads, so each run opens the font on a library of its own. */
+static void renderGlyphsTask(void *data){
+	sGlyphJob *job = (sGlyphJob*)data;
+	sLogContext prevContext;
+	FT_Library handFF;
+	FT_Face face;
+	unsigned int i;
+
+	getLogContext(&prevContext);
+	setLogContext(&job->logContext);
+
+	if(FT_Init_FreeType(&handFF) != 0){
+		WARN("Can't initialise free type library");
+		goto renderGlyphsTask_end;
+	}
+
+	if(FT_New_Face(handFF, job->refInfo->strFile, 0, &face) != 0 || setFontSize(face, job->refInfo) != NOPROB){
+		WARN("Unable to open font %s", job->refInfo->strName);
+		FT_Done_FreeType(handFF);
+		goto renderGlyphsTask_end;
+	}
+
+	/** A glyph's y offset is read from the glyph loaded before it, so the run starts by loading that one. */
+	if(job->start > 0)
+		FT_Load_Glyph(face, job->refIdxGlyphs[job->start -1], FT_LOAD_DEFAULT);
+
+	for(i = job->start; i < job->start + job->num; ++i)
+		job->refResults[i] = renderGlyph(
+			face, job->refInfo, job->refstrPrefix, job->refCharcodes[i], job->refIdxGlyphs[i], i, &job->refOffsetY[i], &job->refMetrics[i]
+		);
+
+	FT_Done_Face(face);
+	FT_Done_FreeType(handFF);
+
+renderGlyphsTask_end:
+	setLogContext(&prevContext);
+}
+
+/*!\brief	Orders kerning pairs by the left glyph, then the right. */
+static int compareKernPairs(const void *a, const void *b){
+	const sKernPair *refA = (const sKernPair*)a;
+	const sKernPair *refB = (const sKernPair*)b;
+
+	if(refA->left != refB->left)
+		return (refA->left < refB->left) ? -1 : 1;
+	if(refA->right != refB->right)
+		return (refA->right < refB->right) ? -1 : 1;
+	return 0;
+}
+
+/*!\brief	Big endian, as everything in a TrueType table is. */
+static unsigned int readTableU16(const FT_Byte *refTable, FT_ULong pos){
+	return ((unsigned int)refTable[pos] << 8) | refTable[pos +1];
+}
+
+/*!\brief	Works out the kerning between the glyphs that were loaded. Asking FreeType about every pair would take too long
+ *!		for a whole font, so the pairs are taken from the font's kern table, which is where FreeType's kerning comes
+ *!		from, and FreeType is asked for the amount of each. Kerning that's only in the GPOS table isn't found.
+ *!\param	refIdxGlyphs	The font's glyph index for each glyph in refInfo->dynarrCharcodes.
+ */
+static void genKerning(FT_Face face, sFontInfo *refInfo, const FT_UInt *refIdxGlyphs){
+	FT_ULong	lenTable =0, pos, posPair;
+	FT_Byte *	dynarrTable;
+	FT_Vector	delta;
+	unsigned int	numTables, numPairs, coverage, lenSub, t, p, i, a, b, l, r, maxPairs;
+	unsigned int *	dynarrFirst;	/** The first loaded glyph for each glyph index, then the next with the same index. */
+	unsigned int *	dynarrNext;
+	sKernPair *	dynarrPairs =NULL;
+	unsigned int	numFound =0;
+
+	if(!FT_IS_SFNT(face) || !FT_HAS_KERNING(face) || refInfo->numLoaded == 0)
+		return;
+
+	if(FT_Load_Sfnt_Table(face, TTAG_kern, 0, NULL, &lenTable) != 0 || lenTable < 4)
+		return;
+
+	dynarrTable = malloc_chk(lenTable);
+	if(FT_Load_Sfnt_Table(face, TTAG_kern, 0, dynarrTable, &lenTable) != 0 || readTableU16(dynarrTable, 0) != 0){	/** Apple's version isn't read. */
+		free(dynarrTable);
+		return;
+	}
+
+	dynarrFirst = malloc_chk(face->num_glyphs * sizeof(unsigned int));
+	dynarrNext = malloc_chk(refInfo->numLoaded * sizeof(unsigned int));
+	for(i=0; i < (unsigned int)face->num_glyphs; ++i)
+		dynarrFirst[i] = UINT_MAX;
+
+	for(i = refInfo->numLoaded; i > 0; --i){
+		dynarrNext[i -1] = dynarrFirst[ refIdxGlyphs[i -1] ];
+		dynarrFirst[ refIdxGlyphs[i -1] ] = i -1;
+	}
+
+	/** Every pair in the horizontal format 0 subtables, between glyphs that were loaded. */
+	maxPairs = 0;
+	numTables = readTableU16(dynarrTable, 2);
+	for(t=0, pos=4; t < numTables && pos +14 <= lenTable; ++t){
+		lenSub = readTableU16(dynarrTable, pos +2);
+		coverage = readTableU16(dynarrTable, pos +4);
+		numPairs = readTableU16(dynarrTable, pos +6);
+
+		if((coverage >> 8) != 0){	/** Other formats can't be skipped over safely when their length has overflowed. */
+			if(lenSub == 0)
+				break;
+			pos += lenSub;
+			continue;
+		}
+
+		for(p=0, posPair = pos +14; (coverage & 0x7) == 0x1 && p < numPairs && posPair +6 <= lenTable; ++p, posPair += 6){
+			a = readTableU16(dynarrTable, posPair);
+			b = readTableU16(dynarrTable, posPair +2);
+			if(a >= (unsigned int)face->num_glyphs || b >= (unsigned int)face->num_glyphs)
+				continue;
+
+			for(l = dynarrFirst[a]; l != UINT_MAX; l = dynarrNext[l]){
+				for(r = dynarrFirst[b]; r != UINT_MAX; r = dynarrNext[r]){
+					if(numFound == maxPairs){
+						maxPairs = (maxPairs == 0) ? 64 : maxPairs *2;
+						dynarrPairs = realloc_chk(dynarrPairs, maxPairs * sizeof(sKernPair));
+					}
+
+					dynarrPairs[numFound].left = l;
+					dynarrPairs[numFound].right = r;
+					++numFound;
+				}
+			}
+		}
+
+		pos += 14 + ((FT_ULong)numPairs * 6);	/** Big tables overflow their length, so it's worked out from the pairs. */
+	}
+
+	/** The same pair can be in more than one subtable, and FreeType adds them up. */
+	if(numFound > 0)
+		qsort(dynarrPairs, numFound, sizeof(sKernPair), compareKernPairs);
+
+	refInfo->numKerning = 0;
+	for(i=0; i < numFound; ++i){
+		if(i > 0 && compareKernPairs(&dynarrPairs[i], &dynarrPairs[i -1]) == 0)
+			continue;
+
+		if(FT_Get_Kerning(face, refIdxGlyphs[ dynarrPairs[i].left ], refIdxGlyphs[ dynarrPairs[i].right ], FT_KERNING_UNFITTED, &delta) != 0)
+			continue;
+
+		dynarrPairs[i].amount = toSheetPixels(delta.x / 64.0, refInfo);
+		if(dynarrPairs[i].amount != 0)
+			dynarrPairs[refInfo->numKerning++] = dynarrPairs[i];
+	}
+
+	if(refInfo->numKerning > 0){
+		refInfo->dynarrKerning = realloc_chk(dynarrPairs, refInfo->numKerning * sizeof(sKernPair));
+		dynarrPairs = NULL;
+	}
+
+	SAFE_DELETE(dynarrPairs);
+	free(dynarrFirst);
+	free(dynarrNext);
+	free(dynarrTable);
+}
+
+errCode genTexFromFonts(sFontInfo **pArrFntIfo, sTex ***pDynarrOutTex, sFontList *pOutList, const char *strCacheDir, sThreadPool *pool){
+	static const size_t MAX_FNTNAME = 128;
 
 	if(pArrFntIfo == NULL || pDynarrOutTex == NULL)
 		return PROBLEM;
 
-	sTex *		refTexCur =NULL;
 	unsigned int	lenCur =0;
 	unsigned int	lenArrTex =0;
+	unsigned int	numChars, numJobs, i;
 	size_t		lenFntName;
 	FT_Face		face;
-	FT_Glyph	glyph;
-	FT_BitmapGlyph  bitmap;
 	FT_UInt		idxGlyph;
 	FT_ULong	charcode;
-	char		strBuff[MAX_STRBUFF];
-	unsigned int	r, c;
+	unsigned long long cacheKey;
+	char		strPrefix[MAX_FNTNAME +1];
 	sFontInfo **	itr;
+	FT_ULong *	dynarrCharcodes;
+	FT_UInt *	dynarrIdxGlyphs;
+	sTex **		dynarrResults;
+	unsigned int *	dynarrOffsetY;
+	sGlyphMetrics *	dynarrMetrics;
+	FT_UInt *	dynarrLoadedIdx;
+	sGlyphJob *	dynarrJobs;
+	sTaskGroup	group;
 
 	FT_Library handFF;
 	if(FT_Init_FreeType(&handFF) != 0){
@@ -107,180 +697,192 @@ errCode genTexFromFonts(sFontInfo **pArrFntIfo, sTex ***pDynarrOutTex, sFontList
 		return PROBLEM;
 	}
 
+	if(*pDynarrOutTex != NULL){
+		while((*pDynarrOutTex)[lenArrTex] != NULL)
+			++lenArrTex;
+	}
+
 	for(itr = pArrFntIfo; *itr != NULL; ++itr){
 
-		if(FT_New_Face(handFF, (*itr)->strFile, 0, &face) != 0)
-			goto genTexFromFonts_fail;
+		lenFntName = strlen((*itr)->strName);
+		if(lenFntName > MAX_FNTNAME -1)
+			continue;
 
-		if(FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0)
-			goto genTexFromFonts_fail;
+		memcpy(strPrefix, (*itr)->strName, lenFntName * sizeof(char));
+		strPrefix[lenFntName] = '_';
+		strPrefix[lenFntName +1] = '\0';
+
+		cacheKey = (strCacheDir != NULL) ? genGlyphCacheKey(*itr) : 0;
+		if(cacheKey != 0 && loadGlyphCache(strCacheDir, cacheKey, strPrefix, *itr, pDynarrOutTex, &lenArrTex) == NOPROB){
+			XTRA_LOG("Font %s came from the glyph cache, with %u characters\n", (*itr)->strFile, (*itr)->numLoaded);
+			continue;
+		}
+
+		if(FT_New_Face(handFF, (*itr)->strFile, 0, &face) != 0)
+			continue;
 
-		if(face->num_glyphs == 0)
+		if(FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0 || face->num_glyphs == 0)
 			goto genTexFromFonts_fail;
 
 		(*itr)->numGlyphs = face->num_glyphs;
 
-		lenFntName = strlen((*itr)->strName);
-		if(lenFntName > MAX_FNTNAME -1)
+		if(setFontSize(face, *itr) != NOPROB){
+			WARN("Unable to set size for font %s", (*itr)->strName);
 			goto genTexFromFonts_fail;
+		}
 
-		memcpy(strBuff, (*itr)->strName, lenFntName * sizeof(char)); /** leaving room in the buffer for the ending. */
-		strBuff[lenFntName] = '_';
-		++lenFntName;
-
-		{
-			const FT_F26Dot6 size = (*itr)->size *64;
-			const FT_UInt dpi = 300; /** 300 is a common DPI for photos. */
-			if(FT_Set_Char_Size(face, size, size, dpi, dpi) != 0){
-				WARN("Unable to set size for font %s", (*itr)->strName);
-				continue;
-			}
+		/** The charmap is read here, and the glyphs are split into runs that can be rendered at the same time. */
+		numChars = 0;
+		if((*itr)->wanted.num > 0){
+			numChars = (*itr)->wanted.num;
+		}else{
+			for( 	charcode = FT_Get_First_Char(face, &idxGlyph); 
+				idxGlyph != 0;
+				charcode = FT_Get_Next_Char(face, charcode, &idxGlyph)
+			)
+				++numChars;
 		}
 
-		const unsigned int lenOrig = lenArrTex;
-		lenCur = 0;
-		lenArrTex += face->num_glyphs;
-		(*pDynarrOutTex) = realloc_chk((*pDynarrOutTex), (lenArrTex +1) * sizeof(sTex*));
-		memset(&(*pDynarrOutTex)[lenOrig], 0, (face->num_glyphs +1) * sizeof(sTex*)); /* ensure the end, and any fails are null. Don't worry if there are spare slots. These will be used up on the next reallocation. */
-		(*itr)->dynarrCharcodes = calloc_chk(face->num_glyphs, sizeof(unsigned int));
-		(*itr)->dynarrOffsetY = calloc_chk(face->num_glyphs, sizeof(unsigned int));
-	
-		for( 	charcode = FT_Get_First_Char(face, &idxGlyph); 
-			idxGlyph != 0;
-			charcode = FT_Get_Next_Char(face, charcode, &idxGlyph)
-		){
-			if(lenOrig + lenCur >= lenArrTex)
-				goto genTexFromFonts_failloop;
-
-			refTexCur = malloc_chk(sizeof(sTex));
-			memset(refTexCur, 0, sizeof(sTex));
-
-			(*itr)->dynarrCharcodes[lenCur] = charcode;
-			snprintf(&strBuff[lenFntName], MAX_CHARCODE, "%lu", charcode);
-			copyString(&refTexCur->name, strBuff);
-
-			(*itr)->dynarrOffsetY[lenCur] = (face->glyph->metrics.vertBearingY) / 64;
-
-			if(FT_Load_Glyph(face, idxGlyph, FT_LOAD_DEFAULT) != 0){
-				WARN("failed to load glyph %i, for font %s", lenCur, (*itr)->strName);
-				goto genTexFromFonts_failloop;
+		dynarrCharcodes = calloc_chk(numChars +1, sizeof(FT_ULong));
+		dynarrIdxGlyphs = calloc_chk(numChars +1, sizeof(FT_UInt));
+		dynarrResults = calloc_chk(numChars +1, sizeof(sTex*));
+		dynarrOffsetY = calloc_chk(numChars +1, sizeof(unsigned int));
+		dynarrMetrics = calloc_chk(numChars +1, sizeof(sGlyphMetrics));
+
+		numChars = 0;
+		if((*itr)->wanted.num > 0){	/** Only the codepoints asked for, and only if the font has them. */
+			for(i=0; i < (*itr)->wanted.num; ++i){
+				idxGlyph = FT_Get_Char_Index(face, (*itr)->wanted.arr[i]);
+				if(idxGlyph == 0)
+					continue;
+
+				dynarrCharcodes[numChars] = (*itr)->wanted.arr[i];
+				dynarrIdxGlyphs[numChars] = idxGlyph;
+				++numChars;
 			}
 
-			if(FT_Get_Glyph(face->glyph, &glyph) != 0){
-				WARN("Failed to get glyph %i, from font %s", lenCur, (*itr)->strName);
-				goto genTexFromFonts_failloop;
-			}
-		
-			if(FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, 0, 1) != 0){
-				WARN("Failed to render glyph %i, from font %s", lenCur, (*itr)->strName);
-				goto genTexFromFonts_failloop;
-			}
-		
-			bitmap = (FT_BitmapGlyph)glyph;
-
-			switch(bitmap->bitmap.pixel_mode){
-				case FT_PIXEL_MODE_GRAY:
-				case FT_PIXEL_MODE_LCD:
-					break;
-
-				default:
-					WARN("Mode %i unsupported. Font %s", bitmap->bitmap.pixel_mode, (*itr)->strName);
-					FT_Done_Glyph(glyph);
-					goto genTexFromFonts_failloop;
+			if(numChars < (*itr)->wanted.num)
+				WARN("Font %s doesn't have %u of the characters asked for", (*itr)->strName, (unsigned int)((*itr)->wanted.num - numChars));
+		}else{
+			for( 	charcode = FT_Get_First_Char(face, &idxGlyph); 
+				idxGlyph != 0;
+				charcode = FT_Get_Next_Char(face, charcode, &idxGlyph)
+			){
+				dynarrCharcodes[numChars] = charcode;
+				dynarrIdxGlyphs[numChars] = idxGlyph;
+				++numChars;
 			}
+		}
 
-			refTexCur->w = bitmap->bitmap.width;
-			refTexCur->h = bitmap->bitmap.rows;
-
-			if(refTexCur->w != 0 && refTexCur->h != 0){	/** it's not unusual for there to be glyphs with no graphics, so still add it to the array (a null would terminate it). */
-				refTexCur->dynarrRows = calloc_chk(refTexCur->h, sizeof(png_byte*));
-
-				for(r=0; r < refTexCur->h; ++r){
-					refTexCur->dynarrRows[r] = calloc_chk(refTexCur->w, 4);
-
-					for(c=0; c < refTexCur->w; ++c){
-						switch(bitmap->bitmap.pixel_mode){
-							case FT_PIXEL_MODE_GRAY:
-								memset(
-									&refTexCur->dynarrRows[r][c*4],
-									bitmap->bitmap.buffer[(r *bitmap->bitmap.pitch) +c],
-									sizeof(char) *4
-								);
-								break;
-
-							case FT_PIXEL_MODE_LCD:
-								memcpy(
-									&refTexCur->dynarrRows[r][c*4],
-									&bitmap->bitmap.buffer[(r *bitmap->bitmap.pitch) +(c*3)],
-									sizeof(char) *3
-								);
-								refTexCur->dynarrRows[r][(c*4) +3] = (refTexCur->dynarrRows[r][(c*4)] /3)
-									+ (refTexCur->dynarrRows[r][(c*4) +1] /3)
-									+ (refTexCur->dynarrRows[r][(c*4) +2] /3)
-								;
-								break;
-						}
+		numJobs = (pool != NULL) ? (numChars + GLYPHS_PER_JOB -1) / GLYPHS_PER_JOB : 1;
+		dynarrJobs = calloc_chk(numJobs, sizeof(sGlyphJob));
+		memset(&group, 0, sizeof(sTaskGroup));
+
+		for(i=0; i < numJobs; ++i){
+			dynarrJobs[i].refInfo = *itr;
+			dynarrJobs[i].refstrPrefix = strPrefix;
+			dynarrJobs[i].refCharcodes = dynarrCharcodes;
+			dynarrJobs[i].refIdxGlyphs = dynarrIdxGlyphs;
+			dynarrJobs[i].refResults = dynarrResults;
+			dynarrJobs[i].refOffsetY = dynarrOffsetY;
+			dynarrJobs[i].refMetrics = dynarrMetrics;
+			dynarrJobs[i].start = (pool != NULL) ? i * GLYPHS_PER_JOB : 0;
+			dynarrJobs[i].num = (pool != NULL && numChars - dynarrJobs[i].start > GLYPHS_PER_JOB) ? GLYPHS_PER_JOB : numChars - dynarrJobs[i].start;
+			getLogContext(&dynarrJobs[i].logContext);
+
+			if(pool != NULL)
+				submitTask(pool, &group, renderGlyphsTask, &dynarrJobs[i]);
+			else
+				renderGlyphsTask(&dynarrJobs[i]);
+		}
 
-						refTexCur->dynarrRows[r][(c*4)]    /= 255 -(*itr)->colour[0] +1;
-						refTexCur->dynarrRows[r][(c*4) +1] /= 255 -(*itr)->colour[1] +1;
-						refTexCur->dynarrRows[r][(c*4) +2] /= 255 -(*itr)->colour[2] +1;
-					}
+		if(pool != NULL)
+			waitTaskGroup(pool, &group);
 
-				}
+		/** Failed glyphs are dropped, and the rest go on the end in charmap order, no more than the font has. */
+		(*itr)->dynarrCharcodes = calloc_chk(face->num_glyphs, sizeof(unsigned int));
+		(*itr)->dynarrOffsetY = calloc_chk(face->num_glyphs, sizeof(unsigned int));
+		(*itr)->dynarrMetrics = calloc_chk(face->num_glyphs, sizeof(sGlyphMetrics));
+		dynarrLoadedIdx = calloc_chk(face->num_glyphs, sizeof(FT_UInt));
+		(*pDynarrOutTex) = realloc_chk((*pDynarrOutTex), (lenArrTex + face->num_glyphs +1) * sizeof(sTex*));
 
-				refTexCur->pngptrData = NULL;	/** these shouldn't matter at the moment because they aren't needed for copying onto the sprite. */
-				refTexCur->pngptrInfo = NULL;
-				refTexCur->colorType = 0;
+		lenCur = 0;
+		for(i=0; i < numChars; ++i){
+			if(dynarrResults[i] == NULL)
+				continue;
 
-				(*pDynarrOutTex)[lenOrig +lenCur] = refTexCur;
-				++lenCur;
+			if(lenCur >= (unsigned int)face->num_glyphs){
+				cleanupTex(dynarrResults[i]);
+				free(dynarrResults[i]);
+				continue;
 			}
 
-			FT_Done_Glyph(glyph);
+			(*itr)->dynarrCharcodes[lenCur] = dynarrCharcodes[i];
+			(*itr)->dynarrOffsetY[lenCur] = dynarrOffsetY[i];
+			(*itr)->dynarrMetrics[lenCur] = dynarrMetrics[i];
+			dynarrLoadedIdx[lenCur] = dynarrIdxGlyphs[i];
+			(*pDynarrOutTex)[lenArrTex + lenCur] = dynarrResults[i];
+			++lenCur;
+		}
 
-			continue;
+		lenArrTex += lenCur;
+		(*pDynarrOutTex)[lenArrTex] = NULL;
 
-		genTexFromFonts_failloop: ;
-			cleanupTex(refTexCur);
-			free(refTexCur);
-			WARN("Char %i failed", lenCur);
-		}
+		SAFE_DELETE(dynarrJobs);
+		SAFE_DELETE(dynarrCharcodes);
+		SAFE_DELETE(dynarrIdxGlyphs);
+		SAFE_DELETE(dynarrResults);
+		SAFE_DELETE(dynarrOffsetY);
+		SAFE_DELETE(dynarrMetrics);
 
 		if(lenCur > 0){
 			(*itr)->numLoaded = lenCur;
-			XTRA_LOG("Success with font: %s, with %i characters\n", (*itr)->strFile, lenCur);
-		}else{
-			WARN("No glyphs loaded from font %s", (*itr)->strFile);
+			genKerning(face, *itr, dynarrLoadedIdx);
+			if(cacheKey != 0)
+				saveGlyphCache(strCacheDir, cacheKey, *itr, &(*pDynarrOutTex)[lenArrTex - lenCur]);
+			XTRA_LOG("Success with font: %s, with %i characters and %u kerning pairs\n", (*itr)->strFile, lenCur, (*itr)->numKerning);
 		}
 
+		SAFE_DELETE(dynarrLoadedIdx);
+
 
 	genTexFromFonts_fail: ;
 
-		lenArrTex -= face->num_glyphs - lenCur;	/** trim bad characters */
 		FT_Done_Face(face);
 	}
 
+	FT_Done_FreeType(handFF);
 	return NOPROB;
 }
 
 errCode genFontFromInfo(const sFontInfo **refInfo, sFontList *pOutList, unsigned int startTexIdx){
-	unsigned int i, j;
+	unsigned int i, j, numFonts = 0;
 	sFont *refFnt;
 
 	if(refInfo == NULL || pOutList == NULL)
 		return ERROR;
 
-	for(i=0; refInfo[i] != NULL; ++i)
-		++pOutList->num;
+	for(i=0; refInfo[i] != NULL; ++i){
+		if(refInfo[i]->numLoaded > 0)
+			++numFonts;
+		else	/** Nothing to put on a sheet, or to find it by. */
+			WARN("Leaving out font %s, as none of its glyphs were loaded", refInfo[i]->strName);
+	}
 
-	pOutList->dynarrFonts = calloc_chk(pOutList->num, sizeof(sFont*));
+	if(numFonts == 0)
+		return NOPROB;
 
-	for(i=0; i < pOutList->num; ++i){
-		refFnt = pOutList->dynarrFonts[i] = malloc_chk(sizeof(sFont));
+	pOutList->dynarrFonts = calloc_chk(numFonts, sizeof(sFont*));
+
+	for(i=0; refInfo[i] != NULL; ++i){
+		if(refInfo[i]->numLoaded == 0)
+			continue;
+
+		refFnt = pOutList->dynarrFonts[pOutList->num++] = malloc_chk(sizeof(sFont));
 		memset(refFnt, 0, sizeof(sFont));
 		refFnt->num = refInfo[i]->numLoaded;
-		if(refFnt->num == 0)
-			continue;
+		refFnt->sdfSpread = refInfo[i]->sdfSpread;
+		memcpy(refFnt->colour, refInfo[i]->colour, sizeof(refFnt->colour));
 
 		refFnt->dynarrTexIDs = calloc_chk(refFnt->num, sizeof(unsigned int));
 		refFnt->dynarrCharcodes = calloc_chk(refFnt->num, sizeof(unsigned int));
@@ -295,6 +897,18 @@ errCode genFontFromInfo(const sFontInfo **refInfo, sFontList *pOutList, unsigned
 			refInfo[i]->dynarrOffsetY,
 			refFnt->num *sizeof(unsigned int)
 		);
+		refFnt->dynarrMetrics = calloc_chk(refFnt->num, sizeof(sGlyphMetrics));
+		memcpy(
+			refFnt->dynarrMetrics,
+			refInfo[i]->dynarrMetrics,
+			refFnt->num *sizeof(sGlyphMetrics)
+		);
+
+		refFnt->numKerning = refInfo[i]->numKerning;
+		if(refFnt->numKerning > 0){
+			refFnt->dynarrKerning = calloc_chk(refFnt->numKerning, sizeof(sKernPair));
+			memcpy(refFnt->dynarrKerning, refInfo[i]->dynarrKerning, refFnt->numKerning *sizeof(sKernPair));
+		}
 
 		for(j=0; j < refFnt->num; ++j){
 			refFnt->dynarrTexIDs[j] = startTexIdx;
@@ -305,6 +919,36 @@ errCode genFontFromInfo(const sFontInfo **refInfo, sFontList *pOutList, unsigned
 	return NOPROB;
 }
 
+errCode addFontTextures(
+	const char *strDir, const sFileList *refFiles, const char *strIgnores, sTex ***pDynarrTextures, sFontList *pOutList,
+	const char *strCacheDir, sThreadPool *pool
+){
+	sTex **dynarrFntTexs = NULL;
+	sFontInfo **dynarrFntIfo;
+	unsigned int startTexIdx = 0;
+
+	if(strDir == NULL || pDynarrTextures == NULL || pOutList == NULL)
+		return ERROR;
+
+	if(*pDynarrTextures != NULL){
+		while((*pDynarrTextures)[startTexIdx] != NULL)
+			++startTexIdx;
+	}
+
+	dynarrFntIfo = genFontInfos(strDir, refFiles, strIgnores);
+	if(dynarrFntIfo != NULL && genTexFromFonts(dynarrFntIfo, &dynarrFntTexs, pOutList, strCacheDir, pool) != NOPROB){
+		cleanupFontInfos(&dynarrFntIfo);
+		return PROBLEM;
+	}
+
+	appendTexArr(pDynarrTextures, dynarrFntTexs);
+	SAFE_DELETE(dynarrFntTexs);
+	genFontFromInfo((const sFontInfo **)dynarrFntIfo, pOutList, startTexIdx);
+	cleanupFontInfos(&dynarrFntIfo);
+
+	return NOPROB;
+}
+
 void cleanupFontInfos(sFontInfo ***pDynarrFonts){
 	if(pDynarrFonts == NULL || *pDynarrFonts == NULL)
 		return;
@@ -325,5 +969,9 @@ void cleanupFontInfo(sFontInfo *font){
 	SAFE_DELETE(font->strName);
 	SAFE_DELETE(font->strFile);
 	SAFE_DELETE(font->dynarrCharcodes);
+	SAFE_DELETE(font->dynarrOffsetY);
+	SAFE_DELETE(font->dynarrMetrics);
+	SAFE_DELETE(font->dynarrKerning);
+	cleanupListUint(&font->wanted);
 	free(font);
 }
@@ -27,19 +27,43 @@ typedef struct defFontInfo{
 	unsigned int size;
 	unsigned int numLoaded;
 	unsigned char colour[3];	/** 32 bit */
+	unsigned int sdfSpread;	/** Set by 'sdf=' to render a signed distance field instead, reaching this many pixels either side of the edge. */
+	sListUint wanted;	/** Codepoints to render, sorted, from 'chars=', 'ranges=' and 'charset='. Every glyph in the font if empty. */
 	unsigned int *dynarrCharcodes;
 	unsigned int *dynarrOffsetY;
+	sGlyphMetrics *dynarrMetrics;
+	sKernPair *dynarrKerning;	/** Only between glyphs that were loaded, by their place in dynarrCharcodes. */
+	unsigned int numKerning;
 } sFontInfo;
 
-	/** Generate info structure for each font info file found at provided path. Null terminated array. */
-sFontInfo** genFontInfos(const char *strPath, const char *strIgnores);
+	/** Generate info structure for each font info file found at provided path. Null terminated array.
+	 *  refFiles is what's already been read from the path, or null to read it now. */
+sFontInfo** genFontInfos(const char *strPath, const sFileList *refFiles, const char *strIgnores);
 
-	/** Generate a null terminated list of textures from the null terminated list of fonts. */
-errCode genTexFromFonts(sFontInfo **pDynarrFonts, sTex ***pDynarrOutTex, sFontList *pOutList);
+	/** Generate a null terminated list of textures from the null terminated list of fonts. With a pool, each font's
+	 *  glyphs are split into runs that are rendered at the same time, and they come out in the same order as without.
+	 *  With a cache directory, fonts rendered the same way before are loaded from it, and the rest are saved to it. */
+errCode genTexFromFonts(sFontInfo **pDynarrFonts, sTex ***pDynarrOutTex, sFontList *pOutList, const char *strCacheDir, sThreadPool *pool);
 
-	/** */
+	/** Renders every font described in the directory, and adds the glyphs to the end of the null terminated textures.
+	 *  refFiles is what's already been read from the directory, or null to read it now. The cache directory and the
+	 *  pool can be null. */
+errCode addFontTextures(
+	const char *strDir, const sFileList *refFiles, const char *strIgnores, sTex ***pDynarrTextures, sFontList *pOutList,
+	const char *strCacheDir, sThreadPool *pool
+);
+
+	/** Adds a font to the list for each info with glyphs loaded, numbering their glyphs on from startTexIdx. A font
+	 *  with none, because none of the characters asked for are in it, is left out with a warning. */
 errCode genFontFromInfo(const sFontInfo **refInfo, sFontList *pOutList, unsigned int startTexIdx);
 
+	/** Loads a font's glyphs from the cache, if they're there under that key, and adds them to the end of the null
+	 *  terminated textures, named with the prefix. Fills in what genTexFromFonts would have. PROBLEM on a miss. */
+errCode loadGlyphCache(const char *strCacheDir, unsigned long long key, const char *strPrefix, sFontInfo *refInfo, sTex ***pDynarrOutTex, unsigned int *pLenArrTex);
+
+	/** Saves the font's glyphs to the cache under the key. refarrTexs are the font's glyphs, one for each charcode. */
+errCode saveGlyphCache(const char *strCacheDir, unsigned long long key, const sFontInfo *refInfo, sTex * const *refarrTexs);
+
 void cleanupFontInfos(sFontInfo ***pDynarrFonts);
 
 void cleanupFontInfo(sFontInfo *font);
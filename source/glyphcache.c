@@ -0,0 +1,247 @@
+/*
+ *
+ *  Copyright (C) 2012 Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!\file	glyphcache.c
+ *!\brief	Keeps the glyphs of each font on disk once they're rendered, so the next run can map them in instead of
+ *!		rendering them again. Each font is one file in the cache directory, named after the key, which covers
+ *!		everything that changes how the glyphs come out. The glyphs loaded from it point straight into the mapping,
+ *!		which stays until the last of them is cleaned up.
+ */
+
+#include "font.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const uint32_t GLYPH_CACHE_MAGIC = 0x43474B54u;	/*!< "TKGC" when read as bytes, and the wrong way round on another machine. */
+static const uint32_t GLYPH_CACHE_VERSION = 1;
+static const char *GLYPH_CACHE_EXTENSION = ".glyphs";
+
+/*!\brief	The start of a cache file. The glyphs follow, then the kerning pairs, then the pixels of every glyph. */
+typedef struct defGlyphCacheHead{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;		/*!< The file name is made from it too, but a file can be copied. */
+	uint32_t numGlyphs;	/*!< How many glyphs the font has, not how many were kept. */
+	uint32_t numLoaded;
+	uint32_t numKerning;
+	uint32_t sizePixels;
+} sGlyphCacheHead;
+
+typedef struct defGlyphCacheGlyph{
+	uint32_t charcode;
+	uint32_t w, h;
+	uint32_t offsetY;
+	int32_t advance, bearingX, bearingY;
+} sGlyphCacheGlyph;
+
+typedef struct defGlyphCacheKern{
+	uint32_t left, right;
+	int32_t amount;
+} sGlyphCacheKern;
+
+static void makeGlyphCachePath(const char *strCacheDir, unsigned long long key, char *outBuff, size_t lenBuff){
+	snprintf(outBuff, lenBuff, "%s/%016llx%s", strCacheDir, key, GLYPH_CACHE_EXTENSION);
+}
+
+errCode loadGlyphCache(const char *strCacheDir, unsigned long long key, const char *strPrefix, sFontInfo *refInfo, sTex ***pDynarrOutTex, unsigned int *pLenArrTex){
+	static const size_t MAX_STRBUFF = 256;
+
+	char strPath[512], strName[MAX_STRBUFF];
+	const unsigned char *refFile;
+	const sGlyphCacheHead *refHead;
+	const sGlyphCacheGlyph *refGlyphs;
+	const sGlyphCacheKern *refKerns;
+	const unsigned char *refPixels;
+	sMappedPixels *refMapped;
+	struct stat info;
+	size_t sizeTables, posPixel;
+	sTex *refTex;
+	unsigned int i, r;
+	int fd;
+
+	if(strCacheDir == NULL || refInfo == NULL || pDynarrOutTex == NULL || pLenArrTex == NULL)
+		return ERROR;
+
+	makeGlyphCachePath(strCacheDir, key, strPath, sizeof(strPath));
+	fd = open(strPath, O_RDONLY);
+	if(fd < 0)
+		return PROBLEM;
+
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(sGlyphCacheHead)){
+		close(fd);
+		return PROBLEM;
+	}
+
+	refFile = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	/** The mapping keeps it open. */
+	if(refFile == MAP_FAILED)
+		return PROBLEM;
+
+	/** Anything that doesn't add up is treated as a miss, and written again after rendering. */
+	refHead = (const sGlyphCacheHead*)refFile;
+	sizeTables = sizeof(sGlyphCacheHead) + ((size_t)refHead->numLoaded * sizeof(sGlyphCacheGlyph)) + ((size_t)refHead->numKerning * sizeof(sGlyphCacheKern));
+	if(refHead->magic != GLYPH_CACHE_MAGIC || refHead->version != GLYPH_CACHE_VERSION || refHead->key != key
+		|| refHead->numLoaded == 0 || sizeTables + refHead->sizePixels != (size_t)info.st_size
+	){
+		munmap((void*)refFile, (size_t)info.st_size);
+		return PROBLEM;
+	}
+
+	refGlyphs = (const sGlyphCacheGlyph*)(refFile + sizeof(sGlyphCacheHead));
+	refKerns = (const sGlyphCacheKern*)(refGlyphs + refHead->numLoaded);
+	refPixels = refFile + sizeTables;
+
+	for(i=0, posPixel=0; i < refHead->numLoaded; ++i)
+		posPixel += (size_t)refGlyphs[i].w * refGlyphs[i].h;
+
+	if(posPixel != refHead->sizePixels){
+		munmap((void*)refFile, (size_t)info.st_size);
+		return PROBLEM;
+	}
+
+	refInfo->numGlyphs = refHead->numGlyphs;
+	refInfo->numLoaded = refHead->numLoaded;
+	refInfo->dynarrCharcodes = calloc_chk(refHead->numLoaded, sizeof(unsigned int));
+	refInfo->dynarrOffsetY = calloc_chk(refHead->numLoaded, sizeof(unsigned int));
+	refInfo->dynarrMetrics = calloc_chk(refHead->numLoaded, sizeof(sGlyphMetrics));
+	(*pDynarrOutTex) = realloc_chk((*pDynarrOutTex), (*pLenArrTex + refHead->numLoaded +1) * sizeof(sTex*));
+
+	refMapped = malloc_chk(sizeof(sMappedPixels));
+	refMapped->addr = (void*)refFile;
+	refMapped->size = (size_t)info.st_size;
+	refMapped->numTexs = refHead->numLoaded;
+
+	/** The rows point into the mapping, which is only ever read from, so it's fine to drop the const. */
+	for(i=0, posPixel=0; i < refHead->numLoaded; ++i){
+		refInfo->dynarrCharcodes[i] = refGlyphs[i].charcode;
+		refInfo->dynarrOffsetY[i] = refGlyphs[i].offsetY;
+		refInfo->dynarrMetrics[i].advance = refGlyphs[i].advance;
+		refInfo->dynarrMetrics[i].bearingX = refGlyphs[i].bearingX;
+		refInfo->dynarrMetrics[i].bearingY = refGlyphs[i].bearingY;
+
+		refTex = malloc_chk(sizeof(sTex));
+		memset(refTex, 0, sizeof(sTex));
+
+		snprintf(strName, MAX_STRBUFF, "%s%u", strPrefix, refGlyphs[i].charcode);
+		copyString(&refTex->name, strName);
+
+		refTex->w = refGlyphs[i].w;
+		refTex->h = refGlyphs[i].h;
+		refTex->colorType = PNG_COLOR_TYPE_GRAY;
+		refTex->sharedRows = TRUE;
+		refTex->refMapped = refMapped;
+		refTex->dynarrRows = calloc_chk(refTex->h, sizeof(png_byte*));
+		for(r=0; r < refTex->h; ++r)
+			refTex->dynarrRows[r] = (png_byte*)&refPixels[posPixel + (size_t)r * refTex->w];
+
+		posPixel += (size_t)refTex->w * refTex->h;
+		(*pDynarrOutTex)[(*pLenArrTex)++] = refTex;
+	}
+	(*pDynarrOutTex)[*pLenArrTex] = NULL;
+
+	refInfo->numKerning = refHead->numKerning;
+	if(refInfo->numKerning > 0){
+		refInfo->dynarrKerning = calloc_chk(refInfo->numKerning, sizeof(sKernPair));
+		for(i=0; i < refInfo->numKerning; ++i){
+			refInfo->dynarrKerning[i].left = refKerns[i].left;
+			refInfo->dynarrKerning[i].right = refKerns[i].right;
+			refInfo->dynarrKerning[i].amount = refKerns[i].amount;
+		}
+	}
+
+	return NOPROB;
+}
+
+errCode saveGlyphCache(const char *strCacheDir, unsigned long long key, const sFontInfo *refInfo, sTex * const *refarrTexs){
+	char strPath[512], strTemp[520];
+	sGlyphCacheHead head;	memset(&head, 0, sizeof(sGlyphCacheHead));
+	sGlyphCacheGlyph glyph;
+	sGlyphCacheKern kern;
+	FILE *handFile;
+	unsigned int i, r;
+	bool failed;
+	int fd;
+
+	if(strCacheDir == NULL || refInfo == NULL || refarrTexs == NULL)
+		return ERROR;
+
+	head.magic = GLYPH_CACHE_MAGIC;
+	head.version = GLYPH_CACHE_VERSION;
+	head.key = key;
+	head.numGlyphs = refInfo->numGlyphs;
+	head.numLoaded = refInfo->numLoaded;
+	head.numKerning = refInfo->numKerning;
+	for(i=0; i < refInfo->numLoaded; ++i)
+		head.sizePixels += refarrTexs[i]->w * refarrTexs[i]->h;
+
+	mkdir(strCacheDir, 0777);	/** Fails harmlessly if it's already there. */
+
+	/** Written to the side and moved into place, so another run never maps half a file. */
+	makeGlyphCachePath(strCacheDir, key, strPath, sizeof(strPath));
+	snprintf(strTemp, sizeof(strTemp), "%s.XXXXXX", strPath);
+	fd = mkstemp(strTemp);
+	if(fd < 0 || (handFile = fdopen(fd, "wb")) == NULL){
+		WARN("Unable to write to the glyph cache in %s", strCacheDir);
+		if(fd >= 0){
+			close(fd);
+			unlink(strTemp);
+		}
+		return PROBLEM;
+	}
+
+	fwrite(&head, sizeof(sGlyphCacheHead), 1, handFile);
+
+	for(i=0; i < refInfo->numLoaded; ++i){
+		glyph.charcode = refInfo->dynarrCharcodes[i];
+		glyph.w = refarrTexs[i]->w;
+		glyph.h = refarrTexs[i]->h;
+		glyph.offsetY = refInfo->dynarrOffsetY[i];
+		glyph.advance = refInfo->dynarrMetrics[i].advance;
+		glyph.bearingX = refInfo->dynarrMetrics[i].bearingX;
+		glyph.bearingY = refInfo->dynarrMetrics[i].bearingY;
+		fwrite(&glyph, sizeof(sGlyphCacheGlyph), 1, handFile);
+	}
+
+	for(i=0; i < refInfo->numKerning; ++i){
+		kern.left = refInfo->dynarrKerning[i].left;
+		kern.right = refInfo->dynarrKerning[i].right;
+		kern.amount = refInfo->dynarrKerning[i].amount;
+		fwrite(&kern, sizeof(sGlyphCacheKern), 1, handFile);
+	}
+
+	for(i=0; i < refInfo->numLoaded; ++i){
+		for(r=0; r < refarrTexs[i]->h; ++r)
+			fwrite(refarrTexs[i]->dynarrRows[r], 1, refarrTexs[i]->w, handFile);
+	}
+
+	failed = (ferror(handFile) != 0) ? TRUE : FALSE;
+	if(fclose(handFile) != 0)
+		failed = TRUE;
+
+	if(failed == TRUE || rename(strTemp, strPath) != 0){
+		WARN("Unable to write to the glyph cache in %s", strCacheDir);
+		unlink(strTemp);
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
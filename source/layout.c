@@ -0,0 +1,356 @@
+/*
+ *  Copyright (C) 2011  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!\file	layout.c
+ *!\brief	Reads and writes the layout file, which remembers where every texture went so the next run can leave it there.
+ */
+
+#include "texturepacker.h"
+
+static const char *LAYOUT_HEAD_VERSION = "layout_version=";
+static const char *LAYOUT_HEAD_SHEETS = "sheet_count=";
+static const char *LAYOUT_HEAD_TEXTURES = "texture_count=";
+static const unsigned int LAYOUT_VERSION = 2;	/*!< Version 1 didn't have the rotated column, and is still read. */
+
+static int compareLayoutEntries(const void *a, const void *b){
+	return strcmp(
+		((const sLayoutEntry*)a)->name,
+		((const sLayoutEntry*)b)->name
+	);
+}
+
+/*!\brief	The space an entry takes up on its sheet, which is turned if the texture was. */
+typedef struct defLayoutSpot{
+	unsigned int sheet;
+	unsigned int x, y, w, h;
+} sLayoutSpot;
+
+static int compareLayoutSpots(const void *a, const void *b){
+	const sLayoutSpot *refA = (const sLayoutSpot*)a;
+	const sLayoutSpot *refB = (const sLayoutSpot*)b;
+
+	if(refA->sheet != refB->sheet)
+		return (refA->sheet > refB->sheet) - (refA->sheet < refB->sheet);
+
+	return (refA->y > refB->y) - (refA->y < refB->y);
+}
+
+/*!\brief	Makes sure every entry is on its sheet, each sheet has as many entries as it says, and nothing overlaps.
+ *			Anything else would have the next pack draw textures over each other, or off the edge of the sheet.
+ */
+static bool checkLayout(const sLayout *refLayout){
+	sLayoutSpot *dynarrSpots;
+	const sLayoutEntry *refEntry;
+	const sLayoutSheet *refSheet;
+	unsigned int *dynarrCounts;
+	unsigned int i, j;
+	bool good = TRUE;
+
+	if(refLayout->num == 0)
+		return TRUE;
+
+	dynarrSpots = calloc_chk(refLayout->num, sizeof(sLayoutSpot));
+	dynarrCounts = calloc_chk(refLayout->numSheets +1, sizeof(unsigned int));
+
+	for(i=0; i < refLayout->num && good == TRUE; ++i){
+		refEntry = &refLayout->dynarrEntries[i];
+		refSheet = &refLayout->dynarrSheets[refEntry->sheet];
+
+		dynarrSpots[i].sheet = refEntry->sheet;
+		dynarrSpots[i].x = refEntry->x;
+		dynarrSpots[i].y = refEntry->y;
+		dynarrSpots[i].w = (refEntry->rotated == TRUE) ? refEntry->h : refEntry->w;
+		dynarrSpots[i].h = (refEntry->rotated == TRUE) ? refEntry->w : refEntry->h;
+		++dynarrCounts[refEntry->sheet];
+
+		if(	dynarrSpots[i].w == 0 || dynarrSpots[i].h == 0
+			|| dynarrSpots[i].x > refSheet->w || dynarrSpots[i].w > refSheet->w - dynarrSpots[i].x
+			|| dynarrSpots[i].y > refSheet->h || dynarrSpots[i].h > refSheet->h - dynarrSpots[i].y
+		){
+			WARN("%s is off the edge of sheet %u", refEntry->name, refEntry->sheet);
+			good = FALSE;
+		}
+	}
+
+	for(i=0; i < refLayout->numSheets && good == TRUE; ++i){
+		if(dynarrCounts[i] != refLayout->dynarrSheets[i].num){
+			WARN("Sheet %u has %u textures, not the %u it says", i, dynarrCounts[i], refLayout->dynarrSheets[i].num);
+			good = FALSE;
+		}
+	}
+
+	if(good == TRUE){	/** Top to bottom, so each one only needs checking against those that start above its bottom. */
+		qsort(dynarrSpots, refLayout->num, sizeof(sLayoutSpot), compareLayoutSpots);
+
+		for(i=0; i < refLayout->num && good == TRUE; ++i){
+			for(j=i +1; j < refLayout->num && good == TRUE; ++j){
+				if(dynarrSpots[j].sheet != dynarrSpots[i].sheet || dynarrSpots[j].y >= dynarrSpots[i].y + dynarrSpots[i].h)
+					break;
+
+				if(dynarrSpots[j].x < dynarrSpots[i].x + dynarrSpots[i].w && dynarrSpots[i].x < dynarrSpots[j].x + dynarrSpots[j].w){
+					WARN("Two textures overlap at %u,%u on sheet %u", dynarrSpots[j].x, dynarrSpots[j].y, dynarrSpots[j].sheet);
+					good = FALSE;
+				}
+			}
+		}
+	}
+
+	SAFE_DELETE(dynarrCounts);
+	SAFE_DELETE(dynarrSpots);
+	return good;
+}
+
+/*!\brief	Reads a line of the form 'head=value'. Returns FALSE if the line doesn't start with the head. */
+static bool readLayoutHead(FILE *handFile, const char *strHead, unsigned int *outValue){
+	char buff[64];
+	size_t lenHead = strlen(strHead);
+
+	if(fgets(buff, sizeof(buff), handFile) == NULL)
+		return FALSE;
+
+	if(strncmp(buff, strHead, lenHead) != 0)
+		return FALSE;
+
+	*outValue = (unsigned int)strtoul(&buff[lenHead], NULL, 10);
+	return TRUE;
+}
+
+errCode readLayout(const char *strFile, sLayout *outLayout){
+	static const size_t LENBUFF = 512;
+
+	char buff[LENBUFF];
+	char *refName;
+	unsigned int version, i, comma, numFields, rotated;
+	sLayoutEntry *refEntry;
+	FILE *handFile;
+
+	if(strFile == NULL || outLayout == NULL)
+		return ERROR;
+
+	memset(outLayout, 0, sizeof(sLayout));
+
+	handFile = fopen(strFile, "r");
+	if(handFile == NULL)
+		return PROBLEM;
+
+	if(readLayoutHead(handFile, LAYOUT_HEAD_VERSION, &version) == FALSE || version < 1 || version > LAYOUT_VERSION){
+		WARN("Layout %s is an unknown version, ignoring it.", strFile);
+		goto readLayout_fail;
+	}
+
+	if(readLayoutHead(handFile, LAYOUT_HEAD_SHEETS, &outLayout->numSheets) == FALSE)
+		goto readLayout_fail;
+
+	if(outLayout->numSheets > 0)
+		outLayout->dynarrSheets = calloc_chk(outLayout->numSheets, sizeof(sLayoutSheet));
+
+	for(i=0; i < outLayout->numSheets; ++i){
+		if(fgets(buff, LENBUFF, handFile) == NULL)
+			goto readLayout_fail;
+
+		if(sscanf(buff, "%u,%u,%u",
+			&outLayout->dynarrSheets[i].w,
+			&outLayout->dynarrSheets[i].h,
+			&outLayout->dynarrSheets[i].num
+		) != 3)
+			goto readLayout_fail;
+	}
+
+	if(readLayoutHead(handFile, LAYOUT_HEAD_TEXTURES, &outLayout->num) == FALSE)
+		goto readLayout_fail;
+
+	if(outLayout->num > 0)
+		outLayout->dynarrEntries = calloc_chk(outLayout->num, sizeof(sLayoutEntry));
+
+	for(i=0; i < outLayout->num; ++i){
+		refEntry = &outLayout->dynarrEntries[i];
+
+		if(fgets(buff, LENBUFF, handFile) == NULL)
+			goto readLayout_fail;
+
+		rotated = 0;
+		if(version == 1){
+			numFields = 6;
+			if(sscanf(buff, "%u,%u,%u,%u,%u,%x,",
+				&refEntry->sheet, &refEntry->x, &refEntry->y, &refEntry->w, &refEntry->h, &refEntry->hash
+			) != 6)
+				goto readLayout_fail;
+		}else{
+			numFields = 7;
+			if(sscanf(buff, "%u,%u,%u,%u,%u,%u,%x,",
+				&refEntry->sheet, &refEntry->x, &refEntry->y, &refEntry->w, &refEntry->h, &rotated, &refEntry->hash
+			) != 7)
+				goto readLayout_fail;
+		}
+		refEntry->rotated = (rotated != 0) ? TRUE : FALSE;
+
+		refName = buff;	/** The name goes last, because it can hold commas. */
+		for(comma=0; comma < numFields && refName != NULL; ++comma){
+			refName = strchr(refName, ',');
+			if(refName != NULL)
+				++refName;
+		}
+
+		if(refName == NULL || refEntry->sheet >= outLayout->numSheets)
+			goto readLayout_fail;
+
+		refName[strcspn(refName, "\r\n")] = '\0';
+		copyString(&refEntry->name, refName);
+	}
+
+	fclose(handFile);
+	handFile = NULL;
+
+	if(checkLayout(outLayout) == FALSE)
+		goto readLayout_fail;
+
+	if(outLayout->num > 0)
+		qsort(outLayout->dynarrEntries, outLayout->num, sizeof(sLayoutEntry), compareLayoutEntries);
+
+	return NOPROB;
+
+readLayout_fail:
+	WARN("Unable to read layout %s", strFile);
+	if(handFile != NULL)
+		fclose(handFile);
+	cleanupLayout(outLayout);
+	return PROBLEM;
+}
+
+errCode writeLayout(const char *strFile, const sSheetList *refSheets, const sTex **refarrTexs){
+	unsigned int s, t, numTexs;
+	sSheet const *refSheet;
+	sTex const *refTex;
+	FILE *handFile;
+
+	if(strFile == NULL || refSheets == NULL || refarrTexs == NULL)
+		return ERROR;
+
+	handFile = fopen(strFile, "w");
+	if(handFile == NULL){
+		WARN("Unable to write layout %s", strFile);
+		return PROBLEM;
+	}
+
+	numTexs = 0;
+	fprintf(handFile, "%s%u\n", LAYOUT_HEAD_VERSION, LAYOUT_VERSION);
+	fprintf(handFile, "%s%u\n", LAYOUT_HEAD_SHEETS, refSheets->num);
+	for(s=0; s < refSheets->num; ++s){
+		refSheet = refSheets->dynarrSheets[s];
+		fprintf(handFile, "%u,%u,%u\n", refSheet->w, refSheet->h, refSheet->num);
+		numTexs += refSheet->num;
+	}
+
+	fprintf(handFile, "%s%u\n", LAYOUT_HEAD_TEXTURES, numTexs);
+	for(s=0; s < refSheets->num; ++s){
+		refSheet = refSheets->dynarrSheets[s];
+		for(t=0; t < refSheet->num; ++t){
+			refTex = refarrTexs[ refSheet->dynarrTexIDs[t] ];
+			fprintf(handFile, "%u,%u,%u,%u,%u,%u,%08x,%s\n",
+				s,
+				refTex->x, refTex->y,
+				refTex->w, refTex->h,
+				(refTex->rotated == TRUE) ? 1 : 0,
+				hashTex(refTex),
+				refTex->name
+			);
+		}
+	}
+
+	fclose(handFile);
+	return NOPROB;
+}
+
+errCode genLayout(const sSheetList *refSheets, const sTex **refarrTexs, sLayout *outLayout){
+	unsigned int s, t;
+	sSheet const *refSheet;
+	sTex const *refTex;
+	sLayoutEntry *refEntry;
+
+	if(refSheets == NULL || refarrTexs == NULL || outLayout == NULL)
+		return ERROR;
+
+	memset(outLayout, 0, sizeof(sLayout));
+
+	outLayout->numSheets = refSheets->num;
+	if(outLayout->numSheets > 0)
+		outLayout->dynarrSheets = calloc_chk(outLayout->numSheets, sizeof(sLayoutSheet));
+
+	for(s=0; s < refSheets->num; ++s){
+		refSheet = refSheets->dynarrSheets[s];
+		outLayout->dynarrSheets[s].w = refSheet->w;
+		outLayout->dynarrSheets[s].h = refSheet->h;
+		outLayout->dynarrSheets[s].num = refSheet->num;
+		outLayout->num += refSheet->num;
+	}
+
+	if(outLayout->num > 0)
+		outLayout->dynarrEntries = calloc_chk(outLayout->num, sizeof(sLayoutEntry));
+
+	refEntry = outLayout->dynarrEntries;
+	for(s=0; s < refSheets->num; ++s){
+		refSheet = refSheets->dynarrSheets[s];
+		for(t=0; t < refSheet->num; ++t){
+			refTex = refarrTexs[ refSheet->dynarrTexIDs[t] ];
+			refEntry->sheet = s;
+			refEntry->x = refTex->x;
+			refEntry->y = refTex->y;
+			refEntry->w = refTex->w;
+			refEntry->h = refTex->h;
+			refEntry->rotated = refTex->rotated;
+			refEntry->hash = hashTex(refTex);
+			copyString(&refEntry->name, refTex->name);
+			++refEntry;
+		}
+	}
+
+	if(outLayout->num > 0)
+		qsort(outLayout->dynarrEntries, outLayout->num, sizeof(sLayoutEntry), compareLayoutEntries);
+
+	return NOPROB;
+}
+
+int findLayoutEntry(const sLayout *refLayout, const char *strName){
+	sLayoutEntry key;
+	sLayoutEntry const *found;
+
+	if(refLayout == NULL || strName == NULL || refLayout->num == 0)
+		return -1;
+
+	key.name = (char*)strName;
+	found = bsearch(&key, refLayout->dynarrEntries, refLayout->num, sizeof(sLayoutEntry), compareLayoutEntries);
+	if(found == NULL)
+		return -1;
+
+	while(found > refLayout->dynarrEntries && strcmp((found -1)->name, strName) == 0)	/** Names can repeat, so start from the first. */
+		--found;
+
+	return (int)(found - refLayout->dynarrEntries);
+}
+
+void cleanupLayout(sLayout *layout){
+	if(layout == NULL)
+		return;
+
+	unsigned int i;
+	for(i=0; layout->dynarrEntries != NULL && i < layout->num; ++i)
+		SAFE_DELETE(layout->dynarrEntries[i].name);
+
+	SAFE_DELETE(layout->dynarrEntries);
+	SAFE_DELETE(layout->dynarrSheets);
+	memset(layout, 0, sizeof(sLayout));
+}
@@ -0,0 +1,443 @@
+/*
+ *
+ *  Copyright (C) 2012 Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!\file	log.c
+ *!\brief	Each thread logs into its own ring of records, which only it writes to and only the flusher thread reads
+ *!		from, so logging never waits on a lock. The flusher prints lines without a package straight away, and holds
+ *!		the rest until their package ends, so each package's lines come out together.
+ */
+
+#include "log.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <sched.h>
+#include <time.h>
+
+#define LOG_RING_LEN 128
+#define LOG_LINE_LEN 512
+
+static const long FLUSH_INTERVAL_MS = 20;	/*!< Longest a line waits before the flusher looks for it. */
+
+typedef struct defLogRecord{
+	unsigned int idPackage;
+	unsigned int seq;	/*!< Order it was logged in, across every thread. */
+	bool endPackage;	/*!< Marks the end of the package, rather than a line. */
+	char text[LOG_LINE_LEN];
+} sLogRecord;
+
+/*!\brief	Records from one thread, waiting for the flusher. */
+typedef struct defLogRing{
+	sLogRecord arrRecords[LOG_RING_LEN];
+	unsigned int head;	/*!< Next record the flusher reads. Only the flusher changes it. */
+	unsigned int tail;	/*!< Next record the owner writes. Only the owner changes it. */
+	int owned;		/*!< Set while a thread logs to it. The rings of finished threads are given to new ones. */
+	struct defLogRing *next;
+} sLogRing;
+
+/*!\brief	Where a line is in its batch. */
+typedef struct defLogLine{
+	unsigned int seq;
+	size_t start, len;
+} sLogLine;
+
+/*!\brief	Lines about a package, held until it ends. They come from different rings, so they're put back in order
+ *!		before they're printed.
+ */
+typedef struct defLogBatch{
+	unsigned int idPackage;
+	char *data;	/*!< Cleanup. */
+	size_t len, cap;
+	sLogLine *dynarrLines;	/*!< Cleanup. */
+	unsigned int numLines, capLines;
+	bool ended;
+} sLogBatch;
+
+typedef struct defLogger{
+	sLogRing *rings;	/*!< Only ever added to, so the flusher can walk it without a lock. Kept until exit. */
+	pthread_key_t keyRing;	/*!< Gives the ring back when its thread finishes. */
+	pthread_t thread;
+	pthread_mutex_t lockWake;
+	pthread_cond_t wake;
+	int running;
+	int stop;		/*!< Guarded by lockWake. */
+	eLogLevel minLevel;
+	unsigned int lastPackage;
+	unsigned int lastSeq;
+	sLogBatch *dynarrBatches;	/*!< Only the flusher touches these. Cleanup. */
+	unsigned int numBatches;
+} sLogger;
+
+static sLogger gLogger = {
+	.lockWake = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.minLevel = eLogDebug
+};
+
+static __thread sLogRing *gRing = NULL;
+static __thread sLogContext gContext = { 0, NULL };
+
+static bool isLogging(void){
+	return (__atomic_load_n(&gLogger.running, __ATOMIC_ACQUIRE) != 0) ? TRUE : FALSE;
+}
+
+static void wakeFlusher(void){
+	pthread_cond_signal(&gLogger.wake);
+}
+
+static void releaseRing(void *data){
+	__atomic_store_n(&((sLogRing*)data)->owned, 0, __ATOMIC_RELEASE);
+}
+
+/*!\brief	Finds this thread's ring, taking a spare one or adding a new one the first time it logs. */
+static sLogRing* ownRing(void){
+	sLogRing *ring;
+	int expect;
+
+	if(gRing != NULL)
+		return gRing;
+
+	for(ring = __atomic_load_n(&gLogger.rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next){
+		expect = 0;
+		if(__atomic_compare_exchange_n(&ring->owned, &expect, 1, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			break;
+	}
+
+	if(ring == NULL){
+		ring = calloc_chk(1, sizeof(sLogRing));
+		ring->owned = 1;
+		ring->next = __atomic_load_n(&gLogger.rings, __ATOMIC_RELAXED);
+		while(!__atomic_compare_exchange_n(&gLogger.rings, &ring->next, ring, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+
+	pthread_setspecific(gLogger.keyRing, ring);
+	gRing = ring;
+	return ring;
+}
+
+/*!\brief	Gets the next free record in this thread's ring, waiting for the flusher if the ring is full.
+ *!\param	fallback	Used instead when the logger isn't running.
+ */
+static sLogRecord* reserveRecord(sLogRecord *fallback){
+	sLogRing *ring;
+
+	if(isLogging() == FALSE)
+		return fallback;
+
+	ring = ownRing();
+	while(ring->tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >= LOG_RING_LEN){
+		wakeFlusher();
+		sched_yield();
+	}
+
+	return &ring->arrRecords[ring->tail % LOG_RING_LEN];
+}
+
+/*!\brief	Hands the record to the flusher, or prints it if it's the fallback. */
+static void commitRecord(sLogRecord *rec, const sLogRecord *fallback){
+	rec->seq = __atomic_add_fetch(&gLogger.lastSeq, 1, __ATOMIC_RELAXED);
+
+	if(rec == fallback){
+		if(rec->endPackage == FALSE)
+			fputs(rec->text, stdout);
+		return;
+	}
+
+	__atomic_store_n(&gRing->tail, gRing->tail +1, __ATOMIC_RELEASE);
+}
+
+static sLogBatch* findBatch(unsigned int idPackage){
+	unsigned int i;
+	sLogBatch *refBatch;
+
+	for(i=0; i < gLogger.numBatches; ++i){
+		if(gLogger.dynarrBatches[i].idPackage == idPackage)
+			return &gLogger.dynarrBatches[i];
+	}
+
+	++gLogger.numBatches;
+	gLogger.dynarrBatches = realloc_chk(gLogger.dynarrBatches, gLogger.numBatches * sizeof(sLogBatch));
+	refBatch = &gLogger.dynarrBatches[gLogger.numBatches -1];
+	memset(refBatch, 0, sizeof(sLogBatch));
+	refBatch->idPackage = idPackage;
+	return refBatch;
+}
+
+/*!\return	TRUE if the record ended a package. */
+static bool takeRecord(const sLogRecord *rec){
+	sLogBatch *refBatch;
+	size_t len;
+
+	if(rec->idPackage == 0){
+		fputs(rec->text, stdout);
+		return FALSE;
+	}
+
+	refBatch = findBatch(rec->idPackage);
+	if(rec->endPackage == TRUE){
+		refBatch->ended = TRUE;
+		return TRUE;
+	}
+
+	len = strlen(rec->text);
+	if(refBatch->len + len > refBatch->cap){
+		refBatch->cap = (refBatch->cap + len) * 2;
+		refBatch->data = realloc_chk(refBatch->data, refBatch->cap);
+	}
+
+	if(refBatch->numLines == refBatch->capLines){
+		refBatch->capLines = (refBatch->capLines == 0) ? 16 : refBatch->capLines * 2;
+		refBatch->dynarrLines = realloc_chk(refBatch->dynarrLines, refBatch->capLines * sizeof(sLogLine));
+	}
+
+	refBatch->dynarrLines[refBatch->numLines].seq = rec->seq;
+	refBatch->dynarrLines[refBatch->numLines].start = refBatch->len;
+	refBatch->dynarrLines[refBatch->numLines].len = len;
+	++refBatch->numLines;
+
+	memcpy(&refBatch->data[refBatch->len], rec->text, len);
+	refBatch->len += len;
+	return FALSE;
+}
+
+/*!\brief	Takes every record that's waiting in the rings.
+ *!\return	TRUE if any of them ended a package.
+ */
+static bool drainRings(void){
+	sLogRing *ring;
+	unsigned int head, tail;
+	bool ended = FALSE;
+
+	for(ring = __atomic_load_n(&gLogger.rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next){
+		head = ring->head;
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+		for(; head != tail; ++head){
+			if(takeRecord(&ring->arrRecords[head % LOG_RING_LEN]) == TRUE)
+				ended = TRUE;
+		}
+
+		__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+	}
+
+	return ended;
+}
+
+static int compareLogLines(const void *a, const void *b){
+	const unsigned int seqA = ((const sLogLine*)a)->seq;
+	const unsigned int seqB = ((const sLogLine*)b)->seq;
+	return (seqA > seqB) - (seqA < seqB);
+}
+
+/*!\brief	Prints the batches of packages that have ended, or all of them. */
+static void printBatches(bool all){
+	unsigned int i, l, numKept = 0;
+	sLogBatch *refBatch;
+
+	for(i=0; i < gLogger.numBatches; ++i){
+		refBatch = &gLogger.dynarrBatches[i];
+
+		if(all == FALSE && refBatch->ended == FALSE){
+			gLogger.dynarrBatches[numKept++] = *refBatch;
+			continue;
+		}
+
+		if(refBatch->numLines > 0)
+			qsort(refBatch->dynarrLines, refBatch->numLines, sizeof(sLogLine), compareLogLines);
+
+		for(l=0; l < refBatch->numLines; ++l)
+			fwrite(&refBatch->data[refBatch->dynarrLines[l].start], sizeof(char), refBatch->dynarrLines[l].len, stdout);
+
+		SAFE_DELETE(refBatch->data);
+		SAFE_DELETE(refBatch->dynarrLines);
+	}
+
+	gLogger.numBatches = numKept;
+	if(numKept == 0)
+		SAFE_DELETE(gLogger.dynarrBatches);
+}
+
+/*!\brief	Drains the rings, then prints the packages that ended. The lines from other threads about a package were
+ *!		logged before its end, but might sit in a ring we'd already passed, so we go round again until a pass
+ *!		doesn't end anything.
+ */
+static void flushLog(bool all){
+	while(drainRings() == TRUE)
+		;
+
+	printBatches(all);
+	fflush(stdout);
+}
+
+static void* flusherMain(void *data){
+	struct timespec until;
+	int stop;
+
+	for(;;){
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += FLUSH_INTERVAL_MS * 1000000L;
+		if(until.tv_nsec >= 1000000000L){
+			until.tv_nsec -= 1000000000L;
+			++until.tv_sec;
+		}
+
+		pthread_mutex_lock(&gLogger.lockWake);
+		if(gLogger.stop == 0)
+			pthread_cond_timedwait(&gLogger.wake, &gLogger.lockWake, &until);
+		stop = gLogger.stop;
+		pthread_mutex_unlock(&gLogger.lockWake);
+
+		if(stop != 0)
+			break;
+
+		flushLog(FALSE);
+	}
+
+	flushLog(TRUE);
+	return NULL;
+}
+
+errCode startLogger(eLogLevel minLevel){
+	static bool registered = FALSE;
+
+	if(isLogging() == TRUE)
+		return NOPROB;
+
+	gLogger.minLevel = minLevel;
+	gLogger.stop = 0;
+
+	if(registered == FALSE){
+		if(pthread_key_create(&gLogger.keyRing, releaseRing) != 0)
+			return PROBLEM;
+
+		atexit(stopLogger);
+		registered = TRUE;
+	}
+
+	__atomic_store_n(&gLogger.running, 1, __ATOMIC_RELEASE);
+	if(pthread_create(&gLogger.thread, NULL, flusherMain, NULL) != 0){
+		__atomic_store_n(&gLogger.running, 0, __ATOMIC_RELEASE);
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
+
+void stopLogger(void){
+	if(isLogging() == FALSE)
+		return;
+
+	pthread_mutex_lock(&gLogger.lockWake);
+	gLogger.stop = 1;
+	pthread_cond_signal(&gLogger.wake);
+	pthread_mutex_unlock(&gLogger.lockWake);
+
+	pthread_join(gLogger.thread, NULL);
+	__atomic_store_n(&gLogger.running, 0, __ATOMIC_RELEASE);
+}
+
+unsigned int startLogPackage(void){
+	return __atomic_add_fetch(&gLogger.lastPackage, 1, __ATOMIC_RELAXED);
+}
+
+void endLogPackage(unsigned int idPackage){
+	sLogRecord fallback;
+	sLogRecord *rec = reserveRecord(&fallback);
+
+	rec->idPackage = idPackage;
+	rec->endPackage = TRUE;
+	rec->text[0] = '\0';
+	commitRecord(rec, &fallback);
+	wakeFlusher();
+}
+
+void getLogContext(sLogContext *outContext){
+	*outContext = gContext;
+}
+
+void setLogContext(const sLogContext *refContext){
+	if(refContext != NULL){
+		gContext = *refContext;
+	}else{
+		gContext.idPackage = 0;
+		gContext.refstrFile = NULL;
+	}
+}
+
+void logLine(eLogLevel level, const char *strSrcFile, int srcLine, const char *format, ...){
+	char buffMsg[LOG_LINE_LEN];
+	const char *refstrFile = (gContext.refstrFile != NULL) ? gContext.refstrFile : "";
+	const char *refstrSep = (gContext.refstrFile != NULL) ? ": " : "";
+	sLogRecord fallback;
+	sLogRecord *rec;
+	va_list args;
+	int len;
+
+	if(level < gLogger.minLevel)
+		return;
+
+	va_start(args, format);
+	vsnprintf(buffMsg, LOG_LINE_LEN, format, args);
+	va_end(args);
+
+	rec = reserveRecord(&fallback);
+	rec->idPackage = gContext.idPackage;
+	rec->endPackage = FALSE;
+
+	switch(level){
+		case eLogInfo:
+			len = snprintf(rec->text, LOG_LINE_LEN, "%s%s%s\n", refstrFile, refstrSep, buffMsg);
+			break;
+
+		case eLogWarn:
+			len = snprintf(rec->text, LOG_LINE_LEN, "<warning> %s%s%s [%s : %i]\n", refstrFile, refstrSep, buffMsg, strSrcFile, srcLine);
+			break;
+
+		case eLogError:
+			len = snprintf(rec->text, LOG_LINE_LEN, "<fatal error> %s%s%s [%s : %i]\n", refstrFile, refstrSep, buffMsg, strSrcFile, srcLine);
+			break;
+
+		default:
+			len = snprintf(rec->text, LOG_LINE_LEN, "%s%s%s [%s : %i]\n", refstrFile, refstrSep, buffMsg, strSrcFile, srcLine);
+			break;
+	}
+
+	if(len >= LOG_LINE_LEN)	/** Cut short, so put back the new line. */
+		rec->text[LOG_LINE_LEN -2] = '\n';
+
+	commitRecord(rec, &fallback);
+}
+
+void logText(eLogLevel level, const char *format, ...){
+	sLogRecord fallback;
+	sLogRecord *rec;
+	va_list args;
+
+	if(level < gLogger.minLevel)
+		return;
+
+	rec = reserveRecord(&fallback);
+	rec->idPackage = gContext.idPackage;
+	rec->endPackage = FALSE;
+
+	va_start(args, format);
+	vsnprintf(rec->text, LOG_LINE_LEN, format, args);
+	va_end(args);
+
+	commitRecord(rec, &fallback);
+}
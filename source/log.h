@@ -0,0 +1,69 @@
+/*
+ *
+ *  Copyright (C) 2012 Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "utils.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef enum defLogLevel{
+	eLogDebug=0,
+	eLogInfo,
+	eLogWarn,
+	eLogError
+} eLogLevel;
+
+/*!\brief	What a thread is logging about. Lines about the same package are held back and printed together. */
+typedef struct defLogContext{
+	unsigned int idPackage;	/*!< Zero for lines that are printed straight away. */
+	const char *refstrFile;	/*!< File the lines are about, printed before them. Can be null. */
+} sLogContext;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Starts the thread that prints what's logged. Until then, and after stopLogger, lines are printed
+ *!		straight away by the thread that logs them. Stops itself at exit, if it hasn't been stopped already.
+ *!\param	minLevel	Anything less important is dropped.
+ */
+errCode startLogger(eLogLevel minLevel);
+
+/*!\brief	Prints everything that's still waiting, including packages that haven't ended, and stops the thread. */
+void stopLogger(void);
+
+/*!\brief	Gives out a new package ID for the log context. */
+unsigned int startLogPackage(void);
+
+/*!\brief	Lets the lines about a package be printed, once the lines logged before this, by any thread, are in. */
+void endLogPackage(unsigned int idPackage);
+
+/*!\brief	*/
+void getLogContext(sLogContext *outContext);
+
+/*!\brief	Sets what this thread's lines are about, until it's set again. */
+void setLogContext(const sLogContext *refContext);
+
+/*!\brief	Logs a line, with the source file and line number for anything but eLogInfo. Used by the LOG and WARN macros. */
+void logLine(eLogLevel level, const char *strSrcFile, int srcLine, const char *format, ...)
+	__attribute__ ((format (printf, 4, 5)));
+
+/*!\brief	Logs the text as it is, without adding a new line. */
+void logText(eLogLevel level, const char *format, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+#endif
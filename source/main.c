@@ -21,9 +21,14 @@
 
 #include "strtools.h"
 #include "filetools.h"
+#include "texturecram.h"
 #include "texturepacker.h"
 #include "font.h"
 #include "utils.h"
+#include "watch.h"
+#include "serve.h"
+
+#include <signal.h>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -36,271 +41,805 @@ const char SWITCH_MAN_FORMAT[] = "-f"; /*!< Specify a special format for the out
 const char SWITCH_PAD[] = "-pad"; /*!< Use padding to avoid possibly getting pixels from neighbor sprites. */
 const char SWITCH_JAVAPAK[] = "-jpak"; /*!< When writing the manifest in java, you need to also specify the package name */
 const char SWITCH_CLASS[] = "-class"; /*!< Used so that java and C manifests write stills and frames as inheriting off the given class */
+const char SWITCH_INCREMENTAL[] = "-inc"; /*!< Reuse the layout from the last run, so only the sheets with changes are written again. */
+const char SWITCH_WATCH[] = "-watch"; /*!< Keep running, and repack a directory whenever something in it changes. */
+const char SWITCH_JOBS[] = "-j"; /*!< How many threads to pack with. The default is one for each core. */
+const char SWITCH_QUIET[] = "-q"; /*!< Only log warnings and errors. */
+const char SWITCH_SERVE[] = "-serve"; /*!< Keep running, and pack the jobs sent to the unix socket at the given path. */
+const char SWITCH_CLIENT[] = "-client"; /*!< Send the job to the server on the given socket, instead of packing it here. */
+const char SWITCH_GLYPHS[] = "-glyphs"; /*!< What sheets with nothing but glyphs on are written as. */
+const char SWITCH_GLYPH_CACHE[] = "-glyphcache"; /*!< Directory to keep rendered glyphs in, so unchanged fonts aren't rendered again. */
+const char SWITCH_ROTATE[] = "-rot"; /*!< Let images go on the sheets turned a quarter turn, when they fit tighter that way. */
 const char SEARCH_PATTERN[] = "*.png";
 const char MANIFEST_EXTENSION[] = ".txt";
+const char LAYOUT_EXTENSION[] = ".layout";
 const char DEFAULT_SOURCE[] = "./";
 const char DEFAULT_OUTPUT[] = "./output";
 const char MAN_FORMAT_C[] ="c";
 const char MAN_FORMAT_CPP_1[] ="c++";
 const char MAN_FORMAT_CPP_2[] ="cpp";
 const char MAN_FORMAT_JAVA[] ="java";
+const char MAN_FORMAT_JAVA_PACKED[] ="javapacked";
+const char MAN_FORMAT_BIN[] ="bin";
+const char GLYPH_FORMAT_GRAY[] ="gray";
+const char GLYPH_FORMAT_GRAY_ALPHA[] ="ga";
+const char GLYPH_FORMAT_R8[] ="r8";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const size_t PNGHEAD_SIZE = 8;
-const int DEFAULT_BITDEPTH = 8;
-const int DEFAULT_BYTE_PP = 4;
-const int DEFAULT_COLOURTYPE = PNG_COLOR_TYPE_RGB_ALPHA;
-const int DEFAULT_INTERLACE = PNG_INTERLACE_NONE;
+const unsigned int PIPE_QUEUE_LEN = 2;	/*!< How many packages can wait between each stage of packing. */
+#define NUM_CRAM_STAGES 3
+const unsigned int WATCH_DEBOUNCE_MS = 300;	/*!< How long things have to be quiet before we repack, so a burst of saves is one repack. */
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/*!\brief	Options from the command line that apply to every package. */
+typedef struct defCramSettings{
+	sCramOptions options;
+	char const *refstrBaseOut;	/*!< Directory the output goes to, can be null. */
+	bool useLayout;
+	bool watch;
+	bool keepCache;		/*!< Keep the decoded textures for the next pack, even when we aren't watching. */
+} sCramSettings;
+
+/*!\brief	What the command line asked for on top of the settings. */
+typedef struct defCramArgs{
+	char const *refstrSourceDir;
+	char const *refstrOutputFile;
+	char const *refstrServe;	/*!< Socket to serve on, or null. */
+} sCramArgs;
+
+/*!\brief	A directory that is packed into its own sheets and manifest. When watching, it also keeps what we need to
+ *!		repack it quickly: the decoded textures and the last layout.
+ */
+typedef struct defPackage{
+	char *strDir;		/*!< Cleanup. */
+	char *strBaseName;	/*!< Name the sheets and manifest are written under. Cleanup. */
+	char ignoreFiles[256];	/*!< So we don't pack our own output. */
+	sDirListing listing;	/*!< What was in the directory the last time it was scanned. */
+	sTexCache cache;
+	sLayout layout;		/*!< Where everything went the last time this package was packed. */
+	bool haveLayout;
+	bool dirty;
+	bool failed;		/*!< Had textures, but they couldn't be packed, the last time it was packed. */
+	unsigned int numSheets;	/*!< Written the last time it was packed. */
+	const char **dynarrSheetExts;	/*!< What each of those sheets was written as, '.png' or '.r8'. Cleanup. */
+} sPackage;
+
+/*!\brief	A package on its way through the pipeline. Each stage adds to it, and the last one cleans it up. */
+typedef struct defCramWork{
+	sPackage *refPkg;
+	sLogContext logContext;	/*!< Everything the stages log about this package is printed together at the end. */
+	char buffCurOut[OUT_PATH_ROOM];
+	char buffLayout[OUT_PATH_ROOM + sizeof(LAYOUT_EXTENSION)];
+	unsigned int startFonts;	/*!< Textures from here on are glyphs, which we own. The others belong to the cache. */
+	sTex **dynarrTextures;
+	sSheetList sheets;
+	sFileList files;
+	sStillList stills;
+	sSeqList seqs;
+	sFontList fonts;
+	sManifest theMan;
+	bool failed;		/*!< The rest of the stages skip it, and it's only cleaned up. */
+} sCramWork;
+
+typedef errCode (*fooCramStage)(const sCramSettings *refSettings, sThreadPool *pool, sCramWork *work);
+
+/*!\brief	One step of the pipeline, and the threads running it. */
+typedef struct defCramStage{
+	fooCramStage foo;
+	sBoundQueue *refIn;
+	sBoundQueue *refOut;	/*!< Null for the last stage. */
+	sCramSettings const *refSettings;
+	sThreadPool *pool;
+	pthread_t *dynarrThreads;	/*!< Cleanup. */
+	unsigned int numThreads;
+	unsigned int numRunning;	/*!< The last thread to finish closes the output queue. Guarded by lock. */
+	pthread_mutex_t lock;
+} sCramStage;
+
+static volatile sig_atomic_t gStopRequested = 0;
+
+static void onStopSignal(int sig){
+	gStopRequested = 1;
+}
+
+/*!\brief	Names the sheets and manifest the package is written under, and ignores files with that name. */
+static void namePackage(sPackage *refPkg, const char *strBaseName){
+	SAFE_DELETE(refPkg->strBaseName);
+	copyString(&refPkg->strBaseName, strBaseName);
+	snprintf(refPkg->ignoreFiles, sizeof(refPkg->ignoreFiles), "%s*", refPkg->strBaseName);
+}
+
+/*!\brief	Adds a package to the end of the list, unless there's already one for the directory.
+ *!\param	strBaseName	Name to write the package under. If null, the directory name is used, or the name the
+ *!				package already has.
+ *!\return	Index of the package.
+ */
+static unsigned int addPackage(sPackage **pPackages, unsigned int *pNum, const char *strDir, const char *strBaseName){
+	unsigned int i;
+	sPackage *refPkg;
+
+	for(i=0; i < *pNum; ++i){
+		if(strcmp((*pPackages)[i].strDir, strDir) == 0){
+			if(strBaseName != NULL && strcmp((*pPackages)[i].strBaseName, strBaseName) != 0)
+				namePackage(&(*pPackages)[i], strBaseName);
+			return i;
+		}
+	}
 
-/*!\brief	Writes the standard pack info file. */
-errCode writeManifestInTxt(
-	const char *manPath,
-	const sManifest *writeMe,
-	const sTex **refarrTexs
-);
+	++(*pNum);
+	(*pPackages) = realloc_chk(*pPackages, (*pNum) * sizeof(sPackage));
+	refPkg = &(*pPackages)[(*pNum) -1];
+	memset(refPkg, 0, sizeof(sPackage));
+
+	copyString(&refPkg->strDir, strDir);
+	if(strBaseName != NULL){
+		namePackage(refPkg, strBaseName);
+	}else{
+		getOutputNameFromFullPath(&refPkg->strBaseName, strDir);
+		snprintf(refPkg->ignoreFiles, sizeof(refPkg->ignoreFiles), "%s*", refPkg->strBaseName);
+	}
+
+	refPkg->dirty = TRUE;
 
-/*!\brief	Writes the manifest as a C file that you can include in your project. */
-errCode writeManifestInC(
-	const char *manPath,
-	const sManifest *writeMe,
-	const sTex **refarrTexs
-);
+	return (*pNum) -1;
+}
 
-/*!\brief	Writes the manifest as a java file that you can includes in your project.
- *!\note	Assumes this is the last step, so it modifies the strings used for various names.
+/*!\brief	Adds a package for each directory nested in the package's directory, from its listing.
+ *!\param	watcher	If not null, the new packages are watched too.
  */
-errCode writeManifestInJava(
-	const char *manPath,
-	const char *javapakName,
-	const char *refstrClass,
-	const sManifest *writeMe,
-	const sTex **refarrTexs
-);
+static void addSubPackages(sPackage **pPackages, unsigned int *pNum, unsigned int idxParent, sWatcher *watcher){
+	char buff[256];
+	size_t iSub;
+	unsigned int idxPkg;
 
+	for(iSub = 0; iSub < (*pPackages)[idxParent].listing.dirs.num; ++iSub){
+		snprintf(buff, 245, "%s/%s", (*pPackages)[idxParent].strDir, (*pPackages)[idxParent].listing.dirs.dynarrFiles[iSub]);
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		idxPkg = addPackage(pPackages, pNum, buff, NULL);
+		if(watcher != NULL)
+			addWatch(watcher, (*pPackages)[idxPkg].strDir, idxPkg, (*pPackages)[idxPkg].ignoreFiles);
+	}
+}
 
-/*!\brief	Gets all the file names of every .png image found in the given directory. Outputs a series of power 2 sized textures which contain all
- *			the individual images as one sheet (or several depending on how many images you have and what your max sized square is). It also outputs
- *			a single textfile which lists which texture pack contains which images. They are listed using their file names minus the png extension.
- *			If a series of images are found, they are listed as an animation with a single reference name. So if you have cat_1.png cat_2.png cat_3.png
- *			you will get animation 'cat' with 3 frames.
+/*!\brief	Reads the package's directory again, and adds packages for any new directories in it. */
+static void rescanPackage(sPackage **pPackages, unsigned int *pNum, unsigned int idxPkg, sWatcher *watcher){
+	sPackage *refPkg = &(*pPackages)[idxPkg];
+
+	cleanupDirListing(&refPkg->listing);
+	if(scanDir(refPkg->strDir, &refPkg->listing) != NOPROB)
+		WARN("Unable to read the directory %s", refPkg->strDir);
+
+	addSubPackages(pPackages, pNum, idxPkg, watcher);
+}
+
+/*!\brief	Scans the whole tree in one go, and adds a package for every directory in it, before anything is packed.
+ *!		Packages that were already in the list get the new listing, and are marked dirty with the rest.
+ *!\param	strBaseName	Name to write the root package under.
+ *!\param	outIdxs		If not null, gets the index of every package in the tree.
  */
-int main(int argc, const char *argv[], const char **envp ){
-	char const *refstrSourceDir = DEFAULT_SOURCE;
-	char const *refstrOutputFile = DEFAULT_OUTPUT;
-	char const *refstrJavapak = NULL;
-	char const *refstrManClass = NULL;
-	unsigned int maxSquare = 1024;
-	eOutputFormat format = eFormatDefault;
-	char ignoreOutputFiles[256];	memset(ignoreOutputFiles, 0, sizeof(ignoreOutputFiles));
-	short usePadding=FALSE;
-	bool enforcePow2=FALSE;
-
-	printf("---Texture Cram---\n");
-
-	/** parse command arguments */
+static void addPackageTree(
+	sPackage **pPackages, unsigned int *pNum, sThreadPool *pool, const char *strRoot, const char *strBaseName, sListUint *outIdxs
+){
+	sScanDir *dynarrScanned = NULL;
+	unsigned int numScanned = 0;
+	unsigned int i, idxPkg;
+
+	if(scanTree(strRoot, pool, &dynarrScanned, &numScanned) != NOPROB)
+		return;
+
+	for(i=0; i < numScanned; ++i){
+		idxPkg = addPackage(pPackages, pNum, dynarrScanned[i].strPath, (i == 0) ? strBaseName : NULL);
+
+		cleanupDirListing(&(*pPackages)[idxPkg].listing);	/** The package takes the listing over. */
+		(*pPackages)[idxPkg].listing = dynarrScanned[i].listing;
+		(*pPackages)[idxPkg].dirty = TRUE;
+		memset(&dynarrScanned[i].listing, 0, sizeof(sDirListing));
+
+		if(outIdxs != NULL)
+			pushListUint(outIdxs, idxPkg);
+	}
+
+	cleanupScanDirs(&dynarrScanned, &numScanned);
+}
+
+/*!\brief	*/
+static void cleanupPackage(sPackage *pkg){
+	SAFE_DELETE(pkg->strDir);
+	SAFE_DELETE(pkg->strBaseName);
+	cleanupDirListing(&pkg->listing);
+	cleanupTexCache(&pkg->cache);
+	cleanupLayout(&pkg->layout);
+	pkg->haveLayout = FALSE;
+	SAFE_DELETE(pkg->dynarrSheetExts);
+}
+
+/*!\brief	Finds and decodes the images, and renders the fonts. */
+static errCode decodeStage(const sCramSettings *refSettings, sThreadPool *pool, sCramWork *work){
+	sPackage *pkg = work->refPkg;
+
+	if(filterFiles(&pkg->listing.files, &work->files, pkg->ignoreFiles, SEARCH_PATTERN) != NOPROB)
+		return PROBLEM;
+
+	if(work->files.num > 0){
+		if(genTexturesCached(pkg->strDir, &work->files, &pkg->cache, &work->dynarrTextures, pool) != NOPROB)
+			return PROBLEM;
+	}
+
+	if(work->dynarrTextures != NULL){	/** we only need to sort sequences and stills */
+		if(sortTextures(work->dynarrTextures, &work->seqs, &work->stills) != NOPROB)
+			return PROBLEM;
+
+		for(work->startFonts=0; work->dynarrTextures[work->startFonts] != NULL; ++work->startFonts)
+			;
+	}
+
+	if(addFontTextures(pkg->strDir, &pkg->listing.files, pkg->ignoreFiles, &work->dynarrTextures, &work->fonts, refSettings->options.refstrGlyphCache, pool) != NOPROB)
+		return PROBLEM;
+
+	if(work->dynarrTextures == NULL){
+		DBUG_WARN("No textures found");
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
+
+/*!\brief	Puts the textures on sheets, and writes the manifest. */
+static errCode arrangeStage(const sCramSettings *refSettings, sThreadPool *pool, sCramWork *work){
+	sPackage *pkg = work->refPkg;
+
+	if(refSettings->useLayout == TRUE && pkg->haveLayout == FALSE)
+		pkg->haveLayout = (readLayout(work->buffLayout, &pkg->layout) == NOPROB) ? TRUE : FALSE;
+
+	if(arrangeTextures(
+		work->dynarrTextures, &work->seqs, &work->stills, &work->fonts, &work->sheets, refSettings->options.maxSquare,
+		(refSettings->options.allowRotate != 0) ? TRUE : FALSE, (pkg->haveLayout == TRUE) ? &pkg->layout : NULL
+	) != NOPROB)
+		return PROBLEM;
+
+	if(refSettings->options.pow2Sheets != 0)
+		growSheetsToPow2(&work->sheets);
+
+	if(genMan(
+		pkg->strBaseName,
+		&work->seqs,
+		&work->stills,
+		&work->fonts,
+		&work->sheets,
+		(const sTex **)work->dynarrTextures,
+		&work->theMan
+	) != NOPROB)
+		return PROBLEM;
+
+	if(saveManifest(
+		work->buffCurOut, &refSettings->options, pkg->strBaseName, &work->theMan, (const sTex **)work->dynarrTextures
+	) != NOPROB)
+		return PROBLEM;
+
+	return NOPROB;
+}
+
+/*!\brief	Composes and writes the sheets. */
+static errCode encodeStage(const sCramSettings *refSettings, sThreadPool *pool, sCramWork *work){
+	sPackage *pkg = work->refPkg;
+
+	if(writeSheets(refSettings->refstrBaseOut, pkg->strBaseName, work->dynarrTextures, &work->sheets, refSettings->options.glyphFormat, pool) != NOPROB)
+		return PROBLEM;
+
+	if(refSettings->useLayout == TRUE)
+		writeLayout(work->buffLayout, &work->sheets, (const sTex **)work->dynarrTextures);
+
+	if(refSettings->watch == TRUE){	/** Keep the layout around so the next repack leaves things where they are. */
+		cleanupLayout(&pkg->layout);
+		pkg->haveLayout = (genLayout(&work->sheets, (const sTex **)work->dynarrTextures, &pkg->layout) == NOPROB) ? TRUE : FALSE;
+	}
+
+	return NOPROB;
+}
+
+/*!\brief	Path the package's sheets and manifest are written to, without the number or extension.
+ *!\return	PROBLEM if the path is too long for the buffer.
+ */
+static errCode getPackageOut(const sCramSettings *refSettings, const sPackage *pkg, char *outBuff, size_t lenBuff){
+	const int lenOut = snprintf(outBuff, lenBuff, "%s%s",
+		(refSettings->refstrBaseOut != NULL) ? refSettings->refstrBaseOut : "", pkg->strBaseName
+	);
+
+	if(lenOut < 0 || (size_t)lenOut >= lenBuff){
+		WARN("The output path for %s is too long", pkg->strDir);
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
+
+static sCramWork* startCramWork(const sCramSettings *refSettings, sPackage *pkg){
+	sCramWork *work = calloc_chk(1, sizeof(sCramWork));
+
+	work->refPkg = pkg;
+
+	work->logContext.idPackage = startLogPackage();
+	setLogContext(&work->logContext);
+	LOG("Packing %s", pkg->strDir);
+
+	if(getPackageOut(refSettings, pkg, work->buffCurOut, sizeof(work->buffCurOut)) != NOPROB)
+		work->failed = TRUE;
+	snprintf(work->buffLayout, sizeof(work->buffLayout), "%s%s", work->buffCurOut, LAYOUT_EXTENSION);
+
+	setLogContext(NULL);
+
+	return work;
+}
+
+/*!\brief	Prints what was logged about the package, and cleans up everything but what's kept in the package. */
+static void finishCramWork(const sCramSettings *refSettings, sCramWork *work){
+	unsigned int i;
+
+	work->refPkg->failed = (work->failed == TRUE && work->dynarrTextures != NULL) ? TRUE : FALSE;
+	work->refPkg->numSheets = work->sheets.num;
+
+	SAFE_DELETE(work->refPkg->dynarrSheetExts);
+	if(work->sheets.num > 0 && work->dynarrTextures != NULL){
+		work->refPkg->dynarrSheetExts = calloc_chk(work->sheets.num, sizeof(const char*));
+		for(i=0; i < work->sheets.num; ++i){
+			work->refPkg->dynarrSheetExts[i] = getSheetExtension(
+				work->dynarrTextures, work->sheets.dynarrSheets[i], refSettings->options.glyphFormat
+			);
+		}
+	}
+
+	if(work->dynarrTextures != NULL){	/** The cache owns the image textures, but the font ones are ours. */
+		for(i=work->startFonts; work->dynarrTextures[i] != NULL; ++i){
+			cleanupTex(work->dynarrTextures[i]);
+			SAFE_DELETE(work->dynarrTextures[i]);
+		}
+		SAFE_DELETE(work->dynarrTextures);
+	}
+
+	cleanupManifest(&work->theMan);	/** Before the lists it refers to. */
+	cleanupFileList(&work->files);
+	cleanupSheetList(&work->sheets);
+	cleanupStillList(&work->stills);
+	cleanupSeqList(&work->seqs);
+	cleanupFontList(&work->fonts);
+
+	if(refSettings->watch == FALSE){	/** Nothing's going to use these again. */
+		if(refSettings->keepCache == FALSE)
+			cleanupTexCache(&work->refPkg->cache);
+
+		cleanupLayout(&work->refPkg->layout);
+		work->refPkg->haveLayout = FALSE;
+	}
+
+	endLogPackage(work->logContext.idPackage);
+	SAFE_DELETE(work);
+}
+
+static void* cramStageMain(void *data){
+	sCramStage *stage = (sCramStage*)data;
+	sCramWork *work;
+
+	while((work = popBoundQueue(stage->refIn)) != NULL){
+		setLogContext(&work->logContext);
+		if(work->failed == FALSE && stage->foo(stage->refSettings, stage->pool, work) != NOPROB)
+			work->failed = TRUE;
+		setLogContext(NULL);
+
+		if(stage->refOut != NULL)
+			pushBoundQueue(stage->refOut, work);
+		else
+			finishCramWork(stage->refSettings, work);
+	}
+
+	pthread_mutex_lock(&stage->lock);
+	--stage->numRunning;
+	if(stage->numRunning == 0 && stage->refOut != NULL)
+		closeBoundQueue(stage->refOut);
+	pthread_mutex_unlock(&stage->lock);
+
+	return NULL;
+}
+
+/*!\brief	Packs every dirty package, and waits for them all to finish. The packages go through a pipeline, so one
+ *!		package can be decoding while the one before it is being arranged and the one before that is being written.
+ *!		The queues between the stages are short, so only a few packages are in memory at once.
+ */
+static void cramDirtyPackages(const sCramSettings *refSettings, sThreadPool *pool, sPackage *arrPackages, unsigned int numPackages){
+	sBoundQueue arrQueues[NUM_CRAM_STAGES];
+	sCramStage arrStages[NUM_CRAM_STAGES];
+	const fooCramStage arrFoos[NUM_CRAM_STAGES] = { decodeStage, arrangeStage, encodeStage };
+	const unsigned int numCores = (refSettings->options.numThreads > 0) ? refSettings->options.numThreads : getNumCores();
+	unsigned int i, t;
+
+	for(i=0; i < NUM_CRAM_STAGES; ++i)
+		initBoundQueue(&arrQueues[i], PIPE_QUEUE_LEN);
+
+	for(i=0; i < NUM_CRAM_STAGES; ++i){
+		sCramStage *refStage = &arrStages[i];
+
+		memset(refStage, 0, sizeof(sCramStage));
+		refStage->foo = arrFoos[i];
+		refStage->refIn = &arrQueues[i];
+		refStage->refOut = (i+1 < NUM_CRAM_STAGES) ? &arrQueues[i+1] : NULL;
+		refStage->refSettings = refSettings;
+		refStage->pool = pool;
+		refStage->numThreads = 1;
+		if(refStage->foo == arrangeStage && numCores > 2)	/** The others get their help from the pool. */
+			refStage->numThreads = numCores /2;
+
+		pthread_mutex_init(&refStage->lock, NULL);
+		refStage->dynarrThreads = calloc_chk(refStage->numThreads, sizeof(pthread_t));
+
+		for(t=0; t < refStage->numThreads; ++t){
+			if(pthread_create(&refStage->dynarrThreads[t], NULL, cramStageMain, refStage) != 0){
+				ERROR_LOG("Unable to start a thread");
+				exit(1);
+			}
+			++refStage->numRunning;	/** Nothing can finish before the queue is closed. */
+		}
+	}
+
+	for(i=0; i < numPackages; ++i){
+		if(arrPackages[i].dirty == FALSE)
+			continue;
+
+		arrPackages[i].dirty = FALSE;
+		pushBoundQueue(&arrQueues[0], startCramWork(refSettings, &arrPackages[i]));
+	}
+	closeBoundQueue(&arrQueues[0]);
+
+	for(i=0; i < NUM_CRAM_STAGES; ++i){
+		for(t=0; t < arrStages[i].numThreads; ++t)
+			pthread_join(arrStages[i].dynarrThreads[t], NULL);
+
+		SAFE_DELETE(arrStages[i].dynarrThreads);
+		pthread_mutex_destroy(&arrStages[i].lock);
+	}
+
+	for(i=0; i < NUM_CRAM_STAGES; ++i)
+		cleanupBoundQueue(&arrQueues[i]);
+}
+
+/*!\brief	Repacks the packages whenever something in their directories changes, until we're told to stop. */
+static void watchPackages(const sCramSettings *refSettings, sThreadPool *pool, sPackage **pPackages, unsigned int *pNum){
+	sWatcher watcher;
+	sListUint changed;	memset(&changed, 0, sizeof(changed));
+	unsigned int i;
+
+	if(startWatching(&watcher) != NOPROB)
+		return;
+
+	for(i=0; i < *pNum; ++i)
+		addWatch(&watcher, (*pPackages)[i].strDir, i, (*pPackages)[i].ignoreFiles);
+
+	signal(SIGINT, onStopSignal);
+	signal(SIGTERM, onStopSignal);
+
+	LOG("Watching for changes, ctrl+c to stop.");
+
+	while(gStopRequested == 0 && waitForChanges(&watcher, WATCH_DEBOUNCE_MS, &changed) == NOPROB){
+		for(i=0; i < changed.num; ++i){
+			if(changed.arr[i] < *pNum)
+				(*pPackages)[ changed.arr[i] ].dirty = TRUE;
+		}
+		changed.num = 0;
+
+		for(i=0; i < *pNum; ++i){	/** New directories are added to the end, dirty, so they're read too. */
+			if((*pPackages)[i].dirty == TRUE)
+				rescanPackage(pPackages, pNum, i, &watcher);
+		}
+
+		cramDirtyPackages(refSettings, pool, *pPackages, *pNum);
+	}
+
+	cleanupListUint(&changed);
+	stopWatching(&watcher);
+}
+
+/*!\brief	Reads the command line switches into the settings and arguments, which should already have their defaults. */
+static void parseArgs(int argc, const char *argv[], sCramSettings *outSettings, sCramArgs *outArgs){
 	while(argc > 0){
-		if(argc > 1 && strncmp(argv[argc-2], SWITCH_DIR, 2)==0 ){
-			refstrSourceDir = argv[argc-1];
-			printf("Source directory is %s\n", refstrSourceDir);
+		if(argc > 1 && strcmp(argv[argc-2], SWITCH_SERVE)==0 ){	/** Before -s, which it starts with. */
+			outArgs->refstrServe = argv[argc-1];
+			LOG("Serving on %s", outArgs->refstrServe);
+			--argc;
+
+		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_DIR, 2)==0 ){
+			outArgs->refstrSourceDir = argv[argc-1];
+			LOG("Source directory is %s", outArgs->refstrSourceDir);
 			--argc;
 
 		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_OUTPUT, 2)==0 ){
-			refstrOutputFile = argv[argc-1];
-			printf("Output path is %s\n", refstrOutputFile);
+			outArgs->refstrOutputFile = argv[argc-1];
+			LOG("Output path is %s", outArgs->refstrOutputFile);
 			--argc;
 
 		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_MAXSQUARE, 2)==0 ){
-			maxSquare = atoi(argv[argc-1]);
+			outSettings->options.maxSquare = atoi(argv[argc-1]);
 			--argc;
 
 		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_MAN_FORMAT, 2)==0 ){
-			if( strncmp(argv[argc-1], MAN_FORMAT_C, strlen(MAN_FORMAT_C) ) == 0 ){
-				format = eFormatC;
-				printf("Manifest is C\n");
+			if( strcmp(argv[argc-1], MAN_FORMAT_CPP_1) == 0 || strcmp(argv[argc-1], MAN_FORMAT_CPP_2) == 0 ){
+				outSettings->options.format = eCramFormatCPP;
+				LOG("Manifest is C++");
+			}else if( strncmp(argv[argc-1], MAN_FORMAT_C, strlen(MAN_FORMAT_C) ) == 0 ){
+				outSettings->options.format = eCramFormatC;
+				LOG("Manifest is C");
+			}else if( strcmp(argv[argc-1], MAN_FORMAT_JAVA_PACKED) == 0 ){	/** Before java, which it starts with. */
+				outSettings->options.format = eCramFormatJavaPacked;
+				LOG("Manifest is packed java");
 			}else if( strncmp(argv[argc-1], MAN_FORMAT_JAVA, strlen(MAN_FORMAT_JAVA) ) == 0 ){
-				format = eFormatJava;
-				printf("Manifest is java\n");
+				outSettings->options.format = eCramFormatJava;
+				LOG("Manifest is java");
+			}else if( strcmp(argv[argc-1], MAN_FORMAT_BIN) == 0 ){
+				outSettings->options.format = eCramFormatBin;
+				LOG("Manifest is binary");
 			}else{
-				printf("Manifest is default\n");
+				LOG("Manifest is default");
 			}
 			//- todo others
 			--argc;
 
 		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_JAVAPAK, 5)==0 ){
-			refstrJavapak = argv[argc-1];
-			printf("Java pack is: %s\n", refstrJavapak);
+			outSettings->options.refstrJavapak = argv[argc-1];
+			LOG("Java pack is: %s", outSettings->options.refstrJavapak);
 			--argc;
 
 		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_CLASS, 5)==0 ){
-			refstrManClass = argv[argc-1];
-			printf("parent class is: %s\n", refstrManClass);
+			outSettings->options.refstrManClass = argv[argc-1];
+			LOG("parent class is: %s", outSettings->options.refstrManClass);
 			--argc;
 
-		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_PAD, 4)==0 ){
-			usePadding=TRUE;
-			printf("Padding used\n");
+		}else if(argc > 1 && strcmp(argv[argc-2], SWITCH_GLYPHS)==0 ){
+			if( strcmp(argv[argc-1], GLYPH_FORMAT_GRAY) == 0 ){
+				outSettings->options.glyphFormat = eCramGlyphGray;
+				LOG("Glyph sheets are gray");
+			}else if( strcmp(argv[argc-1], GLYPH_FORMAT_GRAY_ALPHA) == 0 ){
+				outSettings->options.glyphFormat = eCramGlyphGrayAlpha;
+				LOG("Glyph sheets are gray and alpha");
+			}else if( strcmp(argv[argc-1], GLYPH_FORMAT_R8) == 0 ){
+				outSettings->options.glyphFormat = eCramGlyphR8;
+				LOG("Glyph sheets are raw bytes");
+			}else{
+				LOG("Glyph sheets are RGBA");
+			}
+			--argc;
+
+		}else if(argc > 1 && strcmp(argv[argc-2], SWITCH_GLYPH_CACHE)==0 ){
+			outSettings->options.refstrGlyphCache = argv[argc-1];
+			LOG("Glyphs are cached in %s", outSettings->options.refstrGlyphCache);
+			--argc;
+
+		}else if(argc > 1 && strcmp(argv[argc-2], SWITCH_JOBS)==0 ){
+			outSettings->options.numThreads = atoi(argv[argc-1]);
+			LOG("Packing with %u threads", outSettings->options.numThreads);
+			--argc;
+
+		}else if(argc > 1 && strncmp(argv[argc-2], SWITCH_PAD, 4)==0 ){	/** Still read, so it isn't taken for -p. */
+			WARN("Padding isn't supported, so %s is ignored", SWITCH_PAD);
 			--argc;
 			
+		}else if(strncmp(argv[argc-1], SWITCH_INCREMENTAL, 4)==0){
+			outSettings->useLayout = TRUE;
+			LOG("Reusing the last layout");
+
+		}else if(strncmp(argv[argc-1], SWITCH_WATCH, 6)==0){
+			outSettings->watch = TRUE;
+			LOG("Watching for changes");
+
+		}else if(strcmp(argv[argc-1], SWITCH_ROTATE)==0){
+			outSettings->options.allowRotate = TRUE;
+			LOG("Images can be turned");
+
 		}else if(strncmp(argv[argc-1], SWITCH_NEARPOW2, 2)==0){
-			enforcePow2 = TRUE;
+			outSettings->options.pow2Sheets = TRUE;
+			LOG("Sheets are a power of 2");
 		}
 
 		--argc;
 	}
 
-	printf("The max size is %i\n", maxSquare);
-		
-	char *strBaseOut=NULL;
-	getBaseDir(&strBaseOut, refstrOutputFile);
+	LOG("The max size is %i", outSettings->options.maxSquare);
+}
 
-	char *strBaseName=NULL;
-	getOutputNameFromFullPath(&strBaseName, refstrOutputFile);
+/*!\brief	Puts the path in the buffer, in front of the directory if it's relative. */
+static void makeAbsolute(const char *strDir, const char *strPath, char *outBuff, size_t lenBuff){
+	if(strPath[0] == '/')
+		snprintf(outBuff, lenBuff, "%s", strPath);
+	else
+		snprintf(outBuff, lenBuff, "%s/%s", strDir, strPath);
+}
 
-	char **subDirs = calloc(2, sizeof(char*));
-	size_t numDirs = 1;
+/*!\brief	Packs a job from a client, and tells it what was written.
+ *!\return	PROBLEM if anything in the job couldn't be packed.
+ */
+static errCode serveJob(sThreadPool *pool, sServeJob *job, sPackage **pPackages, unsigned int *pNum){
+	char buffDir[512], buffOut[512], buffGlyphCache[512], buff[512];
+	char *strBaseOut = NULL;
+	char *strBaseName = NULL;
+	unsigned int i, s;
+	sPackage const *refPkg;
+	sCramArgs args;		memset(&args, 0, sizeof(args));
+	sCramSettings settings;	memset(&settings, 0, sizeof(settings));
+	sListUint packed;	memset(&packed, 0, sizeof(packed));
+	errCode result = NOPROB;
+
+	initCramOptions(&settings.options);
+	args.refstrSourceDir = DEFAULT_SOURCE;
+	args.refstrOutputFile = DEFAULT_OUTPUT;
+	parseArgs((int)job->numArgs, job->dynarrArgs, &settings, &args);
+
+	if(settings.watch == TRUE || args.refstrServe != NULL){
+		replyJob(job, "error The server can't watch or serve for a client");
+		result = PROBLEM;
+		goto serveJob_end;
+	}
+	settings.keepCache = TRUE;	/** So the next job only decodes what's changed. */
 
-	copyString(&subDirs[0], refstrSourceDir);
-	subDirs[1] = NULL;
+	makeAbsolute(job->strCwd, args.refstrSourceDir, buffDir, sizeof(buffDir));
+	makeAbsolute(job->strCwd, args.refstrOutputFile, buffOut, sizeof(buffOut));
+	if(settings.options.refstrGlyphCache != NULL){
+		makeAbsolute(job->strCwd, settings.options.refstrGlyphCache, buffGlyphCache, sizeof(buffGlyphCache));
+		settings.options.refstrGlyphCache = buffGlyphCache;
+	}
 
-	char buffCurOut[256];
+	getBaseDir(&strBaseOut, buffOut);
+	settings.refstrBaseOut = strBaseOut;
+	getOutputNameFromFullPath(&strBaseName, buffOut);
 
-	size_t iDir;
-	for(iDir=0; iDir < numDirs; ++iDir){
-		sTex **dynarrTextures = NULL;
-		sSheetList sheets;	memset(&sheets, 0, sizeof(sheets));
-		sFileList files;	memset(&files, 0, sizeof(files));
-		sStillList stills;	memset(&stills, 0, sizeof(stills));
-		sSeqList seqs;		memset(&seqs, 0, sizeof(seqs));
-		sFontList fonts;	memset(&fonts, 0, sizeof(fonts));
-		sManifest theMan;	memset(&theMan, 0, sizeof(theMan));
+	if(fileExists(buffDir) == FALSE){	/** Otherwise it would pack as an empty directory. */
+		replyJob(job, "error Unable to read the directory %s", buffDir);
+		result = PROBLEM;
+		goto serveJob_end;
+	}
 
-		if(getFiles(subDirs[iDir], &files, ignoreOutputFiles, SEARCH_PATTERN) != NOPROB)
-			continue;
+	addPackageTree(pPackages, pNum, pool, buffDir, strBaseName, &packed);
 
-		if(strBaseName == NULL)
-			getOutputNameFromFullPath(&strBaseName, subDirs[iDir]);
+	cramDirtyPackages(&settings, pool, *pPackages, *pNum);
 
-		snprintf(ignoreOutputFiles, 256, "%s*", strBaseName);
-		if(strBaseOut != NULL)
-			snprintf(buffCurOut, 256, "%s%s", strBaseOut, strBaseName);
-		else
-			strncpy(buffCurOut, strBaseName, 256);
+	for(i=0; i < packed.num; ++i){
+		refPkg = &(*pPackages)[ packed.arr[i] ];
 
-		if(files.num > 0){
-			if(genTextures(subDirs[iDir], &files, &dynarrTextures) != NOPROB)
-				goto LOOP_PROB;	
+		if(refPkg->failed == TRUE){
+			replyJob(job, "error Unable to pack %s", refPkg->strDir);
+			result = PROBLEM;
+			continue;
 		}
 
-		if(dynarrTextures != NULL){	/** we only need to sort sequences and stills */
-			if(sortTextures(dynarrTextures, &seqs, &stills) != NOPROB)
-				goto LOOP_PROB;
+		if(refPkg->numSheets == 0)	/** Nothing in it to pack. */
+			continue;
+
+		if(getPackageOut(&settings, refPkg, buff, sizeof(buff)) != NOPROB){
+			replyJob(job, "error The output path for %s is too long", refPkg->strDir);
+			result = PROBLEM;
+			continue;
 		}
 
-		{	/** fonts */
-			sTex **dynarrFntTexs =NULL;
-			sFontInfo **dynarrFntIfo = genFontInfos(subDirs[iDir], ignoreOutputFiles);
-			if(dynarrFntIfo != NULL && genTexFromFonts(dynarrFntIfo, &dynarrFntTexs, &fonts) != NOPROB)
-				goto LOOP_PROB;
+		replyJob(job, "file %s%s", buff, getManifestExtension(settings.options.format));
+		for(s=0; s < refPkg->numSheets; ++s)
+			replyJob(job, "file %s%u%s", buff, s, (refPkg->dynarrSheetExts != NULL) ? refPkg->dynarrSheetExts[s] : ".png");
+	}
 
-			unsigned int startIdx;
-			if(dynarrTextures == NULL){
-				startIdx = 0;
-			}else{
-				for(startIdx=0; dynarrTextures[startIdx] != NULL; ++startIdx)
-					;
-			}
+serveJob_end:
+	cleanupListUint(&packed);
+	SAFE_DELETE(strBaseName);
+	SAFE_DELETE(strBaseOut);
+	return result;
+}
 
-			appendTexArr(&dynarrTextures, dynarrFntTexs);
-			genFontFromInfo((const sFontInfo **)dynarrFntIfo, &fonts, startIdx);
-			cleanupFontInfos(&dynarrFntIfo);
-		}
+/*!\brief	Packs the jobs clients send, until we're told to stop. The packages, and the textures decoded for them, are
+ *!		kept from one job to the next, so only the images that have changed since are decoded again.
+ */
+static void servePackages(sThreadPool *pool, const char *strSocket, sPackage **pPackages, unsigned int *pNum){
+	sServer server;
+	sServeJob job;
 
-		if(dynarrTextures == NULL){
-			DBUG_WARN("No textures found");
-			goto LOOP_PROB;
-		}
+	if(startServer(&server, strSocket) != NOPROB)
+		return;
 
-		if(arrangeTextures(dynarrTextures, &seqs, &stills, &fonts, &sheets, maxSquare) != NOPROB)
-			goto LOOP_PROB;
-	
-		if(genMan(
-			strBaseName,
-			&seqs,
-			&stills,
-			&fonts,
-			&sheets,
-			(const sTex **)dynarrTextures,
-			&theMan
-		) != NOPROB)
-			goto LOOP_PROB;
-
-		switch(format){
-			case eFormatDefault:
-				if(writeManifestInTxt(buffCurOut, &theMan, (const sTex **)dynarrTextures) != NOPROB)
-					goto LOOP_PROB;	
-				break;
-
-			case eFormatC:
-				if(writeManifestInC(buffCurOut, &theMan, (const sTex **)dynarrTextures) != NOPROB)
-					goto LOOP_PROB;	
-				break;
-
-			case eFormatJava:
-				if(writeManifestInJava(buffCurOut, refstrJavapak, refstrManClass, &theMan, (const sTex **)dynarrTextures)!=NOPROB)
-					goto LOOP_PROB;	
-				break;
-
-			default:
-				break;
-		}
+	signal(SIGINT, onStopSignal);
+	signal(SIGTERM, onStopSignal);
 
-		if(writeSheets(strBaseOut, strBaseName, dynarrTextures, &sheets) != NOPROB)
-			goto LOOP_PROB;
-
-		{
-			char **moreDirs = NULL;
-			getDirs(subDirs[iDir], &moreDirs);
-
-			if(moreDirs != NULL){
-				size_t iMore;
-				for(iMore = 0; moreDirs[iMore] != NULL; ++iMore){
-					++numDirs;
-					subDirs = realloc(subDirs, (numDirs + 1) * sizeof(char*));
-					snprintf(buffCurOut, 245, "%s/%s", subDirs[iDir], moreDirs[iMore]);
-					SAFE_DELETE(moreDirs[iMore]);
-					copyString(&subDirs[ numDirs - 1], buffCurOut);
-					subDirs[numDirs] = NULL;
-				}
-			}
+	LOG("Waiting for jobs, ctrl+c to stop.");
+
+	while(gStopRequested == 0){
+		if(acceptJob(&server, &job) != NOPROB)
+			continue;
+
+		finishJob(&job, serveJob(pool, &job, pPackages, pNum));
+	}
+
+	stopServer(&server);
+}
+
+/*!\brief	Gets all the file names of every .png image found in the given directory. Outputs a series of power 2 sized textures which contain all
+ *			the individual images as one sheet (or several depending on how many images you have and what your max sized square is). It also outputs
+ *			a single textfile which lists which texture pack contains which images. They are listed using their file names minus the png extension.
+ *			If a series of images are found, they are listed as an animation with a single reference name. So if you have cat_1.png cat_2.png cat_3.png
+ *			you will get animation 'cat' with 3 frames.
+ */
+int main(int argc, const char *argv[], const char **envp ){
+	eLogLevel minLogLevel = eLogDebug;
+	char const *refstrClient = NULL;
+	int iArg;
+	sCramArgs args;		memset(&args, 0, sizeof(args));
+	sCramSettings settings;	memset(&settings, 0, sizeof(settings));
+
+	initCramOptions(&settings.options);
+	args.refstrSourceDir = DEFAULT_SOURCE;
+	args.refstrOutputFile = DEFAULT_OUTPUT;
+
+	for(iArg=1; iArg < argc; ++iArg){	/** Before anything is logged. */
+		if(strcmp(argv[iArg], SWITCH_QUIET) == 0)
+			minLogLevel = eLogWarn;
+		else if(strcmp(argv[iArg], SWITCH_CLIENT) == 0 && iArg +1 < argc)
+			refstrClient = argv[iArg +1];
+	}
+
+	if(refstrClient != NULL){	/** Only the paths that were written are printed, so scripts can read them. */
+		const char **dynarrJobArgs = calloc_chk(argc, sizeof(char*));
+		unsigned int numJobArgs = 0;
+		errCode result;
 
-			SAFE_DELETE(moreDirs);
+		for(iArg=1; iArg < argc; ++iArg){
+			if(strcmp(argv[iArg], SWITCH_CLIENT) == 0)
+				++iArg;
+			else
+				dynarrJobArgs[numJobArgs++] = argv[iArg];
 		}
 
-	LOOP_PROB:
-		cleanupFileList(&files);
-		cleanupTextures(&dynarrTextures);
-		cleanupSheetList(&sheets);
-		cleanupStillList(&stills);
-		cleanupSeqList(&seqs);
-		cleanupManifest(&theMan);
+		startLogger(eLogWarn);
+		result = runClient(refstrClient, dynarrJobArgs, numJobArgs);
+		SAFE_DELETE(dynarrJobArgs);
+		stopLogger();
+		return (result == NOPROB) ? 0 : 1;
+	}
+
+	startLogger(minLogLevel);
+
+	LOG("---Texture Cram---");
+
+	parseArgs(argc, argv, &settings, &args);
+
+	char *strBaseOut=NULL;
+	getBaseDir(&strBaseOut, args.refstrOutputFile);
+	settings.refstrBaseOut = strBaseOut;
 
-		SAFE_DELETE(subDirs[iDir]);
-		SAFE_DELETE(strBaseName);
+	char *strBaseName=NULL;
+	getOutputNameFromFullPath(&strBaseName, args.refstrOutputFile);
+
+	sPackage *dynarrPackages = NULL;
+	unsigned int numPackages = 0;
+	unsigned int iPkg;
+
+	sThreadPool pool;
+
+	startThreadPool(&pool, settings.options.numThreads);
+
+	if(args.refstrServe != NULL){
+		servePackages(&pool, args.refstrServe, &dynarrPackages, &numPackages);
+
+	}else{
+		addPackageTree(&dynarrPackages, &numPackages, &pool, args.refstrSourceDir, strBaseName, NULL);
+		cramDirtyPackages(&settings, &pool, dynarrPackages, numPackages);
+
+		if(settings.watch == TRUE)
+			watchPackages(&settings, &pool, &dynarrPackages, &numPackages);
 	}
 
+	stopThreadPool(&pool);
+
+	for(iPkg=0; iPkg < numPackages; ++iPkg)
+		cleanupPackage(&dynarrPackages[iPkg]);
+
+	SAFE_DELETE(dynarrPackages);
 	SAFE_DELETE(strBaseName);
 	SAFE_DELETE(strBaseOut);
-	SAFE_DELETE(subDirs);
 
 	LOG("Finished!\n");
+	stopLogger();
 	return 0;
 }
-
-
@@ -0,0 +1,290 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "texturepacker.h"
+#include "manbin.h"
+
+/*!\brief	Rounds up to where the next table can start. */
+static uint32_t alignBin(uint32_t pos){
+	return (pos + BINMAN_ALIGN -1) & ~(BINMAN_ALIGN -1);
+}
+
+/*!\brief	Writes a struct made only of uint32_t as little endian, whatever we're running on.
+ *!\return	Where the file is up to afterwards.
+ */
+static uint32_t writeBinWords(FILE *handFile, const void *refData, size_t size, uint32_t pos){
+	const uint32_t *refWords = (const uint32_t*)refData;
+	size_t i;
+
+	for(i=0; i < size / sizeof(uint32_t); ++i){
+		fputc((int)(refWords[i] & 0xFF), handFile);
+		fputc((int)((refWords[i] >> 8) & 0xFF), handFile);
+		fputc((int)((refWords[i] >> 16) & 0xFF), handFile);
+		fputc((int)((refWords[i] >> 24) & 0xFF), handFile);
+	}
+
+	return pos + (uint32_t)size;
+}
+
+/*!\brief	Pads with zeros up to the next table. */
+static uint32_t padBin(FILE *handFile, uint32_t pos){
+	for(; pos < alignBin(pos); ++pos)
+		fputc(0, handFile);
+
+	return pos;
+}
+
+/*!\brief	Names the manifest couldn't make are left empty, rather than leaving the entry out. */
+static const char* getBinName(char * const *refarrNames, unsigned int idx){
+	return (refarrNames != NULL && refarrNames[idx] != NULL) ? refarrNames[idx] : "";
+}
+
+/*!\brief	Sheets are always named by genMan, but just in case. */
+static const char* getBinSheetName(const sSheet *refSheet){
+	return (refSheet->name != NULL) ? refSheet->name : "";
+}
+
+/*!\brief	Writes a name into the string pool, with its null. */
+static void putBinName(FILE *handFile, const char *strName){
+	fputs(strName, handFile);
+	fputc(0, handFile);
+}
+
+/*!\brief	Gives the name its place in the string pool. */
+static uint32_t addBinName(const char *strName, uint32_t *pSizeStrings){
+	uint32_t offName = *pSizeStrings;
+
+	*pSizeStrings += (uint32_t)strlen(strName) +1;
+	return offName;
+}
+
+/*!\brief	Writes where the texture is on the sheets. */
+static uint32_t writeBinRect(FILE *handFile, uint32_t sheet, const sTex *refTex, uint32_t pos){
+	sBinManRect rect;
+
+	rect.sheet = sheet;
+	rect.x = refTex->x;	rect.y = refTex->y;
+	rect.w = refTex->w;	rect.h = refTex->h;
+	rect.rotated = (refTex->rotated == TRUE) ? 1 : 0;
+	return writeBinWords(handFile, &rect, sizeof(sBinManRect), pos);
+}
+
+errCode writeManifestInBin(FILE *handFile, const sManifest *writeMe, const sTex **refarrTexs){
+	sBinManHead head;	memset(&head, 0, sizeof(sBinManHead));
+	sTex const *refTex;
+	sTexSeq const *refSeq;
+	sFont const *refFnt;
+	uint32_t pos, idxRect, idxGlyph, idxKern, sizeStrings;
+	unsigned int i, j;
+
+	if(handFile == NULL || writeMe == NULL || refarrTexs == NULL)
+		return ERROR;
+
+	/** Count everything first, so the head can say where each table goes. */
+	head.numSheets = writeMe->refSheets->num;
+	head.numStills = writeMe->refStills->num;
+	head.numSeqs = writeMe->refSeqs->num;
+	head.numFonts = writeMe->refFonts->num;
+	head.numRects = writeMe->refStills->num;
+	head.numSeeds = writeMe->nameHash.numSeeds;
+	head.numSlots = writeMe->nameHash.numSlots;
+
+	for(i=0; i < writeMe->refSheets->num; ++i)
+		addBinName(getBinSheetName(writeMe->refSheets->dynarrSheets[i]), &head.sizeStrings);
+
+	for(i=0; i < writeMe->refStills->num; ++i)
+		addBinName(getBinName(writeMe->dynarrStrStillNames, i), &head.sizeStrings);
+
+	for(i=0; i < writeMe->refSeqs->num; ++i){
+		head.numRects += writeMe->refSeqs->dynarrSeqs[i].num;
+		addBinName(getBinName(writeMe->dynarrStrSeqNames, i), &head.sizeStrings);
+	}
+
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		head.numGlyphs += writeMe->refFonts->dynarrFonts[i]->num;
+		head.numRects += writeMe->refFonts->dynarrFonts[i]->num;
+		head.numKerns += writeMe->refFonts->dynarrFonts[i]->numKerning;
+		addBinName(getBinName(writeMe->dynarrStrFontNames, i), &head.sizeStrings);
+	}
+
+	head.magic = BINMAN_MAGIC;
+	head.version = BINMAN_VERSION;
+	head.sizeHead = sizeof(sBinManHead);
+	head.offSheets = alignBin(sizeof(sBinManHead));
+	head.offRects = alignBin(head.offSheets + head.numSheets * sizeof(sBinManSheet));
+	head.offStills = alignBin(head.offRects + head.numRects * sizeof(sBinManRect));
+	head.offSeqs = alignBin(head.offStills + head.numStills * sizeof(sBinManStill));
+	head.offFonts = alignBin(head.offSeqs + head.numSeqs * sizeof(sBinManSeq));
+	head.offGlyphs = alignBin(head.offFonts + head.numFonts * sizeof(sBinManFont));
+	head.offKerns = alignBin(head.offGlyphs + head.numGlyphs * sizeof(sBinManGlyph));
+	head.offSeeds = alignBin(head.offKerns + head.numKerns * sizeof(sBinManKern));
+	head.offSlots = alignBin(head.offSeeds + head.numSeeds * sizeof(int32_t));
+	head.offStrings = alignBin(head.offSlots + head.numSlots * sizeof(uint32_t));
+	head.sizeFile = head.offStrings + head.sizeStrings;
+
+	pos = writeBinWords(handFile, &head, sizeof(sBinManHead), 0);
+
+	/** Sheets */
+	sizeStrings = 0;
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refSheets->num; ++i){
+		sSheet const *refSheet = writeMe->refSheets->dynarrSheets[i];
+		sBinManSheet sheet;
+
+		sheet.name = addBinName(getBinSheetName(refSheet), &sizeStrings);
+		sheet.w = refSheet->w;
+		sheet.h = refSheet->h;
+		pos = writeBinWords(handFile, &sheet, sizeof(sBinManSheet), pos);
+	}
+
+	/** Rects, for the stills, then the sequence frames, then the glyphs. */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refStills->num; ++i)
+		pos = writeBinRect(handFile, writeMe->refStills->dynarrSheetIDs[i], refarrTexs[ writeMe->refStills->dynarrTexIDs[i] ], pos);
+
+	for(i=0; i < writeMe->refSeqs->num; ++i){
+		refSeq = &writeMe->refSeqs->dynarrSeqs[i];
+		for(j=0; j < refSeq->num; ++j)
+			pos = writeBinRect(handFile, refSeq->dynarrSheetIDs[j], refarrTexs[ refSeq->dynarrTexIDs[j] ], pos);
+	}
+
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->num; ++j)
+			pos = writeBinRect(handFile, refFnt->dynarrSheetIDs[j], refarrTexs[ refFnt->dynarrTexIDs[j] ], pos);
+	}
+
+	/** Stills */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refStills->num; ++i){
+		sBinManStill still;
+
+		still.name = addBinName(getBinName(writeMe->dynarrStrStillNames, i), &sizeStrings);
+		still.rect = i;
+		pos = writeBinWords(handFile, &still, sizeof(sBinManStill), pos);
+	}
+
+	/** Sequences */
+	idxRect = writeMe->refStills->num;
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refSeqs->num; ++i){
+		sBinManSeq seq;
+
+		refSeq = &writeMe->refSeqs->dynarrSeqs[i];
+		refTex = (refSeq->num > 0) ? refarrTexs[ refSeq->dynarrTexIDs[0] ] : NULL;
+		seq.name = addBinName(getBinName(writeMe->dynarrStrSeqNames, i), &sizeStrings);
+		seq.firstRect = idxRect;
+		seq.numFrames = refSeq->num;
+		seq.w = (refTex != NULL) ? refTex->w : 0;
+		seq.h = (refTex != NULL) ? refTex->h : 0;
+		pos = writeBinWords(handFile, &seq, sizeof(sBinManSeq), pos);
+
+		idxRect += refSeq->num;
+	}
+
+	/** Fonts */
+	idxGlyph = 0;
+	idxKern = 0;
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		sBinManFont font;
+
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		font.name = addBinName(getBinName(writeMe->dynarrStrFontNames, i), &sizeStrings);
+		font.firstGlyph = idxGlyph;
+		font.numGlyphs = refFnt->num;
+		font.sdfSpread = refFnt->sdfSpread;
+		font.colour = ((uint32_t)refFnt->colour[0] << 16) | ((uint32_t)refFnt->colour[1] << 8) | refFnt->colour[2];
+		font.firstKern = idxKern;
+		font.numKerns = refFnt->numKerning;
+		pos = writeBinWords(handFile, &font, sizeof(sBinManFont), pos);
+
+		idxGlyph += refFnt->num;
+		idxKern += refFnt->numKerning;
+	}
+
+	/** Glyphs, whose rects follow on from the sequence frames. */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->num; ++j){
+			sBinManGlyph glyph;
+
+			glyph.charcode = refFnt->dynarrCharcodes[j];
+			glyph.rect = idxRect++;
+			glyph.offsetY = refFnt->dynarrOffsetY[j];
+			glyph.advance = refFnt->dynarrMetrics[j].advance;
+			glyph.bearingX = refFnt->dynarrMetrics[j].bearingX;
+			glyph.bearingY = refFnt->dynarrMetrics[j].bearingY;
+			pos = writeBinWords(handFile, &glyph, sizeof(sBinManGlyph), pos);
+		}
+	}
+
+	/** Kerning */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->numKerning; ++j){
+			sBinManKern kern;
+
+			kern.left = refFnt->dynarrKerning[j].left;
+			kern.right = refFnt->dynarrKerning[j].right;
+			kern.amount = refFnt->dynarrKerning[j].amount;
+			pos = writeBinWords(handFile, &kern, sizeof(sBinManKern), pos);
+		}
+	}
+
+	/** Name lookup, see sNameHash. */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->nameHash.numSeeds; ++i){
+		uint32_t seed = (uint32_t)writeMe->nameHash.dynarrSeeds[i];
+		pos = writeBinWords(handFile, &seed, sizeof(uint32_t), pos);
+	}
+
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->nameHash.numSlots; ++i){
+		uint32_t slot = writeMe->nameHash.dynarrSlots[i];
+		pos = writeBinWords(handFile, &slot, sizeof(uint32_t), pos);
+	}
+
+	/** Strings, in the same order they were given their places. */
+	pos = padBin(handFile, pos);
+	for(i=0; i < writeMe->refSheets->num; ++i)
+		putBinName(handFile, getBinSheetName(writeMe->refSheets->dynarrSheets[i]));
+
+	for(i=0; i < writeMe->refStills->num; ++i)
+		putBinName(handFile, getBinName(writeMe->dynarrStrStillNames, i));
+
+	for(i=0; i < writeMe->refSeqs->num; ++i)
+		putBinName(handFile, getBinName(writeMe->dynarrStrSeqNames, i));
+
+	for(i=0; i < writeMe->refFonts->num; ++i)
+		putBinName(handFile, getBinName(writeMe->dynarrStrFontNames, i));
+
+	if(pos != head.offStrings || sizeStrings != head.sizeStrings){
+		WARN("Binary manifest tables didn't add up");
+		return ERROR;
+	}
+
+	if(ferror(handFile)){
+		WARN("Unable to write the binary manifest");
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
@@ -0,0 +1,164 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *	The layout of the binary manifest, written with '-f bin'. It has no dependencies, so it can be copied into
+ *	an engine that wants to map the file and use it in place.
+ *
+ *	Every value is a little endian uint32_t, so on a little endian machine the file can be cast straight to
+ *	these structs. The file starts with a sBinManHead, and each table it points to starts on a BINMAN_ALIGN
+ *	boundary from the start of the file. Names are offsets into the string pool, each ending in a null.
+ *	Stills, sequence frames and glyphs all refer to rects, and the frames of a sequence are consecutive rects.
+ *	A font's kerning pairs are consecutive too, and refer to its glyphs by where they are in the font.
+ *
+ *	Names can be found without building anything, with findBinMan below. It uses a minimal perfect hash: the seed
+ *	table is indexed by the hash of the name, and gives either the slot, or the seed to hash the name again with
+ *	to get the slot. Each slot holds an entry, counting stills, then sequences, then fonts.
+ *
+ */
+
+#ifndef MANBIN_H
+#define MANBIN_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define BINMAN_MAGIC	0x4B415054u	/*!< "TPAK" when read as bytes. */
+#define BINMAN_VERSION	6u
+#define BINMAN_ALIGN	16u
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Where each table is, in bytes from the start of the file, and how many entries it has. */
+typedef struct defBinManHead{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sizeFile;	/*!< So a truncated file can be spotted. */
+	uint32_t sizeHead;	/*!< Later versions only add to the end of the head. */
+
+	uint32_t numSheets, offSheets;
+	uint32_t numRects, offRects;
+	uint32_t numStills, offStills;
+	uint32_t numSeqs, offSeqs;
+	uint32_t numFonts, offFonts;
+	uint32_t numGlyphs, offGlyphs;
+	uint32_t sizeStrings, offStrings;
+	uint32_t numSeeds, offSeeds;	/*!< The seeds are int32_t. Added in version 2. */
+	uint32_t numSlots, offSlots;
+	uint32_t numKerns, offKerns;	/*!< Added in version 5. */
+} sBinManHead;
+
+typedef struct defBinManSheet{
+	uint32_t name;	/*!< The PNG, without the extension. */
+	uint32_t w, h;
+} sBinManSheet;
+
+/*!\brief	Where an image is on the sheets. */
+typedef struct defBinManRect{
+	uint32_t sheet;
+	uint32_t x, y, w, h;	/*!< The size is the image's own, even when it's turned. */
+	uint32_t rotated;	/*!< Non zero if the image is turned a quarter turn clockwise, so it covers h across and w down. Added in version 6. */
+} sBinManRect;
+
+typedef struct defBinManStill{
+	uint32_t name;
+	uint32_t rect;
+} sBinManStill;
+
+/*!\brief	Empty sequences and fonts are kept, so the entries line up with the other manifests. */
+typedef struct defBinManSeq{
+	uint32_t name;
+	uint32_t firstRect;
+	uint32_t numFrames;
+	uint32_t w, h;	/*!< Size of the first frame. */
+} sBinManSeq;
+
+typedef struct defBinManFont{
+	uint32_t name;
+	uint32_t firstGlyph;
+	uint32_t numGlyphs;
+	uint32_t sdfSpread;	/*!< Non zero if the glyphs are signed distance fields. Added in version 3. */
+	uint32_t colour;	/*!< 0xRRGGBB to tint the glyphs with, as they're white on the sheets. Added in version 4. */
+	uint32_t firstKern;	/*!< Added in version 5. */
+	uint32_t numKerns;
+} sBinManFont;
+
+/*!\brief	Glyphs of a font are in the order they were rendered in. Spaces and other glyphs with nothing to draw are a
+ *!		single clear pixel, so their advance is there.
+ */
+typedef struct defBinManGlyph{
+	uint32_t charcode;
+	uint32_t rect;
+	uint32_t offsetY;
+	int32_t advance;	/*!< In pixels on the sheet, as are the bearings. Added in version 5. */
+	int32_t bearingX;	/*!< From the pen to the left of the rect. */
+	int32_t bearingY;	/*!< From the baseline up to the top of the rect. */
+} sBinManGlyph;
+
+/*!\brief	Add the amount to the left glyph's advance when the right one follows it. Sorted by left, then right. */
+typedef struct defBinManKern{
+	uint32_t left, right;	/*!< Glyphs of the font, counting from its first. */
+	int32_t amount;
+} sBinManKern;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	The hash the seed and slot tables were made with. */
+static inline uint32_t hashBinMan(uint32_t seed, const char *strName){
+	uint32_t h = 2166136261u ^ seed;
+
+	for(; *strName != '\0'; ++strName){
+		h ^= (unsigned char)*strName;
+		h *= 16777619u;
+	}
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+
+	return h & 0x7FFFFFFFu;
+}
+
+/*!\brief	Finds a still, sequence or font by name, in a manifest that's been mapped into memory.
+ *!\return	The entry, counting stills, then sequences, then fonts. Negative if there's nothing with that name.
+ */
+static inline int32_t findBinMan(const void *refFile, const char *strName){
+	const char *refBytes = (const char*)refFile;
+	const sBinManHead *refHead = (const sBinManHead*)refFile;
+	const int32_t *refSeeds = (const int32_t*)(refBytes + refHead->offSeeds);
+	const uint32_t *refSlots = (const uint32_t*)(refBytes + refHead->offSlots);
+	const char *refStrings = refBytes + refHead->offStrings;
+	uint32_t entry, offName;
+	int32_t seed;
+
+	if(refHead->numSlots == 0)
+		return -1;
+
+	seed = refSeeds[ hashBinMan(0, strName) % refHead->numSeeds ];
+	entry = refSlots[ (seed < 0) ? (uint32_t)(-seed -1) : hashBinMan((uint32_t)seed, strName) % refHead->numSlots ];
+
+	if(entry < refHead->numStills)
+		offName = ((const sBinManStill*)(refBytes + refHead->offStills))[entry].name;
+	else if(entry < refHead->numStills + refHead->numSeqs)
+		offName = ((const sBinManSeq*)(refBytes + refHead->offSeqs))[entry - refHead->numStills].name;
+	else
+		offName = ((const sBinManFont*)(refBytes + refHead->offFonts))[entry - refHead->numStills - refHead->numSeqs].name;
+
+	return (strcmp(&refStrings[offName], strName) == 0) ? (int32_t)entry : -1;
+}
+
+#endif
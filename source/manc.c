@@ -22,47 +22,245 @@
 #include "texturepacker.h"
 #include "squarefit.h"
 
-errCode writeManifestInC(const char *manPath, const sManifest *writeMe, const sTex **refarrTexs){
+#include <ctype.h>
 
-#if 0
-	static const char *STRUCT_SHEET="sSheet";
-	//static const char *STRUCT = "struct";
-	static const char *CONST = "const";
-	static const char *NEW_LINE="\n";
+/*!\brief	Shared by every manifest, so a game can include more than one. */
+static const char *C_TYPES =
+	"#ifndef TPAK_MANIFEST_TYPES\n"
+	"#define TPAK_MANIFEST_TYPES\n"
+	"\n"
+	"typedef struct tpakSheet{ const char *name; uint32_t w, h; } tpakSheet;\n"
+	"typedef struct tpakRect{ uint32_t sheet, x, y, w, h, rotated; } tpakRect;\n"
+	"typedef struct tpakSeq{ uint32_t firstRect, numFrames, w, h; } tpakSeq;\n"
+	"typedef struct tpakFont{ uint32_t firstGlyph, numGlyphs, sdfSpread, colour, firstKern, numKerns; } tpakFont;\n"
+	"typedef struct tpakGlyph{ uint32_t charcode, rect, offsetY; int32_t advance, bearingX, bearingY; } tpakGlyph;\n"
+	"typedef struct tpakKern{ uint32_t left, right; int32_t amount; } tpakKern;\n"
+	"\n"
+	"%s uint32_t tpakHashName(uint32_t seed, const char *name){\n"
+	"\tuint32_t h = 2166136261u ^ seed;\n"
+	"\tfor(; *name != '\\0'; ++name){ h ^= (unsigned char)*name; h *= 16777619u; }\n"
+	"\th ^= h >> 16; h *= 0x85EBCA6Bu; h ^= h >> 13; h *= 0xC2B2AE35u; h ^= h >> 16;\n"
+	"\treturn h & 0x7FFFFFFFu;\n"
+	"}\n"
+	"\n"
+	"%s int tpakSameName(const char *a, const char *b){\n"
+	"\twhile(*a != '\\0' && *a == *b){ ++a; ++b; }\n"
+	"\treturn *a == *b;\n"
+	"}\n"
+	"\n"
+	"#endif\n"
+	"\n";
 
-	FILE *handFile = fopen(manPath, "w");
+/*!\brief	Names that turned up more than once get their entry added, so the enums still compile. */
+static void writeEnumName(FILE *handFile, const char *strMan, const char *strKind, const char *strName, const sNameHash *refHash, unsigned int entry){
+	if(findNameHash(refHash, strName) == (int)entry)
+		fprintf(handFile, "\t%s_%s_%s = %u,\n", strMan, strKind, strName, entry);
+	else
+		fprintf(handFile, "\t%s_%s_%s_%u = %u,\n", strMan, strKind, strName, entry, entry);
+}
+
+errCode writeManifestInC(FILE *handFile, const char *strName, bool cpp, const sManifest *writeMe, const sTex **refarrTexs){
+	static const size_t LENBUFF = 128;
+
+	const char *STORE = (cpp == TRUE) ? "static constexpr" : "static const";
+	const char *FOO = (cpp == TRUE) ? "constexpr" : "static inline";
+	char strMan[ LENBUFF ];
+	char strGuard[ LENBUFF ];
+	sTex const *refTex;
+	sTexSeq const *refSeq;
+	sFont const *refFnt;
+	unsigned int i, j, idxRect, idxGlyph, idxKern;
+	unsigned int numStills, numSeqs, numGlyphs = 0, numKerns = 0;
+
+	if(handFile == NULL || strName == NULL || writeMe == NULL || refarrTexs == NULL)
+		return ERROR;
+
+	strncpy(strMan, strName, LENBUFF -1);
+	strMan[LENBUFF -1] = '\0';
+	sanitiseString(strMan);
+
+	for(i=0; strMan[i] != '\0'; ++i)
+		strGuard[i] = (char)toupper((unsigned char)strMan[i]);
+	strGuard[i] = '\0';
+
+	numStills = writeMe->refStills->num;
+	numSeqs = writeMe->refSeqs->num;
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		numGlyphs += writeMe->refFonts->dynarrFonts[i]->num;
+		numKerns += writeMe->refFonts->dynarrFonts[i]->numKerning;
+	}
+
+	fprintf(handFile, "/* Made by tpak, changes will be lost the next time it's packed. */\n\n");
+	fprintf(handFile, "#ifndef TPAK_%s_H\n#define TPAK_%s_H\n\n", strGuard, strGuard);
+	fprintf(handFile, "#include <stdint.h>\n\n");
+	fprintf(handFile, C_TYPES, FOO, FOO);
+
+	/** Enums, so the game can refer to everything without a lookup. Stills are the first rects, so a still's enum is its rect. */
+	fprintf(handFile, "enum{ %s_SHEET_COUNT = %u };\n\n", strMan, writeMe->refSheets->num);
 
-	if(handFile==NULL)
-		return PROBLEM;
+	fprintf(handFile, "enum %s_still{\n", strMan);
+	for(i=0; i < numStills; ++i)
+		writeEnumName(handFile, strMan, "still", writeMe->dynarrStrStillNames[i], &writeMe->nameHash, i);
+	fprintf(handFile, "\t%s_STILL_COUNT = %u\n};\n\n", strMan, numStills);
 
-	if(writeMe->dynarrSheets != NULL){
-		sSheet **itrSheet;
+	fprintf(handFile, "enum %s_seq{\n", strMan);
+	for(i=0; i < numSeqs; ++i){
+		if(writeMe->dynarrStrSeqNames[i] != NULL)
+			writeEnumName(handFile, strMan, "seq", writeMe->dynarrStrSeqNames[i], &writeMe->nameHash, numStills + i);
+	}
+	fprintf(handFile, "\t%s_SEQ_COUNT = %u\n};\n\n", strMan, numSeqs);
+
+	fprintf(handFile, "enum %s_font{\n", strMan);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		if(writeMe->dynarrStrFontNames[i] != NULL)
+			writeEnumName(handFile, strMan, "font", writeMe->dynarrStrFontNames[i], &writeMe->nameHash, numStills + numSeqs + i);
+	}
+	fprintf(handFile, "\t%s_FONT_COUNT = %u\n};\n\n", strMan, writeMe->refFonts->num);
+
+	/** Entries count stills, then sequences, then fonts. These turn an entry into where to look. */
+	fprintf(handFile, "#define %s_SEQ(entry) ((entry) - %s_STILL_COUNT)\n", strMan, strMan);
+	fprintf(handFile, "#define %s_FONT(entry) ((entry) - %s_STILL_COUNT - %s_SEQ_COUNT)\n\n", strMan, strMan, strMan);
+
+	/** Sheets */
+	fprintf(handFile, "%s tpakSheet %s_sheets[] = {\n", STORE, strMan);
+	for(i=0; i < writeMe->refSheets->num; ++i){
+		sSheet const *refSheet = writeMe->refSheets->dynarrSheets[i];
+		fprintf(handFile, "\t{\"%s\", %u, %u},\n", refSheet->name, refSheet->w, refSheet->h);
+	}
+	if(writeMe->refSheets->num == 0)
+		fprintf(handFile, "\t{\"\", 0, 0}\n");
+	fprintf(handFile, "};\n\n");
 
-		fprintf(handFile,
-			"struct de%s{%s\tunsigned int w;%s\tunsigned int h;%s} %s;%s",
-			STRUCT_SHEET, NEW_LINE, NEW_LINE, NEW_LINE, STRUCT_SHEET, NEW_LINE
+	/** Rects, for the stills, then the sequence frames, then the glyphs. */
+	fprintf(handFile, "%s tpakRect %s_rects[] = {\n", STORE, strMan);
+	for(i=0; i < numStills; ++i){
+		refTex = refarrTexs[ writeMe->refStills->dynarrTexIDs[i] ];
+		fprintf(handFile, "\t{%u, %u, %u, %u, %u, %u},\n",
+			writeMe->refStills->dynarrSheetIDs[i], refTex->x, refTex->y, refTex->w, refTex->h, (refTex->rotated == TRUE) ? 1 : 0
 		);
+	}
 
-		fprintf(handFile, "%s %s arrSheet[] = {%s", CONST, STRUCT_SHEET, NEW_LINE);
-		for(itrSheet=writeMe->dynarrSheets; (*itrSheet) != NULL; ++itrSheet)
-			fprintf(handFile, "\t{%i, %i}%c;%s",
-				(*itrSheet)->w, (*itrSheet)->h,
-				(itrSheet+1)!=NULL ? ',' : ' ',
-				NEW_LINE
+	idxRect = numStills;
+	for(i=0; i < numSeqs; ++i){
+		refSeq = &writeMe->refSeqs->dynarrSeqs[i];
+		for(j=0; j < refSeq->num; ++j){
+			refTex = refarrTexs[ refSeq->dynarrTexIDs[j] ];
+			fprintf(handFile, "\t{%u, %u, %u, %u, %u, %u},\n",
+				refSeq->dynarrSheetIDs[j], refTex->x, refTex->y, refTex->w, refTex->h, (refTex->rotated == TRUE) ? 1 : 0
 			);
-		fprintf(handFile, "};%s%s", NEW_LINE, NEW_LINE);
+		}
+		idxRect += refSeq->num;
+	}
 
-	}else{
-		fclose(handFile);
-		return PROBLEM;
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->num; ++j){
+			refTex = refarrTexs[ refFnt->dynarrTexIDs[j] ];
+			fprintf(handFile, "\t{%u, %u, %u, %u, %u, %u},\n",
+				refFnt->dynarrSheetIDs[j], refTex->x, refTex->y, refTex->w, refTex->h, (refTex->rotated == TRUE) ? 1 : 0
+			);
+		}
 	}
+	if(idxRect + numGlyphs == 0)
+		fprintf(handFile, "\t{0, 0, 0, 0, 0, 0}\n");
+	fprintf(handFile, "};\n\n");
 
-	if(writeMe->dynarrSequences != NULL){
-		//sSequence **itrSeq;
+	/** Sequences */
+	fprintf(handFile, "%s tpakSeq %s_seqs[] = {\n", STORE, strMan);
+	idxRect = numStills;
+	for(i=0; i < numSeqs; ++i){
+		refSeq = &writeMe->refSeqs->dynarrSeqs[i];
+		refTex = (refSeq->num > 0) ? refarrTexs[ refSeq->dynarrTexIDs[0] ] : NULL;
+		fprintf(handFile, "\t{%u, %u, %u, %u},\n",
+			idxRect, refSeq->num, (refTex != NULL) ? refTex->w : 0, (refTex != NULL) ? refTex->h : 0
+		);
+		idxRect += refSeq->num;
+	}
+	if(numSeqs == 0)
+		fprintf(handFile, "\t{0, 0, 0, 0}\n");
+	fprintf(handFile, "};\n\n");
+
+	/** Fonts, and their glyphs, whose rects follow on from the sequence frames. */
+	fprintf(handFile, "%s tpakFont %s_fonts[] = {\n", STORE, strMan);
+	idxGlyph = 0;
+	idxKern = 0;
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		fprintf(handFile, "\t{%u, %u, %u, 0x%02X%02X%02Xu, %u, %u},\n",
+			idxGlyph, refFnt->num, refFnt->sdfSpread, refFnt->colour[0], refFnt->colour[1], refFnt->colour[2],
+			idxKern, refFnt->numKerning
+		);
+		idxGlyph += refFnt->num;
+		idxKern += refFnt->numKerning;
+	}
+	if(writeMe->refFonts->num == 0)
+		fprintf(handFile, "\t{0, 0, 0, 0, 0, 0}\n");
+	fprintf(handFile, "};\n\n");
+
+	fprintf(handFile, "%s tpakGlyph %s_glyphs[] = {\n", STORE, strMan);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->num; ++j){
+			fprintf(handFile, "\t{%u, %u, %u, %i, %i, %i},\n",
+				refFnt->dynarrCharcodes[j], idxRect++, refFnt->dynarrOffsetY[j],
+				refFnt->dynarrMetrics[j].advance, refFnt->dynarrMetrics[j].bearingX, refFnt->dynarrMetrics[j].bearingY
+			);
+		}
+	}
+	if(numGlyphs == 0)
+		fprintf(handFile, "\t{0, 0, 0, 0, 0, 0}\n");
+	fprintf(handFile, "};\n\n");
+
+	/** Kerning, by where the glyphs are in their font, sorted by the left glyph then the right. */
+	fprintf(handFile, "%s tpakKern %s_kerns[] = {\n", STORE, strMan);
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		for(j=0; j < refFnt->numKerning; ++j){
+			fprintf(handFile, "\t{%u, %u, %i},\n",
+				refFnt->dynarrKerning[j].left, refFnt->dynarrKerning[j].right, refFnt->dynarrKerning[j].amount
+			);
+		}
 	}
+	if(numKerns == 0)
+		fprintf(handFile, "\t{0, 0, 0}\n");
+	fprintf(handFile, "};\n\n");
+
+	/** Name lookup, see sNameHash. */
+	fprintf(handFile, "%s char * const %s_names[] = {\n", (cpp == TRUE) ? "static constexpr const" : "static const", strMan);
+	for(i=0; i < numStills; ++i)
+		fprintf(handFile, "\t\"%s\",\n", writeMe->dynarrStrStillNames[i]);
+	for(i=0; i < numSeqs; ++i)
+		fprintf(handFile, "\t\"%s\",\n", (writeMe->dynarrStrSeqNames[i] != NULL) ? writeMe->dynarrStrSeqNames[i] : "");
+	for(i=0; i < writeMe->refFonts->num; ++i)
+		fprintf(handFile, "\t\"%s\",\n", (writeMe->dynarrStrFontNames[i] != NULL) ? writeMe->dynarrStrFontNames[i] : "");
+	if(numStills + numSeqs + writeMe->refFonts->num == 0)
+		fprintf(handFile, "\t\"\"\n");
+	fprintf(handFile, "};\n\n");
+
+	fprintf(handFile, "%s int32_t %s_nameSeeds[] = {", STORE, strMan);
+	for(i=0; i < writeMe->nameHash.numSeeds; ++i)
+		fprintf(handFile, "%i,", writeMe->nameHash.dynarrSeeds[i]);
+	fprintf(handFile, "%s};\n", (writeMe->nameHash.numSeeds == 0) ? "0" : "");
+
+	fprintf(handFile, "%s uint32_t %s_nameSlots[] = {", STORE, strMan);
+	for(i=0; i < writeMe->nameHash.numSlots; ++i)
+		fprintf(handFile, "%u,", writeMe->nameHash.dynarrSlots[i]);
+	fprintf(handFile, "%s};\n\n", (writeMe->nameHash.numSlots == 0) ? "0" : "");
+
+	fprintf(handFile, "/* The entry with that name, counting stills, then sequences, then fonts. -1 if there isn't one. */\n");
+	fprintf(handFile, "%s int32_t %s_find(const char *name){\n", FOO, strMan);
+	if(writeMe->nameHash.numSlots > 0){
+		fprintf(handFile, "\tconst int32_t seed = %s_nameSeeds[ tpakHashName(0, name) %% %uu ];\n", strMan, writeMe->nameHash.numSeeds);
+		fprintf(handFile, "\tconst uint32_t entry = %s_nameSlots[ (seed < 0) ? (uint32_t)(-seed -1) : tpakHashName((uint32_t)seed, name) %% %uu ];\n",
+			strMan, writeMe->nameHash.numSlots
+		);
+		fprintf(handFile, "\treturn tpakSameName(%s_names[entry], name) ? (int32_t)entry : -1;\n", strMan);
+	}else{
+		fprintf(handFile, "\treturn ((void)name, -1);\n");
+	}
+	fprintf(handFile, "}\n\n");
+
+	fprintf(handFile, "#endif\n");
 
-	fclose(handFile);
-#endif
 	return NOPROB;
 }
-
@@ -24,7 +24,8 @@
 #include "texturepacker.h"
 
 errCode writeManifestInJava(
-	const char *manPath,
+	FILE *handFile,
+	const char *strClassName,
 	const char *javapakName,
 	const char *refstrClass,
 	const sManifest *writeMe,
@@ -38,14 +39,8 @@ errCode writeManifestInJava(
 	unsigned int i, j;
 	sTex const *refTex;
 
-	FILE *handFile = NULL;
-	{
-		char *buff = (char*)calloc(strlen(manPath)+strlen(".java")+1, sizeof(char));
-		sprintf(buff, "%s.java", manPath);
-
-		handFile = fopen(buff, "w");
-		free(buff);
-	}
+	if(handFile == NULL || strClassName == NULL)
+		return ERROR;
 
 	if(javapakName != NULL)
 		fprintf(handFile, "package %s;%s%s", javapakName, NEW_LINE, NEW_LINE);
@@ -53,12 +48,7 @@ errCode writeManifestInJava(
 	fprintf(handFile, "import java.util.Map;%s%s", NEW_LINE, NEW_LINE);
 	fprintf(handFile, "import java.util.HashMap;%s%s", NEW_LINE, NEW_LINE);
 
-	{
-		char *buff=NULL;
-		getOutputNameFromFullPath(&buff, manPath);
-		fprintf(handFile, "public class %s {%s", buff, NEW_LINE);
-		free(buff);
-	}
+	fprintf(handFile, "public class %s {%s", strClassName, NEW_LINE);
 
 	/*** sheets ***/
 	fprintf(handFile, "%s%s%s Sheet {%s", NEW_LINE, TAB, CLASS, NEW_LINE);
@@ -90,7 +80,8 @@ errCode writeManifestInJava(
 
 	fprintf(handFile, "%s%spublic final Sheet mSheet;%s", TAB, TAB, NEW_LINE);
 	fprintf(handFile, "%s%spublic final int x, y, w, h;%s", TAB, TAB, NEW_LINE);
-	fprintf(handFile,  "%s%s%spublic Still(Sheet pSheet, int px, int py, int pw, int ph){ mSheet=pSheet; x=px; y=py; w=pw; h=ph; }%s%s",
+	fprintf(handFile, "%s%spublic final boolean rotated; /** Turned a quarter turn clockwise on the sheet, so it covers h across and w down. */%s", TAB, TAB, NEW_LINE);
+	fprintf(handFile,  "%s%s%spublic Still(Sheet pSheet, int px, int py, int pw, int ph, boolean pRotated){ mSheet=pSheet; x=px; y=py; w=pw; h=ph; rotated=pRotated; }%s%s",
 		NEW_LINE, TAB, TAB, NEW_LINE, NEW_LINE
 	);
 
@@ -108,10 +99,10 @@ errCode writeManifestInJava(
 		if(refTex->name == NULL)	/* ignore entries that were blanked for not being convertable */
 			continue;
 
-		fprintf(handFile, "%s%s%s Still %s = new Still(sheet%i, %i, %i, %i, %i);%s",
+		fprintf(handFile, "%s%s%s Still %s = new Still(sheet%i, %i, %i, %i, %i, %s);%s",
 			TAB, TAB, ENTRY, writeMe->dynarrStrStillNames[i],
 			writeMe->refStills->dynarrSheetIDs[i], 
-			refTex->x, refTex->y, refTex->w, refTex->h,
+			refTex->x, refTex->y, refTex->w, refTex->h, (refTex->rotated == TRUE) ? "true" : "false",
 			NEW_LINE
 		);
 	}
@@ -133,8 +124,9 @@ errCode writeManifestInJava(
 
 	fprintf(handFile, "%s%s%spublic final Sheet mSheet;%s", TAB, TAB, TAB, NEW_LINE);
 	fprintf(handFile, "%s%s%spublic final int x, y;%s", TAB, TAB, TAB, NEW_LINE);
+	fprintf(handFile, "%s%s%spublic final boolean rotated;%s", TAB, TAB, TAB, NEW_LINE);
 	fprintf(handFile,
-		"%s%s%spublic Frame(Sheet pSheet, int px, int py) { mSheet=pSheet; x=px; y=py; }%s",
+		"%s%s%spublic Frame(Sheet pSheet, int px, int py, boolean pRotated) { mSheet=pSheet; x=px; y=py; rotated=pRotated; }%s",
 		TAB, TAB, TAB, NEW_LINE
 	);
 	fprintf(handFile, "%s%s}%s", TAB, TAB, NEW_LINE);
@@ -169,9 +161,9 @@ errCode writeManifestInJava(
 			for(j=0; j < refSeq->num; ++j){ 
 				refTex = refarrTexs[ refSeq->dynarrTexIDs[j] ];
 
-				fprintf(handFile, "%s%s%snew Frame(sheet%i, %i, %i),%s",
+				fprintf(handFile, "%s%s%snew Frame(sheet%i, %i, %i, %s),%s",
 					TAB, TAB, TAB,
-					refSeq->dynarrSheetIDs[j], refTex->x, refTex->y,
+					refSeq->dynarrSheetIDs[j], refTex->x, refTex->y, (refTex->rotated == TRUE) ? "true" : "false",
 					NEW_LINE
 				);
 			}
@@ -203,15 +195,16 @@ errCode writeManifestInJava(
 		TAB, TAB, TAB, NEW_LINE
 	);
 	fprintf(handFile,
-		"%s%s%spublic final int ccode, x, y, w, h, offsetY;%s", 
+		"%s%s%spublic final int ccode, x, y, w, h, offsetY, advance, bearingX, bearingY;%s", 
 		TAB, TAB, TAB, NEW_LINE
 	);
+	fprintf(handFile, "%s%s%spublic final boolean rotated;%s", TAB, TAB, TAB, NEW_LINE);
 	fprintf(handFile,
-		"%s%s%spublic Glyph(Sheet pSheet, int pCCode, int px, int py, int pw, int ph, int pOY)%s",
+		"%s%s%spublic Glyph(Sheet pSheet, int pCCode, int px, int py, int pw, int ph, int pOY, int pAdv, int pBX, int pBY, boolean pRotated)%s",
 		TAB, TAB, TAB, NEW_LINE
 	);
 	fprintf(handFile,
-		"%s%s%s%s{ mSheet=pSheet; ccode=pCCode; x=px; y=py; w=pw; h=ph; offsetY=pOY; }%s",
+		"%s%s%s%s{ mSheet=pSheet; ccode=pCCode; x=px; y=py; w=pw; h=ph; offsetY=pOY; advance=pAdv; bearingX=pBX; bearingY=pBY; rotated=pRotated; }%s",
 		TAB, TAB, TAB, TAB, NEW_LINE
 	);
 	fprintf(handFile, "%s%s}%s%s", TAB, TAB, NEW_LINE, NEW_LINE);
@@ -221,10 +214,13 @@ errCode writeManifestInJava(
 	fprintf(handFile, "%s%spublic Glyph glyphs[];%s", TAB, TAB, NEW_LINE);
 	fprintf(handFile, "%s%spublic Map<Integer, %s> mapped;%s", TAB, TAB, refstrClass, NEW_LINE);
 	fprintf(handFile, "%s%spublic Map<Integer, Integer> yOffsets;%s", TAB, TAB, NEW_LINE);
+	fprintf(handFile, "%s%spublic final int sdfSpread; /** Non zero if the glyphs are signed distance fields. */%s", TAB, TAB, NEW_LINE);
+	fprintf(handFile, "%s%spublic final int colour; /** 0xRRGGBB to tint the glyphs with, as they're white on the sheets. */%s", TAB, TAB, NEW_LINE);
+	fprintf(handFile, "%s%spublic final int kerning[]; /** Left glyph, right glyph and amount for each pair, sorted by left then right. */%s", TAB, TAB, NEW_LINE);
 	fprintf(handFile,
-		"%s%spublic Font(Glyph pGlyphs[]) {\
- glyphs = pGlyphs.clone(); mapped = new HashMap<Integer, %s>(); yOffsets = new HashMap<Integer, Integer>();\
- }%s",
+		"%s%spublic Font(Glyph pGlyphs[], int pSdfSpread, int pColour, int pKerning[]) {\
+ glyphs = pGlyphs.clone(); mapped = new HashMap<Integer, %s>(); yOffsets = new HashMap<Integer, Integer>(); sdfSpread = pSdfSpread; colour = pColour;\
+ kerning = pKerning; }%s",
 		TAB, TAB, refstrClass, NEW_LINE
 	);
 
@@ -249,26 +245,372 @@ errCode writeManifestInJava(
 			);
 			for(j=0; j < refFnt->num; ++j){
 				refTex = refarrTexs[ refFnt->dynarrTexIDs[j] ];
-				fprintf(handFile, "%s%s%snew Glyph(sheet%i, %i, %i, %i, %i, %i, %i),%s",
+				fprintf(handFile, "%s%s%snew Glyph(sheet%i, %i, %i, %i, %i, %i, %i, %i, %i, %i, %s),%s",
 					TAB, TAB, TAB,
 					refFnt->dynarrSheetIDs[j],
 					refFnt->dynarrCharcodes[j],
 					refTex->x, refTex->y, refTex->w, refTex->h, refFnt->dynarrOffsetY[j],
+					refFnt->dynarrMetrics[j].advance, refFnt->dynarrMetrics[j].bearingX, refFnt->dynarrMetrics[j].bearingY,
+					(refTex->rotated == TRUE) ? "true" : "false",
 					NEW_LINE
 				);
 			}
 			fprintf(handFile, "%s%s};%s", TAB, TAB, NEW_LINE);
-			fprintf(handFile, "%s%s%s Font  %s = new Font(glyphsFor_%s);%s",
-				 TAB, TAB, ENTRY, writeMe->dynarrStrFontNames[i], writeMe->dynarrStrFontNames[i], NEW_LINE
+			fprintf(handFile, "%s%sprivate static int kerningFor_%s [] ={", TAB, TAB, writeMe->dynarrStrFontNames[i]);
+			for(j=0; j < refFnt->numKerning; ++j){
+				fprintf(handFile, "%u,%u,%i,",
+					refFnt->dynarrKerning[j].left, refFnt->dynarrKerning[j].right, refFnt->dynarrKerning[j].amount
+				);
+			}
+			fprintf(handFile, "};%s", NEW_LINE);
+			fprintf(handFile, "%s%s%s Font  %s = new Font(glyphsFor_%s, %u, 0x%02X%02X%02X, kerningFor_%s);%s",
+				 TAB, TAB, ENTRY, writeMe->dynarrStrFontNames[i], writeMe->dynarrStrFontNames[i], refFnt->sdfSpread,
+				 refFnt->colour[0], refFnt->colour[1], refFnt->colour[2], writeMe->dynarrStrFontNames[i], NEW_LINE
 			);
 		}
 	}
 
 	fprintf(handFile, "%s}%s", TAB, NEW_LINE);
 
+	/*** name lookup, see sNameHash ***/
+	{
+		const sNameHash *refHash = &writeMe->nameHash;
+		unsigned int entry;
+
+		fprintf(handFile, "%s%sprivate static final int[] NAME_SEEDS = {", NEW_LINE, TAB);
+		for(i=0; i < refHash->numSeeds; ++i)
+			fprintf(handFile, "%i,", refHash->dynarrSeeds[i]);
+		fprintf(handFile, "};%s", NEW_LINE);
+
+		fprintf(handFile, "%sprivate static final String[] NAME_SLOTS = {", TAB);
+		for(i=0; i < refHash->numSlots; ++i){
+			entry = refHash->dynarrSlots[i];
+			if(entry < writeMe->refStills->num)
+				fprintf(handFile, "\"%s\",", writeMe->dynarrStrStillNames[entry]);
+			else if(entry < writeMe->refStills->num + writeMe->refSeqs->num)
+				fprintf(handFile, "\"%s\",", writeMe->dynarrStrSeqNames[entry - writeMe->refStills->num]);
+			else
+				fprintf(handFile, "\"%s\",", writeMe->dynarrStrFontNames[entry - writeMe->refStills->num - writeMe->refSeqs->num]);
+		}
+		fprintf(handFile, "};%s", NEW_LINE);
+
+		fprintf(handFile, "%sprivate static final Object[] NAME_ENTRIES = {", TAB);
+		for(i=0; i < refHash->numSlots; ++i){
+			entry = refHash->dynarrSlots[i];
+			if(entry < writeMe->refStills->num)
+				fprintf(handFile, "Still.%s,", writeMe->dynarrStrStillNames[entry]);
+			else if(entry < writeMe->refStills->num + writeMe->refSeqs->num)
+				fprintf(handFile, "Sequence.%s,", writeMe->dynarrStrSeqNames[entry - writeMe->refStills->num]);
+			else
+				fprintf(handFile, "Font.%s,", writeMe->dynarrStrFontNames[entry - writeMe->refStills->num - writeMe->refSeqs->num]);
+		}
+		fprintf(handFile, "};%s%s", NEW_LINE, NEW_LINE);
+
+		fprintf(handFile, "%sprivate static int hashName(int seed, String name){%s", TAB, NEW_LINE);
+		fprintf(handFile, "%s%sint h = 0x811C9DC5 ^ seed;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sfor(byte b : name.getBytes(java.nio.charset.StandardCharsets.UTF_8)){ h ^= b & 0xFF; h *= 16777619; }%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sh ^= h >>> 16; h *= 0x85EBCA6B; h ^= h >>> 13; h *= 0xC2B2AE35; h ^= h >>> 16;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sreturn h & 0x7FFFFFFF;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s}%s%s", TAB, NEW_LINE, NEW_LINE);
+
+		fprintf(handFile, "%s/** The Still, Sequence or Font with that name, or null. */%s", TAB, NEW_LINE);
+		fprintf(handFile, "%spublic static Object find(String name){%s", TAB, NEW_LINE);
+		fprintf(handFile, "%s%sif(NAME_SLOTS.length == 0) return null;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sint seed = NAME_SEEDS[hashName(0, name) %% NAME_SEEDS.length];%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sint slot = (seed < 0) ? -seed -1 : hashName(seed, name) %% NAME_SLOTS.length;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s%sreturn name.equals(NAME_SLOTS[slot]) ? NAME_ENTRIES[slot] : null;%s", TAB, TAB, NEW_LINE);
+		fprintf(handFile, "%s}%s", TAB, NEW_LINE);
+	}
+
 	/*** end man ***/
 	fprintf(handFile, "}%s", NEW_LINE );
 
 	return NOPROB;
 }
 
+
+/*!\brief	How long the UTF-8 string is once it's a java string, which counts UTF-16 units rather than bytes. */
+static unsigned int lenJavaString(const char *strUtf8){
+	const unsigned char *itr;
+	unsigned int len = 0;
+
+	for(itr = (const unsigned char*)strUtf8; *itr != '\0'; ++itr){
+		if((*itr & 0xC0) == 0x80)	/** Carries on the char before. */
+			continue;
+
+		len += (*itr >= 0xF0) ? 2 : 1;	/** Past the basic plane it takes a surrogate pair. */
+	}
+
+	return len;
+}
+
+/*!\brief	Writes a char of a java string literal, escaped so the compiler's unicode pass can't end the string early. */
+static void writeJavaChar(FILE *handFile, unsigned int c){
+	if(c == '"' || c == '\\')
+		fprintf(handFile, "\\%c", (char)c);
+	else if(c >= 0x20 && c < 0x7F)
+		fputc((int)c, handFile);
+	else if(c == '\n')
+		fprintf(handFile, "\\n");
+	else if(c == '\r')
+		fprintf(handFile, "\\r");
+	else
+		fprintf(handFile, "\\u%04X", c);
+}
+
+/*!\brief	Writes an int array as string literals that unpack() turns back into ints, two chars to each. Unlike an
+ *!		array initialiser, this costs a handful of bytecodes however big the array is, so the class stays well under
+ *!		the 64K limit on static initialisers, and loads quickly.
+ */
+static void writeJavaPackedInts(FILE *handFile, const char *strField, const sListUint *refValues){
+	static const size_t INTS_PER_LITERAL = 8192;	/*!< At 3 bytes a char at worst, keeps each literal under the 64K constant limit. */
+	size_t i;
+
+	if(refValues->num == 0){
+		fprintf(handFile, "   public static final int[] %s = new int[0];\n", strField);
+		return;
+	}
+
+	fprintf(handFile, "   public static final int[] %s = unpack(\n      \"", strField);
+	for(i=0; i < refValues->num; ++i){
+		if(i > 0 && i % INTS_PER_LITERAL == 0)
+			fprintf(handFile, "\",\n      \"");
+
+		writeJavaChar(handFile, (refValues->arr[i] >> 16) & 0xFFFF);
+		writeJavaChar(handFile, refValues->arr[i] & 0xFFFF);
+	}
+	fprintf(handFile, "\"\n   );\n");
+}
+
+/*!\brief	Adds a rect for the texture, laid out as RECT_STRIDE says. */
+static void pushJavaRect(sListUint *rects, unsigned int sheet, const sTex *refTex){
+	pushListUint(rects, sheet);
+	pushListUint(rects, refTex->x);	pushListUint(rects, refTex->y);
+	pushListUint(rects, refTex->w);	pushListUint(rects, refTex->h);
+	pushListUint(rects, (refTex->rotated == TRUE) ? 1 : 0);
+}
+
+/*!\brief	Names that turned up more than once get their entry added, so the constants still compile. */
+static void writeJavaConstant(FILE *handFile, const char *strKind, const char *strName, const sNameHash *refHash, unsigned int entry, unsigned int idx){
+	if(findNameHash(refHash, strName) == (int)entry)
+		fprintf(handFile, "   public static final int %s_%s = %u;\n", strKind, strName, idx);
+	else
+		fprintf(handFile, "   public static final int %s_%s_%u = %u;\n", strKind, strName, entry, idx);
+}
+
+errCode writeManifestInJavaPacked(
+	FILE *handFile,
+	const char *strClassName,
+	const char *javapakName,
+	const sManifest *writeMe,
+	const sTex **refarrTexs
+){
+	sListUint rects;	memset(&rects, 0, sizeof(sListUint));
+	sListUint seqs;		memset(&seqs, 0, sizeof(sListUint));
+	sListUint fonts;	memset(&fonts, 0, sizeof(sListUint));
+	sListUint glyphs;	memset(&glyphs, 0, sizeof(sListUint));
+	sListUint kerns;	memset(&kerns, 0, sizeof(sListUint));
+	sListUint nameSeeds;	memset(&nameSeeds, 0, sizeof(sListUint));
+	sListUint nameSlots;	memset(&nameSlots, 0, sizeof(sListUint));
+	sListUint nameEnds;	memset(&nameEnds, 0, sizeof(sListUint));
+	const char *refName;
+	sTex const *refTex;
+	sTexSeq const *refSeq;
+	sFont const *refFnt;
+	unsigned int i, j, idxRect, idxGlyph, idxKern, lenNames;
+	const unsigned int numStills = writeMe != NULL ? writeMe->refStills->num : 0;
+	const unsigned int numSeqs = writeMe != NULL ? writeMe->refSeqs->num : 0;
+
+	if(handFile == NULL || strClassName == NULL || writeMe == NULL || refarrTexs == NULL)
+		return ERROR;
+
+	/** Stills are the first rects, then the sequence frames, then the glyphs, the same as the binary manifest. */
+	for(i=0; i < numStills; ++i)
+		pushJavaRect(&rects, writeMe->refStills->dynarrSheetIDs[i], refarrTexs[ writeMe->refStills->dynarrTexIDs[i] ]);
+
+	idxRect = numStills;
+	for(i=0; i < numSeqs; ++i){
+		refSeq = &writeMe->refSeqs->dynarrSeqs[i];
+		refTex = (refSeq->num > 0) ? refarrTexs[ refSeq->dynarrTexIDs[0] ] : NULL;
+		pushListUint(&seqs, idxRect);
+		pushListUint(&seqs, refSeq->num);
+		pushListUint(&seqs, (refTex != NULL) ? refTex->w : 0);
+		pushListUint(&seqs, (refTex != NULL) ? refTex->h : 0);
+
+		for(j=0; j < refSeq->num; ++j)
+			pushJavaRect(&rects, refSeq->dynarrSheetIDs[j], refarrTexs[ refSeq->dynarrTexIDs[j] ]);
+		idxRect += refSeq->num;
+	}
+
+	idxGlyph = 0;
+	idxKern = 0;
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		refFnt = writeMe->refFonts->dynarrFonts[i];
+		pushListUint(&fonts, idxGlyph);
+		pushListUint(&fonts, refFnt->num);
+		pushListUint(&fonts, refFnt->sdfSpread);
+		pushListUint(&fonts, ((unsigned int)refFnt->colour[0] << 16) | ((unsigned int)refFnt->colour[1] << 8) | refFnt->colour[2]);
+		pushListUint(&fonts, idxKern);
+		pushListUint(&fonts, refFnt->numKerning);
+
+		for(j=0; j < refFnt->num; ++j){
+			pushJavaRect(&rects, refFnt->dynarrSheetIDs[j], refarrTexs[ refFnt->dynarrTexIDs[j] ]);
+
+			pushListUint(&glyphs, refFnt->dynarrCharcodes[j]);
+			pushListUint(&glyphs, idxRect++);
+			pushListUint(&glyphs, refFnt->dynarrOffsetY[j]);
+			pushListUint(&glyphs, (unsigned int)refFnt->dynarrMetrics[j].advance);	/** unpack() gives back the sign. */
+			pushListUint(&glyphs, (unsigned int)refFnt->dynarrMetrics[j].bearingX);
+			pushListUint(&glyphs, (unsigned int)refFnt->dynarrMetrics[j].bearingY);
+		}
+		idxGlyph += refFnt->num;
+
+		for(j=0; j < refFnt->numKerning; ++j){
+			pushListUint(&kerns, refFnt->dynarrKerning[j].left);
+			pushListUint(&kerns, refFnt->dynarrKerning[j].right);
+			pushListUint(&kerns, (unsigned int)refFnt->dynarrKerning[j].amount);
+		}
+		idxKern += refFnt->numKerning;
+	}
+
+	/** Name lookup, see sNameHash. The names are all in one string, so checking one doesn't make any garbage. */
+	for(i=0; i < writeMe->nameHash.numSeeds; ++i)
+		pushListUint(&nameSeeds, (unsigned int)writeMe->nameHash.dynarrSeeds[i]);
+
+	for(i=0; i < writeMe->nameHash.numSlots; ++i)
+		pushListUint(&nameSlots, writeMe->nameHash.dynarrSlots[i]);
+
+	lenNames = 0;
+	pushListUint(&nameEnds, 0);
+	for(i=0; i < numStills + numSeqs + writeMe->refFonts->num; ++i){
+		if(i < numStills)
+			refName = writeMe->dynarrStrStillNames[i];
+		else if(i < numStills + numSeqs)
+			refName = writeMe->dynarrStrSeqNames[i - numStills];
+		else
+			refName = writeMe->dynarrStrFontNames[i - numStills - numSeqs];
+
+		lenNames += (refName != NULL) ? lenJavaString(refName) : 0;
+		pushListUint(&nameEnds, lenNames);
+	}
+
+	if(javapakName != NULL)
+		fprintf(handFile, "package %s;\n\n", javapakName);
+
+	fprintf(handFile, "/** Made by tpak, changes will be lost the next time it's packed. Everything is in int arrays, */\n");
+	fprintf(handFile, "/** so loading it makes a handful of objects, however many images there are. */\n");
+	fprintf(handFile, "public final class %s {\n", strClassName);
+
+	fprintf(handFile, "   public static final int SHEET_COUNT = %u;\n", writeMe->refSheets->num);
+	fprintf(handFile, "   public static final int STILL_COUNT = %u;\n", numStills);
+	fprintf(handFile, "   public static final int SEQ_COUNT = %u;\n", numSeqs);
+	fprintf(handFile, "   public static final int FONT_COUNT = %u;\n\n", writeMe->refFonts->num);
+
+	fprintf(handFile, "   /** Each rect is sheet, x, y, w, h, rotated. A still's rect is the still itself. Rotated is 1 if it's turned a quarter turn clockwise on the sheet, so it covers h across and w down. */\n");
+	fprintf(handFile, "   public static final int RECT_STRIDE = 6;\n");
+	fprintf(handFile, "   /** Each sequence is first rect, frame count, w, h. Its frames are the rects that follow the first. */\n");
+	fprintf(handFile, "   public static final int SEQ_STRIDE = 4;\n");
+	fprintf(handFile, "   /** Each font is first glyph, glyph count, distance field spread, which is 0 for plain glyphs, 0xRRGGBB to tint the white glyphs with, first kerning pair, and kerning pair count. */\n");
+	fprintf(handFile, "   public static final int FONT_STRIDE = 6;\n");
+	fprintf(handFile, "   /** Each glyph is charcode, rect, y offset, advance, x bearing, y bearing. The last three are in pixels on the sheet. */\n");
+	fprintf(handFile, "   public static final int GLYPH_STRIDE = 6;\n");
+	fprintf(handFile, "   /** Each kerning pair is left glyph, right glyph, amount to add to the left's advance. The glyphs count from the font's first. */\n");
+	fprintf(handFile, "   public static final int KERN_STRIDE = 3;\n\n");
+
+	for(i=0; i < numStills; ++i)
+		writeJavaConstant(handFile, "STILL", writeMe->dynarrStrStillNames[i], &writeMe->nameHash, i, i);
+	for(i=0; i < numSeqs; ++i){
+		if(writeMe->dynarrStrSeqNames[i] != NULL)
+			writeJavaConstant(handFile, "SEQ", writeMe->dynarrStrSeqNames[i], &writeMe->nameHash, numStills + i, i);
+	}
+	for(i=0; i < writeMe->refFonts->num; ++i){
+		if(writeMe->dynarrStrFontNames[i] != NULL)
+			writeJavaConstant(handFile, "FONT", writeMe->dynarrStrFontNames[i], &writeMe->nameHash, numStills + numSeqs + i, i);
+	}
+
+	fprintf(handFile, "\n   public static final String[] SHEET_NAMES = {");
+	for(i=0; i < writeMe->refSheets->num; ++i)
+		fprintf(handFile, "\"%s\",", writeMe->refSheets->dynarrSheets[i]->name);
+	fprintf(handFile, "};\n");
+
+	fprintf(handFile, "   public static final int[] SHEET_SIZES = {");
+	for(i=0; i < writeMe->refSheets->num; ++i)
+		fprintf(handFile, "%u,%u,", writeMe->refSheets->dynarrSheets[i]->w, writeMe->refSheets->dynarrSheets[i]->h);
+	fprintf(handFile, "};\n\n");
+
+	writeJavaPackedInts(handFile, "RECTS", &rects);
+	writeJavaPackedInts(handFile, "SEQS", &seqs);
+	writeJavaPackedInts(handFile, "FONTS", &fonts);
+	writeJavaPackedInts(handFile, "GLYPHS", &glyphs);
+	writeJavaPackedInts(handFile, "KERNS", &kerns);
+
+	fprintf(handFile, "\n   private static final String NAMES = join(\n      \"");
+	for(i=0, lenNames=0; i < numStills + numSeqs + writeMe->refFonts->num; ++i){
+		if(i < numStills)
+			refName = writeMe->dynarrStrStillNames[i];
+		else if(i < numStills + numSeqs)
+			refName = writeMe->dynarrStrSeqNames[i - numStills];
+		else
+			refName = writeMe->dynarrStrFontNames[i - numStills - numSeqs];
+
+		if(lenNames > 16384){	/** Each literal has to stay under the 64K constant limit. */
+			fprintf(handFile, "\",\n      \"");
+			lenNames = 0;
+		}
+
+		if(refName != NULL){
+			fprintf(handFile, "%s", refName);
+			lenNames += (unsigned int)strlen(refName);
+		}
+	}
+	fprintf(handFile, "\"\n   );\n");
+
+	writeJavaPackedInts(handFile, "NAME_ENDS", &nameEnds);
+	writeJavaPackedInts(handFile, "NAME_SEEDS", &nameSeeds);
+	writeJavaPackedInts(handFile, "NAME_SLOTS", &nameSlots);
+
+	fprintf(handFile, "\n   private static int[] unpack(String... packed){\n");
+	fprintf(handFile, "      int len = 0;\n");
+	fprintf(handFile, "      for(String s : packed) len += s.length() / 2;\n");
+	fprintf(handFile, "      int[] out = new int[len];\n");
+	fprintf(handFile, "      int o = 0;\n");
+	fprintf(handFile, "      for(String s : packed)\n");
+	fprintf(handFile, "         for(int i=0; i < s.length(); i += 2) out[o++] = (s.charAt(i) << 16) | s.charAt(i +1);\n");
+	fprintf(handFile, "      return out;\n");
+	fprintf(handFile, "   }\n\n");
+
+	fprintf(handFile, "   private static String join(String... parts){\n");
+	fprintf(handFile, "      StringBuilder joined = new StringBuilder();\n");
+	fprintf(handFile, "      for(String s : parts) joined.append(s);\n");
+	fprintf(handFile, "      return joined.toString();\n");
+	fprintf(handFile, "   }\n\n");
+
+	fprintf(handFile, "   private static int hashName(int seed, String name){\n");
+	fprintf(handFile, "      int h = 0x811C9DC5 ^ seed;\n");
+	fprintf(handFile, "      for(byte b : name.getBytes(java.nio.charset.StandardCharsets.UTF_8)){ h ^= b & 0xFF; h *= 16777619; }\n");
+	fprintf(handFile, "      h ^= h >>> 16; h *= 0x85EBCA6B; h ^= h >>> 13; h *= 0xC2B2AE35; h ^= h >>> 16;\n");
+	fprintf(handFile, "      return h & 0x7FFFFFFF;\n");
+	fprintf(handFile, "   }\n\n");
+
+	fprintf(handFile, "   /** The entry with that name, counting stills, then sequences, then fonts, or -1. */\n");
+	fprintf(handFile, "   public static int find(String name){\n");
+	fprintf(handFile, "      if(NAME_SLOTS.length == 0) return -1;\n");
+	fprintf(handFile, "      int seed = NAME_SEEDS[hashName(0, name) %% NAME_SEEDS.length];\n");
+	fprintf(handFile, "      int entry = NAME_SLOTS[(seed < 0) ? -seed -1 : hashName(seed, name) %% NAME_SLOTS.length];\n");
+	fprintf(handFile, "      int start = NAME_ENDS[entry], len = NAME_ENDS[entry +1] - start;\n");
+	fprintf(handFile, "      return (len == name.length() && NAMES.regionMatches(start, name, 0, len)) ? entry : -1;\n");
+	fprintf(handFile, "   }\n");
+
+	fprintf(handFile, "}\n");
+
+	cleanupListUint(&rects);
+	cleanupListUint(&seqs);
+	cleanupListUint(&fonts);
+	cleanupListUint(&glyphs);
+	cleanupListUint(&kerns);
+	cleanupListUint(&nameSeeds);
+	cleanupListUint(&nameSlots);
+	cleanupListUint(&nameEnds);
+
+	return NOPROB;
+}
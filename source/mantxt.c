@@ -22,24 +22,22 @@
 #include "texturepacker.h"
 #include "squarefit.h"
 
-errCode writeManifestInTxt(const char *manPath, const sManifest *writeMe, const sTex **refarrTexs){
+errCode writeManifestInTxt(FILE *handFile, const sManifest *writeMe, const sTex **refarrTexs){
 	static const char *HEAD_SHEET = "sheet_count=";
 	static const char *HEAD_SEQUENCES = "sequences_count=";
 	static const char *HEAD_STILLS = "stills_count=";
 	static const char *HEAD_FONTS = "fonts_count=";
-	static const char *FILE_TYPE = ".txt";
+	static const char *HEAD_HASH_SEEDS = "hash_seeds_count=";
+	static const char *HEAD_HASH_SLOTS = "hash_slots_count=";
+	static const char *HEAD_HASH_NAMES = "hash_names_count=";
 	static const char *NEW_LINE="\n";
 	static const size_t LENBUFF = 128;
 
 	char buff[ LENBUFF ];
-	FILE *handFile; 
 	sTex const *refTex;
 	unsigned int i, j;
 
-	snprintf(buff, LENBUFF, "%s%s", manPath, FILE_TYPE);
-	handFile = fopen(buff, "w");
-
-	if(manPath == NULL)
+	if(handFile == NULL)
 		return ERROR;
 
 	if(writeMe == NULL)
@@ -71,12 +69,13 @@ errCode writeManifestInTxt(const char *manPath, const sManifest *writeMe, const
 		strncpy(buff, refTex->name, LENBUFF);
 		sanitiseString(buff);
 
-		fprintf(handFile, "%s,%i,%i,%i,%i%s", 
+		fprintf(handFile, "%s,%i,%i,%i,%i,%i%s", 
 			refTex->name, 
 			refTex->x, 
 			refTex->y, 
 			refTex->w, 
 			refTex->h,
+			(refTex->rotated == TRUE) ? 1 : 0,
 			NEW_LINE
 		); 
 	}
@@ -115,7 +114,7 @@ errCode writeManifestInTxt(const char *manPath, const sManifest *writeMe, const
 			fprintf(handFile, "%s,%i,%i,%i,(", buff, refSeq->num, refTex->w, refTex->h);
 			for(j=0; j < refSeq->num; ++j){
 				refTex = refarrTexs[ refSeq->dynarrTexIDs[j] ];
-				fprintf(handFile, "(%i,%i,%i),", refTex->x, refTex->y, refSeq->dynarrSheetIDs[j]);
+				fprintf(handFile, "(%i,%i,%i,%i),", refTex->x, refTex->y, refSeq->dynarrSheetIDs[j], (refTex->rotated == TRUE) ? 1 : 0);
 			}
 
 			fprintf(handFile, ")%s", NEW_LINE);
@@ -153,20 +152,55 @@ errCode writeManifestInTxt(const char *manPath, const sManifest *writeMe, const
 
 			for(j=0; j < refFnt->num; ++j){
 				refTex = refarrTexs[ refFnt->dynarrTexIDs[j] ];
-				fprintf(handFile, "(%i,%i,%i,%i,%i,%i,%i),", 
+				fprintf(handFile, "(%i,%i,%i,%i,%i,%i,%i,%i,%i,%i,%i),", 
 					refFnt->dynarrCharcodes[j], 
 					refFnt->dynarrSheetIDs[j],
 					refTex->x, refTex->y,
 					refTex->w, refTex->h,
-					refFnt->dynarrOffsetY[j]
+					refFnt->dynarrOffsetY[j],
+					refFnt->dynarrMetrics[j].advance,
+					refFnt->dynarrMetrics[j].bearingX, refFnt->dynarrMetrics[j].bearingY,
+					(refTex->rotated == TRUE) ? 1 : 0
 				);
 			}
 
+			/** The distance field spread, zero for plain glyphs, then the colour to tint the white glyphs with. */
+			fprintf(handFile, "),%u,%u.%u.%u",
+				refFnt->sdfSpread, refFnt->colour[0], refFnt->colour[1], refFnt->colour[2]
+			);
+
+			/** Kerning pairs, by where the glyphs are in the list above. */
+			fprintf(handFile, ",%u,(", refFnt->numKerning);
+			for(j=0; j < refFnt->numKerning; ++j){
+				fprintf(handFile, "(%u,%u,%i),",
+					refFnt->dynarrKerning[j].left, refFnt->dynarrKerning[j].right, refFnt->dynarrKerning[j].amount
+				);
+			}
 			fprintf(handFile, ")%s", NEW_LINE);
 		}
 	}
 
-	fclose(handFile);
+	/** Name lookup, see sNameHash. The entries count stills, then sequences, then fonts, the same as the counts above.
+	 *  The names hashed aren't the ones above, they're the names the other manifests use, so they're listed after the
+	 *  slots by entry. One is empty if the entry can't be looked up. */
+	fprintf(handFile, "%s%i%s", HEAD_HASH_SEEDS, writeMe->nameHash.numSeeds, NEW_LINE);
+	for(i=0; i < writeMe->nameHash.numSeeds; ++i)
+		fprintf(handFile, "%i,", writeMe->nameHash.dynarrSeeds[i]);
+	fprintf(handFile, "%s", NEW_LINE);
+
+	fprintf(handFile, "%s%i%s", HEAD_HASH_SLOTS, writeMe->nameHash.numSlots, NEW_LINE);
+	for(i=0; i < writeMe->nameHash.numSlots; ++i)
+		fprintf(handFile, "%u,", writeMe->nameHash.dynarrSlots[i]);
+	fprintf(handFile, "%s", NEW_LINE);
+
+	fprintf(handFile, "%s%u%s", HEAD_HASH_NAMES, writeMe->refStills->num + writeMe->refSeqs->num + writeMe->refFonts->num, NEW_LINE);
+	for(i=0; i < writeMe->refStills->num; ++i)
+		fprintf(handFile, "%s,", (writeMe->dynarrStrStillNames[i] != NULL) ? writeMe->dynarrStrStillNames[i] : "");
+	for(i=0; i < writeMe->refSeqs->num; ++i)
+		fprintf(handFile, "%s,", (writeMe->dynarrStrSeqNames[i] != NULL) ? writeMe->dynarrStrSeqNames[i] : "");
+	for(i=0; i < writeMe->refFonts->num; ++i)
+		fprintf(handFile, "%s,", (writeMe->dynarrStrFontNames[i] != NULL) ? writeMe->dynarrStrFontNames[i] : "");
+	fprintf(handFile, "%s", NEW_LINE);
 
 	return NOPROB;
 
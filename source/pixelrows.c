@@ -0,0 +1,115 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pixelrows.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+/** (a + b + c) * THIRD_MUL >> THIRD_SHIFT is (a + b + c) / 3 for every sum of three bytes, without dividing. */
+static const unsigned int THIRD_MUL = 21846;
+static const unsigned int THIRD_SHIFT = 16;
+
+/** 16 rows of 16 RGBA pixels is 1K read and 1K written, which leaves plenty of the L1 for the row pointers. */
+static const unsigned int ROTATE_TILE = 16;
+
+void lcdRowToCoverage(unsigned char *outRow, const unsigned char *refLCD, unsigned int w){
+	unsigned int c;
+
+	/** The sub pixels are three bytes apart, which SSE2 can't pull apart without shuffles, so this stays a
+	 *  multiply per pixel. It's still a good deal quicker than dividing each sub pixel. */
+	for(c=0; c < w; ++c, refLCD += 3)
+		outRow[c] = (unsigned char)(((unsigned int)refLCD[0] + refLCD[1] + refLCD[2]) * THIRD_MUL >> THIRD_SHIFT);
+}
+
+void expandCoverageRow(unsigned char *outRow, const unsigned char *refCoverage, unsigned int w, unsigned int sizePix){
+	unsigned int c = 0;
+
+#ifdef __SSE2__
+	const __m128i white = _mm_set1_epi8((char)0xFF);
+	__m128i coverage, pairs;
+
+	/** Sixteen pixels at a time. White goes under the coverage to make gray and alpha pairs, and for RGBA white
+	 *  goes under each pair again. */
+	if(sizePix == 2){
+		for(; c + 16 <= w; c += 16){
+			coverage = _mm_loadu_si128((const __m128i*)&refCoverage[c]);
+			_mm_storeu_si128((__m128i*)&outRow[c *2], _mm_unpacklo_epi8(white, coverage));
+			_mm_storeu_si128((__m128i*)&outRow[(c *2) +16], _mm_unpackhi_epi8(white, coverage));
+		}
+	}else if(sizePix == 4){
+		for(; c + 16 <= w; c += 16){
+			coverage = _mm_loadu_si128((const __m128i*)&refCoverage[c]);
+			pairs = _mm_unpacklo_epi8(white, coverage);
+			_mm_storeu_si128((__m128i*)&outRow[c *4], _mm_unpacklo_epi16(white, pairs));
+			_mm_storeu_si128((__m128i*)&outRow[(c *4) +16], _mm_unpackhi_epi16(white, pairs));
+			pairs = _mm_unpackhi_epi8(white, coverage);
+			_mm_storeu_si128((__m128i*)&outRow[(c *4) +32], _mm_unpacklo_epi16(white, pairs));
+			_mm_storeu_si128((__m128i*)&outRow[(c *4) +48], _mm_unpackhi_epi16(white, pairs));
+		}
+	}
+#endif
+
+	if(c >= w)
+		return;
+
+	memset(&outRow[c * sizePix], 0xFF, (w - c) * sizePix);
+	for(; c < w; ++c)
+		outRow[(c * sizePix) + sizePix -1] = refCoverage[c];
+}
+
+void rotateRowsCW(
+	unsigned char **outRows, size_t offOut,
+	const unsigned char * const *refRows, unsigned int w, unsigned int h,
+	unsigned int sizeSrc, unsigned int sizePix
+){
+	unsigned int tileX, tileY, endX, endY, x, y;
+	unsigned char *outPix;
+
+	/** Column x of the image is row x of the output, read from the bottom up. Within a tile each output row is
+	 *  written left to right, from a run of ROTATE_TILE source rows. */
+	for(tileY=0; tileY < h; tileY += ROTATE_TILE){
+		endY = (tileY + ROTATE_TILE < h) ? tileY + ROTATE_TILE : h;
+
+		for(tileX=0; tileX < w; tileX += ROTATE_TILE){
+			endX = (tileX + ROTATE_TILE < w) ? tileX + ROTATE_TILE : w;
+
+			for(x=tileX; x < endX; ++x){
+				outPix = &outRows[x][ offOut + ((size_t)(h - endY) * sizePix) ];
+
+				if(sizeSrc != sizePix){
+					for(y=endY; y-- > tileY; outPix += sizePix){
+						memset(outPix, 0xFF, sizePix -1);
+						outPix[sizePix -1] = refRows[y][x];
+					}
+				}else if(sizePix == 4){
+					for(y=endY; y-- > tileY; outPix += 4)
+						memcpy(outPix, &refRows[y][x *4], 4);
+				}else if(sizePix == 1){
+					for(y=endY; y-- > tileY; ++outPix)
+						*outPix = refRows[y][x];
+				}else{
+					for(y=endY; y-- > tileY; outPix += sizePix)
+						memcpy(outPix, &refRows[y][(size_t)x * sizePix], sizePix);
+				}
+			}
+		}
+	}
+}
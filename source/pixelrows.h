@@ -0,0 +1,53 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *	Conversions done a row of pixels at a time, for glyphs on their way from FreeType to the sheets. They use SSE2
+ *	when the compiler has it, and give the same bytes either way. Also the copy for images that go on the sheets
+ *	turned a quarter turn.
+ *
+ */
+
+#ifndef PIXELROWS_H
+#define PIXELROWS_H
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Averages the three sub pixels of each LCD pixel into one coverage byte, rounding down. */
+void lcdRowToCoverage(unsigned char *outRow, const unsigned char *refLCD, unsigned int w);
+
+/*!\brief	Writes glyph coverage out as white pixels, with the coverage in the last byte of each.
+ *!\param	sizePix	Bytes in each pixel written, 2 for gray and alpha or 4 for RGBA.
+ */
+void expandCoverageRow(unsigned char *outRow, const unsigned char *refCoverage, unsigned int w, unsigned int sizePix);
+
+/*!\brief	Copies an image turned a quarter turn clockwise, so the w by h image covers h across and w down. Goes a tile at a
+ *!		time, so the rows read and the rows written both stay in the cache, instead of every pixel written landing on
+ *!		a different row.
+ *!\param	outRows		The first w rows written to.
+ *!\param	offOut		Bytes into each of those rows to start at.
+ *!\param	sizeSrc		Bytes in each pixel read. Either the same as sizePix, or 1 for glyph coverage, which is written
+ *!				out white the same as expandCoverageRow.
+ *!\param	sizePix		Bytes in each pixel written.
+ */
+void rotateRowsCW(
+	unsigned char **outRows, size_t offOut,
+	const unsigned char * const *refRows, unsigned int w, unsigned int h,
+	unsigned int sizeSrc, unsigned int sizePix
+);
+
+#endif
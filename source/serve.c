@@ -0,0 +1,311 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "serve.h"
+#include "strtools.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+
+static const size_t MAX_JOB_SIZE = 64 * 1024;	/*!< Far more than any command line needs. */
+static const int JOB_READ_TIMEOUT_MS = 5000;	/*!< A client that stops sending part way through is dropped. */
+static const int LISTEN_BACKLOG = 16;
+
+/*!\brief	Fills in the socket address for the path.
+ *!\return	PROBLEM if the path is too long for a socket.
+ */
+static errCode makeAddress(const char *strPath, struct sockaddr_un *outAddr){
+	memset(outAddr, 0, sizeof(struct sockaddr_un));
+	outAddr->sun_family = AF_UNIX;
+
+	if(strlen(strPath) >= sizeof(outAddr->sun_path)){
+		WARN("Socket path %s is too long", strPath);
+		return PROBLEM;
+	}
+
+	strcpy(outAddr->sun_path, strPath);
+	return NOPROB;
+}
+
+/*!\brief	Writes all of it, unless the other end has gone. */
+static errCode writeAll(int fd, const char *data, size_t len){
+	ssize_t lenWrote;
+
+	while(len > 0){
+		lenWrote = write(fd, data, len);
+		if(lenWrote < 0 && errno == EINTR)
+			continue;
+
+		if(lenWrote <= 0)
+			return PROBLEM;
+
+		data += lenWrote;
+		len -= (size_t)lenWrote;
+	}
+
+	return NOPROB;
+}
+
+errCode startServer(sServer *server, const char *strPath){
+	struct sockaddr_un addr;
+	struct stat info;
+	mode_t maskOld;
+	int bound;
+
+	if(server == NULL || strPath == NULL)
+		return ERROR;
+
+	memset(server, 0, sizeof(sServer));
+	server->fd = -1;
+
+	if(makeAddress(strPath, &addr) != NOPROB)
+		return PROBLEM;
+
+	signal(SIGPIPE, SIG_IGN);	/** A client that hangs up early shouldn't take us with it. */
+
+	server->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(server->fd < 0){
+		WARN("Unable to make a socket");
+		return PROBLEM;
+	}
+
+	if(lstat(strPath, &info) == 0){	/** Only clear away a socket left by an old server, never some other file. */
+		if(!S_ISSOCK(info.st_mode)){
+			WARN("%s already exists and isn't a socket", strPath);
+			close(server->fd);
+			server->fd = -1;
+			return PROBLEM;
+		}
+		unlink(strPath);
+	}
+
+	maskOld = umask(077);	/** A job writes and deletes files as us, so only we get to send one. */
+	bound = bind(server->fd, (struct sockaddr*)&addr, sizeof(addr));
+	umask(maskOld);
+
+	if(bound != 0 || listen(server->fd, LISTEN_BACKLOG) != 0){
+		WARN("Unable to listen on %s", strPath);
+		close(server->fd);
+		server->fd = -1;
+		return PROBLEM;
+	}
+
+	copyString(&server->strPath, strPath);
+	return NOPROB;
+}
+
+/*!\brief	Reads until the job's closing empty string turns up.
+ *!\return	Length of the job, or zero if it never came.
+ */
+static size_t readJob(int fd, char *buff, size_t lenBuff){
+	struct pollfd pollRead;
+	size_t lenRead = 0;
+	ssize_t lenNew;
+
+	pollRead.fd = fd;
+	pollRead.events = POLLIN;
+
+	while(lenRead < lenBuff){
+		pollRead.revents = 0;
+		if(poll(&pollRead, 1, JOB_READ_TIMEOUT_MS) <= 0)
+			return 0;
+
+		lenNew = read(fd, &buff[lenRead], lenBuff - lenRead);
+		if(lenNew <= 0)
+			return 0;
+
+		lenRead += (size_t)lenNew;
+
+		if(lenRead >= 2 && buff[lenRead -1] == '\0' && buff[lenRead -2] == '\0')	/** The cwd is never empty, so this is the end. */
+			return lenRead;
+	}
+
+	return 0;
+}
+
+errCode acceptJob(sServer *server, sServeJob *outJob){
+	struct pollfd pollAccept;
+	size_t lenJob, i;
+	char *itr;
+
+	if(server == NULL || outJob == NULL || server->fd < 0)
+		return ERROR;
+
+	memset(outJob, 0, sizeof(sServeJob));
+	outJob->fd = -1;
+
+	pollAccept.fd = server->fd;
+	pollAccept.events = POLLIN;
+	pollAccept.revents = 0;
+	if(poll(&pollAccept, 1, -1) <= 0)	/** Unlike accept, this is always woken by a signal. */
+		return PROBLEM;
+
+	outJob->fd = accept(server->fd, NULL, NULL);
+	if(outJob->fd < 0)
+		return PROBLEM;
+
+	outJob->dynarrBuff = malloc_chk(MAX_JOB_SIZE);
+	lenJob = readJob(outJob->fd, outJob->dynarrBuff, MAX_JOB_SIZE);
+	if(lenJob == 0){
+		WARN("A client didn't send a whole job");
+		close(outJob->fd);
+		SAFE_DELETE(outJob->dynarrBuff);
+		outJob->fd = -1;
+		return PROBLEM;
+	}
+
+	outJob->strCwd = outJob->dynarrBuff;
+
+	outJob->numArgs = 1;	/** The made up program name. */
+	for(i = strlen(outJob->strCwd) +1; i < lenJob -1; ++i){
+		if(outJob->dynarrBuff[i] == '\0')
+			++outJob->numArgs;
+	}
+
+	outJob->dynarrArgs = calloc_chk(outJob->numArgs +1, sizeof(char*));
+	outJob->dynarrArgs[0] = "tpak";
+	itr = &outJob->dynarrBuff[ strlen(outJob->strCwd) +1 ];
+	for(i=1; i < outJob->numArgs; ++i){
+		outJob->dynarrArgs[i] = itr;
+		itr += strlen(itr) +1;
+	}
+
+	return NOPROB;
+}
+
+void replyJob(sServeJob *job, const char *format, ...){
+	char buff[1024];
+	va_list args;
+	int len;
+
+	if(job == NULL || job->fd < 0)
+		return;
+
+	va_start(args, format);
+	len = vsnprintf(buff, sizeof(buff) -1, format, args);
+	va_end(args);
+
+	if(len < 0)
+		return;
+
+	if((size_t)len > sizeof(buff) -2)
+		len = sizeof(buff) -2;
+
+	buff[len] = '\n';
+	writeAll(job->fd, buff, (size_t)len +1);
+}
+
+void finishJob(sServeJob *job, errCode result){
+	if(job == NULL)
+		return;
+
+	replyJob(job, "done %d", (int)result);
+
+	if(job->fd >= 0)
+		close(job->fd);
+	job->fd = -1;
+
+	SAFE_DELETE(job->dynarrArgs);
+	SAFE_DELETE(job->dynarrBuff);
+	job->strCwd = NULL;
+	job->numArgs = 0;
+}
+
+void stopServer(sServer *server){
+	if(server == NULL)
+		return;
+
+	if(server->fd >= 0)
+		close(server->fd);
+	server->fd = -1;
+
+	if(server->strPath != NULL)
+		unlink(server->strPath);
+	SAFE_DELETE(server->strPath);
+}
+
+errCode runClient(const char *strPath, const char **arrArgs, unsigned int numArgs){
+	struct sockaddr_un addr;
+	char buff[4096];
+	char *refLineEnd;
+	size_t lenLine = 0;
+	ssize_t lenRead;
+	unsigned int i;
+	int fd, code = -1;
+	errCode result = NOPROB;
+
+	if(strPath == NULL || makeAddress(strPath, &addr) != NOPROB)
+		return ERROR;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0){
+		ERROR_LOG("Unable to reach a server on %s", strPath);
+		if(fd >= 0)
+			close(fd);
+		return PROBLEM;
+	}
+
+	if(getcwd(buff, sizeof(buff)) == NULL)
+		strcpy(buff, "/");
+
+	result = writeAll(fd, buff, strlen(buff) +1);
+	for(i=0; result == NOPROB && i < numArgs; ++i){
+		if(arrArgs[i][0] != '\0')	/** An empty one would end the job early. */
+			result = writeAll(fd, arrArgs[i], strlen(arrArgs[i]) +1);
+	}
+
+	if(result == NOPROB)
+		result = writeAll(fd, "", 1);
+
+	while(result == NOPROB && (lenRead = read(fd, &buff[lenLine], sizeof(buff) -1 - lenLine)) > 0){
+		lenLine += (size_t)lenRead;
+		buff[lenLine] = '\0';
+
+		while((refLineEnd = strchr(buff, '\n')) != NULL){
+			*refLineEnd = '\0';
+
+			if(strncmp(buff, "file ", 5) == 0)
+				printf("%s\n", &buff[5]);
+			else if(strncmp(buff, "error ", 6) == 0)
+				WARN("%s", &buff[6]);
+			else if(strncmp(buff, "done ", 5) == 0)
+				code = atoi(&buff[5]);
+
+			lenLine -= (size_t)(refLineEnd - buff) +1;
+			memmove(buff, refLineEnd +1, lenLine +1);
+		}
+
+		if(lenLine == sizeof(buff) -1)	/** A line too long to be ours. */
+			lenLine = 0;
+	}
+
+	close(fd);
+
+	if(result != NOPROB || code < 0){
+		ERROR_LOG("Lost the server part way through the job");
+		return PROBLEM;
+	}
+
+	return (code == NOPROB) ? NOPROB : PROBLEM;
+}
@@ -0,0 +1,71 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *	A client sends a job as its working directory followed by its command line switches, each one ending in a null,
+ *	with an empty string at the end. The server replies with lines of text: 'file <path>' for everything it wrote,
+ *	'error <message>' for anything that went wrong, and last of all 'done <code>', where 0 means it all went well.
+ *
+ */
+
+#ifndef SERVE_H
+#define SERVE_H
+
+#include "utils.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Listens for pack jobs on a unix domain socket. */
+typedef struct defServer{
+	int fd;
+	char *strPath;	/*!< Removed when the server stops. Cleanup. */
+} sServer;
+
+/*!\brief	A client that's waiting for its job to be done. */
+typedef struct defServeJob{
+	int fd;
+	char *strCwd;		/*!< Where the client was run from, so its relative paths can be found. Points into dynarrBuff. */
+	const char **dynarrArgs;	/*!< The client's switches, with a made up program name first. Point into dynarrBuff. Cleanup. */
+	unsigned int numArgs;
+	char *dynarrBuff;	/*!< Cleanup. */
+} sServeJob;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Starts listening on the socket. Anything left at the path, from a server that didn't stop cleanly, is replaced. */
+errCode startServer(sServer *server, const char *strPath);
+
+/*!\brief	Waits for a client and reads its job.
+ *!\return	PROBLEM if we were interrupted, or the client didn't send a whole job, in which case there's nothing to finish.
+ */
+errCode acceptJob(sServer *server, sServeJob *outJob);
+
+/*!\brief	Sends a line to the client. */
+void replyJob(sServeJob *job, const char *format, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+/*!\brief	Tells the client how it went, and hangs up. */
+void finishJob(sServeJob *job, errCode result);
+
+/*!\brief	Stops listening, and removes the socket. */
+void stopServer(sServer *server);
+
+/*!\brief	Sends a job to the server, and prints the paths it wrote as they come back.
+ *!\param	arrArgs	Command line switches for the job, without the program name.
+ *!\return	NOPROB if the server packed everything.
+ */
+errCode runClient(const char *strPath, const char **arrArgs, unsigned int numArgs);
+
+#endif
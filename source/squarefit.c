@@ -173,19 +173,19 @@ void printRelief(const sListRelief *printMe){
 	if(printMe == NULL)
 		return;
 
-	printf("Relief (%i, %i) ", printMe->min, printMe->max);
+	logText(eLogInfo, "Relief (%i, %i) ", printMe->min, printMe->max);
 	switch(printMe->dir){
-		case eUp: printf(" up"); break;
-		case eDown: printf(" down"); break;
-		case eLeft: printf(" left"); break;
-		case eRight: printf(" right"); break;
+		case eUp: logText(eLogInfo, " up"); break;
+		case eDown: logText(eLogInfo, " down"); break;
+		case eLeft: logText(eLogInfo, " left"); break;
+		case eRight: logText(eLogInfo, " right"); break;
 	}
 
 	unsigned int i;
 	for(i = 0; i < printMe->num; ++i){
-		printf(" (%i, %i)", printMe->arr[i].start, printMe->arr[i].dist);
+		logText(eLogInfo, " (%i, %i)", printMe->arr[i].start, printMe->arr[i].dist);
 	}
-	printf("\n");
+	logText(eLogInfo, "\n");
 }
 
 /*** SQUARES ***/
@@ -195,7 +195,7 @@ errCode consolidate(sListSquares *squares){
 	XTRA_LOG("-consolidate");
 
 	if(squares == NULL){
-		printf("<error> consolidate: squares are null\n");
+		logText(eLogError, "<error> consolidate: squares are null\n");
 		return ERROR;
 	}
 
@@ -397,7 +397,7 @@ errCode consolidate(sListSquares *squares){
 
 errCode addSquare(sListSquares *squares, bool filled, unsigned int x, unsigned int y, unsigned int w, unsigned int h){
 	if(squares == NULL){
-		printf("<error> addSquare: addTo is NULL.\n");
+		logText(eLogError, "<error> addSquare: addTo is NULL.\n");
 		return ERROR;
 	}
 	
@@ -435,7 +435,7 @@ errCode addSquare(sListSquares *squares, bool filled, unsigned int x, unsigned i
 
 errCode addSquarePtr(sListSquares *squares, bool filled, sSquare *addMe){
 	if(addMe==NULL){
-		printf("<error> addSquarePtr: addMe is null.\n");
+		logText(eLogError, "<error> addSquarePtr: addMe is null.\n");
 		return ERROR;
 	}
 	return addSquare(squares, filled, addMe->x, addMe->y, addMe->w, addMe->h);
@@ -542,7 +542,7 @@ bool anyOverlaps(sListSquares *squares, unsigned int x, unsigned int y, unsigned
 
 bool anyOverlapsPtr(sListSquares *squares, sSquare *checkme){
 	if(checkme==NULL){
-		printf("<error> anyOverlapsPtr: checkme is null.\n");
+		logText(eLogError, "<error> anyOverlapsPtr: checkme is null.\n");
 		return ERROR;
 	}
 	return anyOverlaps(squares, checkme->x, checkme->y, checkme->w, checkme->h);
@@ -747,12 +747,12 @@ errCode incBoundries(sListSquares *squares, unsigned int w, unsigned int h){
 
 int canFitSquare(sListSquares *squares, unsigned int w, unsigned int h){
 	if(squares == NULL){
-		printf("<error> canFitSquare: squares are null.\n");
+		logText(eLogError, "<error> canFitSquare: squares are null.\n");
 		return -1;
 	}
 	
 	if(squares->num == 0){
-		printf("canFitSquare: No holes.\n");
+		logText(eLogInfo, "canFitSquare: No holes.\n");
 		return -1;
 	}
 	
@@ -833,7 +833,7 @@ int getCornerSquare(sListSquares *all, eSquareSide a, eSquareSide b){
 		top2bottom=TRUE;
 		
 	}else{
-		printf("<warning> getCornerSquare: Didn't choose top or bottom sides.\n");
+		logText(eLogWarn, "<warning> getCornerSquare: Didn't choose top or bottom sides.\n");
 		return -1;
 	}
 	
@@ -844,7 +844,7 @@ int getCornerSquare(sListSquares *all, eSquareSide a, eSquareSide b){
 		left2right=TRUE;
 		
 	}else{
-		printf("<warning> getCornerSquare: Didn't choose left or right side.\n");
+		logText(eLogWarn, "<warning> getCornerSquare: Didn't choose left or right side.\n");
 		return -1;
 	}
 	
@@ -874,12 +874,12 @@ int getCornerSquare(sListSquares *all, eSquareSide a, eSquareSide b){
 
 errCode joinSquareLists(sListSquares *to, sListSquares *from){
 	if(to == NULL || from == NULL){
-		printf("<error> joinSquareLists: 'to' or 'from' are null.\n");
+		logText(eLogError, "<error> joinSquareLists: 'to' or 'from' are null.\n");
 		return ERROR;
 	}
 	
 	if(from->num == 0){
-		printf("<warning> joinSquareLists: 'from' has nothing.\n");
+		logText(eLogWarn, "<warning> joinSquareLists: 'from' has nothing.\n");
 		return PROBLEM;
 	}
 	
@@ -905,10 +905,10 @@ errCode joinSquareLists(sListSquares *to, sListSquares *from){
 void printSquares(const sListSquares *squares){
 	sSquare *ref;
 	size_t i;
-	printf("Squares %u * %u\n", squares->boundryW, squares->boundryH);
+	logText(eLogInfo, "Squares %u * %u\n", squares->boundryW, squares->boundryH);
 	for(i=0; i < squares->num; ++i){
 		ref = &squares->dynarrSquares[i];
-		printf("%u: (%u, %u) %u * %u. %s \n",
+		logText(eLogInfo, "%u: (%u, %u) %u * %u. %s \n",
 			(unsigned int)i, ref->x, ref->y, ref->w, ref->h,
 			(squares->dynarrFills[i]==TRUE) ? "filled" : "empty"
 		);
@@ -929,19 +929,19 @@ void cleanupListSquares(sListSquares *cleanMe){
 errCode fillSquare(sListSquares *squares, unsigned int idxFillMe, unsigned int w, unsigned int h){
 	
 	if(idxFillMe >= squares->num){
-		printf("<error> fillSquare: bad index.\n");
+		logText(eLogError, "<error> fillSquare: bad index.\n");
 		return ERROR;
 	}
 	
 	if(squares->dynarrFills[idxFillMe] == TRUE){
-		printf("<warning> fillSquare: square is already filled\n");
+		logText(eLogWarn, "<warning> fillSquare: square is already filled\n");
 		return PROBLEM;
 	}
 	
 	sSquare *fill = &squares->dynarrSquares[idxFillMe];
 	
 	if(w > fill->w || h > fill->h){
-		printf("<warning> fillSquare: square is too small\n");
+		logText(eLogWarn, "<warning> fillSquare: square is too small\n");
 		return PROBLEM;
 	}
 	
@@ -964,6 +964,109 @@ errCode fillSquare(sListSquares *squares, unsigned int idxFillMe, unsigned int w
 	return NOPROB;
 }
 
+static int compareUint(const void *a, const void *b){
+	const unsigned int ua = *(const unsigned int*)a;
+	const unsigned int ub = *(const unsigned int*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+static int compareSquareX(const void *a, const void *b){
+	return compareUint(&((const sSquare*)a)->x, &((const sSquare*)b)->x);
+}
+
+errCode genSquaresAround(sListSquares *out, unsigned int w, unsigned int h, const sSquare *arrFills, unsigned int numFills){
+	unsigned int *dynarrEdges;	/** Every y where a band starts or stops. */
+	sSquare *dynarrBand;		/** The filled squares crossing the current band, sorted left to right. */
+	unsigned int *dynarrAbove;	/** Index of the holes that reach the bottom of the band above. */
+	unsigned int *dynarrBelow;	/** Index of the holes that reach the bottom of the current band. */
+	unsigned int numEdges, numBand, numAbove, numBelow;
+	unsigned int e, f, i, x, y0, y1, gapEnd;
+	sSquare *refHole;
+
+	if(out == NULL)
+		return ERROR;
+
+	cleanupListSquares(out);
+	out->boundryW = w;
+	out->boundryH = h;
+
+	if(w == 0 || h == 0)
+		return NOPROB;
+
+	for(f=0; f < numFills; ++f){
+		if(arrFills[f].x + arrFills[f].w > w || arrFills[f].y + arrFills[f].h > h){
+			WARN("genSquaresAround: Square outside boundries.");
+			return PROBLEM;
+		}
+		addSquare(out, TRUE, arrFills[f].x, arrFills[f].y, arrFills[f].w, arrFills[f].h);
+	}
+
+	dynarrEdges = calloc_chk(numFills *2 +2, sizeof(unsigned int));
+	dynarrBand = calloc_chk(numFills +1, sizeof(sSquare));
+	dynarrAbove = calloc_chk(numFills +1, sizeof(unsigned int));
+	dynarrBelow = calloc_chk(numFills +1, sizeof(unsigned int));
+
+	numEdges = 0;
+	dynarrEdges[numEdges++] = 0;
+	dynarrEdges[numEdges++] = h;
+	for(f=0; f < numFills; ++f){
+		dynarrEdges[numEdges++] = arrFills[f].y;
+		dynarrEdges[numEdges++] = arrFills[f].y + arrFills[f].h;
+	}
+	qsort(dynarrEdges, numEdges, sizeof(unsigned int), compareUint);
+
+	numAbove = 0;
+	for(e=0; e +1 < numEdges; ++e){
+		y0 = dynarrEdges[e];
+		y1 = dynarrEdges[e +1];
+		if(y0 == y1)
+			continue;
+
+		numBand = 0;
+		for(f=0; f < numFills; ++f){
+			if(arrFills[f].y <= y0 && arrFills[f].y + arrFills[f].h >= y1)
+				dynarrBand[numBand++] = arrFills[f];
+		}
+		qsort(dynarrBand, numBand, sizeof(sSquare), compareSquareX);
+
+		numBelow = 0;
+		x = 0;
+		for(f=0; f <= numBand; ++f){
+			gapEnd = (f < numBand) ? dynarrBand[f].x : w;
+
+			if(gapEnd > x){
+				refHole = NULL;
+				for(i=0; i < numAbove; ++i){	/** Stretch the hole above if it lines up. */
+					refHole = &out->dynarrSquares[ dynarrAbove[i] ];
+					if(refHole->x == x && refHole->w == gapEnd -x)
+						break;
+					refHole = NULL;
+				}
+
+				if(refHole != NULL){
+					refHole->h += y1 - y0;
+					dynarrBelow[numBelow++] = dynarrAbove[i];
+				}else{
+					addSquare(out, FALSE, x, y0, gapEnd -x, y1 -y0);
+					dynarrBelow[numBelow++] = out->num -1;
+				}
+			}
+
+			if(f < numBand && dynarrBand[f].x + dynarrBand[f].w > x)
+				x = dynarrBand[f].x + dynarrBand[f].w;
+		}
+
+		memcpy(dynarrAbove, dynarrBelow, numBelow * sizeof(unsigned int));
+		numAbove = numBelow;
+	}
+
+	SAFE_DELETE(dynarrEdges);
+	SAFE_DELETE(dynarrBand);
+	SAFE_DELETE(dynarrAbove);
+	SAFE_DELETE(dynarrBelow);
+	return NOPROB;
+}
+
 errCode copySquares(sListSquares *to, const sListSquares *from){
 	if(to == NULL || from == NULL)
 		return ERROR;
@@ -1121,6 +1224,59 @@ int fitNFillSquare(
 	return idx;
 }
 
+/*!\brief	The area the boundries would grow to if fitNFillSquare had to make room for the rectangle, or 0 if it can't. */
+static unsigned long grownArea(
+	const sListSquares *squares,
+	unsigned int holeW, unsigned int holeH,
+	unsigned int maxBoundryW, unsigned int maxBoundryH
+){
+	if(squares->boundryH >= holeH && squares->boundryW + holeW <= maxBoundryW)
+		return (unsigned long)(squares->boundryW + holeW) * squares->boundryH;
+
+	if(squares->boundryW >= holeW && squares->boundryH + holeH <= maxBoundryH)
+		return (unsigned long)squares->boundryW * (squares->boundryH + holeH);
+
+	if(squares->boundryW + holeW <= maxBoundryW && squares->boundryH + holeH <= maxBoundryH)
+		return (unsigned long)(squares->boundryW + holeW) * (squares->boundryH + holeH);
+
+	return 0;
+}
+
+int fitNFillSquareTurned(
+	sListSquares *squares,
+	unsigned int holeW, unsigned int holeH,
+	unsigned int maxBoundryW, unsigned int maxBoundryH,
+	bool allowTurn, bool *outTurned
+){
+	unsigned long areaUpright, areaTurned;
+	bool turn = FALSE;
+
+	if(allowTurn == TRUE && holeW != holeH && squares != NULL){
+		if(squares->num == 0){	/** Only turned if it won't go in upright. */
+			if((holeW > maxBoundryW || holeH > maxBoundryH) && holeH <= maxBoundryW && holeW <= maxBoundryH)
+				turn = TRUE;
+
+		}else if(canFitSquare(squares, holeW, holeH) < 0){
+			if(canFitSquare(squares, holeH, holeW) >= 0){
+				turn = TRUE;
+			}else{
+				areaUpright = grownArea(squares, holeW, holeH, maxBoundryW, maxBoundryH);
+				areaTurned = grownArea(squares, holeH, holeW, maxBoundryW, maxBoundryH);
+				if(areaTurned > 0 && (areaUpright == 0 || areaTurned < areaUpright))
+					turn = TRUE;
+			}
+		}
+	}
+
+	if(outTurned != NULL)
+		*outTurned = turn;
+
+	if(turn == TRUE)
+		return fitNFillSquare(squares, holeH, holeW, maxBoundryW, maxBoundryH);
+
+	return fitNFillSquare(squares, holeW, holeH, maxBoundryW, maxBoundryH);
+}
+
 errCode shrinkwrapSquares(sListSquares *wrapme){
 	return NOPROB;
 }
@@ -93,6 +93,12 @@ void cleanupListSquares(sListSquares *cleanMe);
  */
 errCode fillSquare(sListSquares *squares, unsigned int idxFillMe, unsigned int w, unsigned int h);
 
+/*!\brief	Makes a square list for the given boundries, with the given squares already filled. The space around them is
+ * 			cut into horizontal bands, and holes are made for the gaps in each band (joining any that line up with the band above).
+ *!\note	The filled squares must not overlap, or go outside the boundries.
+ */
+errCode genSquaresAround(sListSquares *out, unsigned int w, unsigned int h, const sSquare *arrFills, unsigned int numFills);
+
 /*!\brief	Copy the square list into another. Cleans up the target if not null.
  */
 errCode copySquares(sListSquares *to, const sListSquares *from);
@@ -119,5 +125,17 @@ int fitNFillSquare(
 	unsigned int maxBoundryW, unsigned int maxBoundryH
 );
 
+/*!\brief	Same as fitNFillSquare, but can turn the rectangle a quarter turn, so it's holeH wide and holeW high, when that
+ *			fits a hole it wouldn't otherwise, or makes the boundries grow less.
+ *!\param	allowTurn	If FALSE, it's just fitNFillSquare.
+ *!\param	outTurned	Set to TRUE if the rectangle was turned.
+ */
+int fitNFillSquareTurned(
+	sListSquares *squares,
+	unsigned int holeW, unsigned int holeH,
+	unsigned int maxBoundryW, unsigned int maxBoundryH,
+	bool allowTurn, bool *outTurned
+);
+
 
 #endif
@@ -94,6 +94,116 @@ bool hasWildStr(const char *findIn, const char *wildStr){
 	return FALSE;
 }
 
+static bool isWild(char c){
+	return (c == '*' || c == '#') ? TRUE : FALSE;
+}
+
+void compileWildStr(const char *wildStr, sWildMatch *outMatch){
+	unsigned int i, j;
+	sWildOp *refOp;
+
+	memset(outMatch, 0, sizeof(sWildMatch));
+	outMatch->len = (wildStr != NULL) ? strlen(wildStr) : 0;
+	outMatch->dynarrOps = calloc_chk(outMatch->len +1, sizeof(sWildOp));
+
+	for(i=0; i <= outMatch->len; ++i){
+		refOp = &outMatch->dynarrOps[i];
+		refOp->c = (i < outMatch->len) ? wildStr[i] : '\0';
+
+		for(j=i; j > 0 && isWild(wildStr[j]) == FALSE; --j)
+			;
+		refOp->rewind = j;
+	}
+
+	for(i=outMatch->len +1; i > 0; --i){	/** Backwards, so each run of stars can use the answer from the one after. */
+		refOp = &outMatch->dynarrOps[i-1];
+		if(refOp->c == '*')
+			refOp->skipStars = (i < outMatch->len) ? outMatch->dynarrOps[i].skipStars : outMatch->len;
+		else
+			refOp->skipStars = i-1;
+	}
+}
+
+bool matchWildStr(const char *findIn, const sWildMatch *refMatch){
+	const sWildOp *ops;
+	const unsigned int lenB = (refMatch != NULL) ? refMatch->len : 0;
+	char nextNonWild = '\0';
+	char const *refFound;
+	unsigned int idxA=0, idxB=0;
+
+	if(findIn == NULL || findIn[0] == '\0' || lenB == 0)
+		return FALSE;
+
+	ops = refMatch->dynarrOps;
+
+	/** This follows hasWildStr step for step, it just doesn't have to look at the wildcard to know where to go. */
+	while(findIn[idxA] != '\0' && idxB < lenB){
+		if(ops[idxB].c == '*'){
+			idxB = ops[idxB].skipStars;
+			if(idxB == lenB)
+				return TRUE;
+
+			nextNonWild = ops[idxB].c;
+
+		}else if(ops[idxB].c == '#'){
+			nextNonWild = '#';
+			++idxB;
+		}
+
+		if(nextNonWild != '\0'){
+			if(nextNonWild == '#'){
+				if(findIn[idxA] == ops[idxB].c || (ops[idxB].c == '*' && isNum(findIn[idxA]) == FALSE)){
+					nextNonWild = '\0';
+					++idxB;
+
+					if(idxA == 0 || isNum(findIn[idxA-1]) == FALSE)
+						return FALSE;
+
+				}else if(isNum(findIn[idxA]) == FALSE){
+					return FALSE;
+				}
+
+			}else{
+				if(findIn[idxA] != nextNonWild){	/** Nothing happens until we reach the character. */
+					refFound = strchr(&findIn[idxA], nextNonWild);
+					if(refFound == NULL)
+						return FALSE;
+
+					idxA = (unsigned int)(refFound - findIn);
+				}
+
+				nextNonWild = '\0';
+				++idxB;
+			}
+
+		}else if(findIn[idxA] != ops[idxB].c){
+			idxB = ops[idxB].rewind;
+			if(idxB == 0 && isWild(ops[0].c) == FALSE)
+				return FALSE;
+
+		}else{
+			nextNonWild = '\0';
+			++idxB;
+		}
+		++idxA;
+	}
+
+	if(ops[idxB].c == '*')
+		return TRUE;
+	else if(nextNonWild == '\0' && idxB > 0 && findIn[idxA-1] == ops[idxB-1].c)
+		return TRUE;
+
+	return FALSE;
+}
+
+void cleanupWildStr(sWildMatch *match){
+	if(match == NULL)
+		return;
+
+	SAFE_DELETE(match->dynarrOps);
+	match->len = 0;
+}
+
 void copyString(char **strGoesHere, const char *copyMe){
 	size_t len = strlen(copyMe);
 	(*strGoesHere) = calloc(len + 1, sizeof(char));
@@ -169,34 +279,216 @@ compare higherString(const char *higher, const char *lower){
 	return SAME;
 }
 
-void sortStrings(char **dynarrStrings, size_t count){
-	char **dynarr = calloc(count, sizeof(char*));
-	memset(dynarr, 0, sizeof(char*)*count);
+/*!\brief	A run of digits, or a single character, from a string being sorted. */
+typedef struct defSortToken{
+	int num;	/*!< What atoi makes of the run of digits. */
+	char c;		/*!< The character, or the first digit of the run. */
+	bool isNum;
+} sSortToken;
+
+/*!\brief	A string cut up into tokens ahead of sorting, so comparing doesn't have to read the numbers every time. */
+typedef struct defSortKey{
+	char *str;
+	sSortToken *refTokens;
+	size_t numTokens;
+	size_t group;	/*!< Strings that compare the same share a group. Groups are numbered from the highest. */
+} sSortKey;
+
+/*!\brief	Cuts the string into tokens, the same way higherString steps through it.
+ *!\return	How many tokens were written.
+ */
+static size_t tokeniseString(const char *str, sSortToken *outTokens){
+	size_t i=0, num=0;
 
-	size_t cur, scan;
-	char *bubble;
-	for(cur=0; cur < count; ++cur){
-		scan=0;
-		bubble = dynarrStrings[cur];
+	while(str[i] != '\0'){
+		outTokens[num].c = str[i];
+		outTokens[num].isNum = isNum(str[i]) ? TRUE : FALSE;
 
-		while(scan < cur){
-			if(dynarr[scan]==NULL)
-				break;
+		if(outTokens[num].isNum == TRUE){
+			outTokens[num].num = atoi(&str[i]);
+			while(str[i] != '\0' && isNum(str[i]))
+				++i;
+		}else{
+			outTokens[num].num = 0;
+			++i;
+		}
+		++num;
+	}
+
+	return num;
+}
+
+/*!\brief	Same result as higherString, on strings that have been tokenised. */
+static compare compareSortKeys(const sSortKey *higher, const sSortKey *lower){
+	size_t i, num;
+	sSortToken const *refH, *refL;
 
-			if(higherString(bubble, dynarr[scan]) == GREATER){
-				char *tmp = bubble;
-				bubble = dynarr[scan];
-				dynarr[scan] = tmp;
+	if(higher->str == NULL || lower->str == NULL)
+		return higherString(higher->str, lower->str);
+
+	num = (higher->numTokens < lower->numTokens) ? higher->numTokens : lower->numTokens;
+	for(i=0; i < num; ++i){
+		refH = &higher->refTokens[i];
+		refL = &lower->refTokens[i];
+
+		if(refH->isNum == TRUE && refL->isNum == TRUE){
+			if(refH->num > refL->num)
+				return GREATER;
+			else if(refL->num > refH->num)
+				return LESS;
+
+		}else if(refH->c > refL->c){
+			return GREATER;
+		}else if(refL->c > refH->c){
+			return LESS;
+		}
+	}
+
+	if(higher->numTokens > num)
+		return LESS;
+	else if(lower->numTokens > num)
+		return GREATER;
+
+	return SAME;
+}
+
+/*!\brief	Stable merge sort, highest first. */
+static void mergeSortKeys(sSortKey **arrKeys, sSortKey **arrTemp, size_t count){
+	size_t width, start, mid, end, l, r, o;
+	sSortKey **refFrom = arrKeys;
+	sSortKey **refTo = arrTemp;
+	sSortKey **refSwap;
+
+	for(width=1; width < count; width *= 2){
+		for(start=0; start < count; start += width *2){
+			mid = (start + width < count) ? start + width : count;
+			end = (mid + width < count) ? mid + width : count;
+
+			for(l=start, r=mid, o=start; o < end; ++o){
+				if(r < end && (l == mid || compareSortKeys(refFrom[r], refFrom[l]) == GREATER))
+					refTo[o] = refFrom[r++];
+				else
+					refTo[o] = refFrom[l++];
 			}
+		}
+
+		refSwap = refFrom;
+		refFrom = refTo;
+		refTo = refSwap;
+	}
+
+	if(refFrom != arrKeys)
+		memcpy(arrKeys, refFrom, count * sizeof(sSortKey*));
+}
+
+/*!\brief	How many of the first 'pos' keys in the input have been marked. A Fenwick tree, one bigger than the input. */
+static size_t countMarked(const size_t *arrTree, size_t pos){
+	size_t num = 0;
+
+	for(; pos > 0; pos &= pos -1)
+		num += arrTree[pos];
+
+	return num;
+}
+
+static void markKey(size_t *arrTree, size_t count, size_t idxKey){
+	size_t pos;
+
+	for(pos = idxKey +1; pos <= count; pos += pos & (~pos +1))
+		++arrTree[pos];
+}
 
-			++scan;
+/*!\brief	Puts strings that compare the same in the order the old insertion sort left them. It appended each one to
+ *!		the end of its group, and every higher string inserted after that moved the front of the group to the back.
+ *!\param	arrTree		Has every key from a higher group marked, so it can tell how many came between two of the group.
+ *!\param	arrSorted	Keys of the group, in their sorted positions, which are overwritten. The sort is stable, so they're
+ *!				still in the order they came in.
+ */
+static void orderSameGroup(const sSortKey *arrKeys, const size_t *arrTree, size_t count, sSortKey **arrSorted, size_t numSame){
+	size_t i, r, numTurns, head=0, num=0;
+	size_t idxKey, idxNext;
+	sSortKey **dynarrQueue = calloc_chk(numSame, sizeof(sSortKey*));
+
+	for(i=0; i < numSame; ++i){
+		idxKey = (size_t)(arrSorted[i] - arrKeys);
+		idxNext = (i +1 < numSame) ? (size_t)(arrSorted[i +1] - arrKeys) : count;
+
+		dynarrQueue[(head + num) % numSame] = arrSorted[i];
+		++num;
+
+		numTurns = (countMarked(arrTree, idxNext) - countMarked(arrTree, idxKey +1)) % num;
+		for(r=0; r < numTurns; ++r){
+			dynarrQueue[(head + num) % numSame] = dynarrQueue[head];
+			head = (head +1) % numSame;
 		}
+	}
+
+	for(i=0; i < numSame; ++i)
+		arrSorted[i] = dynarrQueue[(head + i) % numSame];
 
-		dynarr[scan] = bubble;
+	SAFE_DELETE(dynarrQueue);
+}
+
+void sortStrings(char **dynarrStrings, size_t count){
+	size_t i, s, lenTokens, numSame;
+	size_t *dynarrTree;
+	sSortKey *dynarrKeys;
+	sSortKey **dynarrSorted, **dynarrTemp;
+	sSortToken *dynarrTokens, *itrToken;
+
+	if(dynarrStrings == NULL || count < 2)
+		return;
+
+	lenTokens = 0;
+	for(i=0; i < count; ++i){
+		if(dynarrStrings[i] != NULL)
+			lenTokens += strlen(dynarrStrings[i]);
 	}
 
-	memcpy(dynarrStrings, dynarr, sizeof(char*)*count);
-	free(dynarr);
+	dynarrKeys = calloc_chk(count, sizeof(sSortKey));
+	dynarrSorted = calloc_chk(count, sizeof(sSortKey*));
+	dynarrTemp = calloc_chk(count, sizeof(sSortKey*));
+	dynarrTokens = calloc_chk(lenTokens +1, sizeof(sSortToken));
+
+	itrToken = dynarrTokens;
+	for(i=0; i < count; ++i){
+		dynarrKeys[i].str = dynarrStrings[i];
+		dynarrKeys[i].refTokens = itrToken;
+		if(dynarrStrings[i] != NULL)
+			dynarrKeys[i].numTokens = tokeniseString(dynarrStrings[i], itrToken);
+		itrToken += dynarrKeys[i].numTokens;
+		dynarrSorted[i] = &dynarrKeys[i];
+	}
+
+	mergeSortKeys(dynarrSorted, dynarrTemp, count);
+
+	dynarrSorted[0]->group = 0;
+	for(i=1; i < count; ++i){
+		dynarrSorted[i]->group = dynarrSorted[i-1]->group;
+		if(compareSortKeys(dynarrSorted[i-1], dynarrSorted[i]) != SAME)
+			++dynarrSorted[i]->group;
+	}
+
+	dynarrTree = calloc_chk(count +1, sizeof(size_t));
+	for(i=0; i < count; i += numSame){	/** Highest group first, so everything marked is higher than the group being ordered. */
+		for(numSame=1; i + numSame < count && dynarrSorted[i + numSame]->group == dynarrSorted[i]->group; ++numSame)
+			;
+
+		if(numSame > 1)
+			orderSameGroup(dynarrKeys, dynarrTree, count, &dynarrSorted[i], numSame);
+
+		for(s=i; s < i + numSame; ++s)
+			markKey(dynarrTree, count, (size_t)(dynarrSorted[s] - dynarrKeys));
+	}
+	SAFE_DELETE(dynarrTree);
+
+	for(i=0; i < count; ++i)
+		dynarrStrings[i] = dynarrSorted[i]->str;
+
+	SAFE_DELETE(dynarrTokens);
+	SAFE_DELETE(dynarrTemp);
+	SAFE_DELETE(dynarrSorted);
+	SAFE_DELETE(dynarrKeys);
 }
 
 void sanitiseString(char *opInPlace){
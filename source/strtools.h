@@ -35,6 +35,19 @@ typedef enum defCompare{
 	GREATER, LESS, SAME
 } compare;
 
+/*!\brief	One position in a compiled wildcard. */
+typedef struct defWildOp{
+	char c;
+	unsigned int rewind;	/*!< Where a mismatch goes back to: the closest wildcard at or before here, or 0. */
+	unsigned int skipStars;	/*!< First position past the run of '*' starting here. */
+} sWildOp;
+
+/*!\brief	A wildcard worked out ahead of time, so it can be matched against lots of names quickly. */
+typedef struct defWildMatch{
+	sWildOp *dynarrOps;	/*!< One for each character, then one for the end. Cleanup. */
+	unsigned int len;
+} sWildMatch;
+
 static const unsigned short asciNumStart = 48;
 static const unsigned short asciNumEnd = 57;
 
@@ -43,13 +56,25 @@ static const unsigned short asciNumEnd = 57;
 /* !\brief	*/
 bool hasWildStr(const char *findIn, const char *wildStr);
 
+/*!\brief	Works out a wildcard once, for matchWildStr. A null or empty wildcard never matches. */
+void compileWildStr(const char *wildStr, sWildMatch *outMatch);
+
+/*!\brief	Gives the same answer as hasWildStr, without going over the wildcard again or allocating. */
+bool matchWildStr(const char *findIn, const sWildMatch *refMatch);
+
+/*!\brief	*/
+void cleanupWildStr(sWildMatch *match);
+
 /* !\brief	 Creates memory and copies a string into that memory location */
 void copyString(char **strGoesHere, const char *copyMe);
 
 /* !\brief	 Creates memory and copies characters into that memory location, until the end of a give character is found. */
 void copyStringUntil(char **strGoesHere, const char *copyMe, char until);
 
-/*!\brief	Sorts a dynamic array of string pointers. */
+/*!\brief	TRUE for the characters 0 to 9. */
+bool isNum(char c);
+
+/*!\brief	Sorts a dynamic array of string pointers, highest first, with runs of digits compared as numbers. */
 void sortStrings(char **dynarrStrings, size_t count);
 
 /*!\brief	*/
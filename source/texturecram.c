@@ -0,0 +1,341 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "texturecram.h"
+#include "texturepacker.h"
+#include "font.h"
+#include "threadpool.h"
+
+static const char IMAGE_PATTERN[] = "*.png";
+static const unsigned int DEFAULT_MAXSQUARE = 1024;
+
+struct defCram{
+	sCramOptions options;
+	sThreadPool pool;
+};
+
+/*!\brief	Everything made along the way to a pack, cleaned up before the pack returns. */
+typedef struct defCramJob{
+	sTex **dynarrTextures;	/*!< Null terminated. Cleanup, and the content. */
+	sStillList stills;
+	sSeqList seqs;
+	sFontList fonts;
+	sSheetList sheets;
+	sManifest theMan;
+} sCramJob;
+
+void initCramOptions(sCramOptions *outOptions){
+	memset(outOptions, 0, sizeof(sCramOptions));
+	outOptions->maxSquare = DEFAULT_MAXSQUARE;
+	outOptions->format = eCramFormatDefault;
+}
+
+/*!\brief	The internal error codes have the same order, but the public header can't share the type. */
+static eCramResult toCramResult(errCode result){
+	switch(result){
+		case NOPROB:
+			return eCramNoProb;
+
+		case PROBLEM:
+			return eCramProblem;
+
+		default:
+			return eCramError;
+	}
+}
+
+sCram* startCram(const sCramOptions *refOptions){
+	sCram *cram = calloc_chk(1, sizeof(sCram));
+
+	if(refOptions != NULL)
+		cram->options = *refOptions;
+	else
+		initCramOptions(&cram->options);
+
+	if(startThreadPool(&cram->pool, cram->options.numThreads) != NOPROB){
+		SAFE_DELETE(cram);
+		return NULL;
+	}
+
+	return cram;
+}
+
+void stopCram(sCram *cram){
+	if(cram == NULL)
+		return;
+
+	stopThreadPool(&cram->pool);
+	free(cram);
+}
+
+const char* getManifestExtension(eCramFormat format){
+	switch(format){
+		case eCramFormatC:
+		case eCramFormatCPP:
+			return ".h";
+
+		case eCramFormatJava:
+		case eCramFormatJavaPacked:
+			return ".java";
+
+		case eCramFormatBin:
+			return ".bin";
+
+		default:
+			return ".txt";
+	}
+}
+
+errCode writeManifest(
+	FILE *handFile,
+	const sCramOptions *refOptions,
+	const char *strName,
+	const sManifest *refMan,
+	const sTex **refarrTexs
+){
+	switch(refOptions->format){
+		case eCramFormatC:
+			return writeManifestInC(handFile, strName, FALSE, refMan, refarrTexs);
+
+		case eCramFormatCPP:
+			return writeManifestInC(handFile, strName, TRUE, refMan, refarrTexs);
+
+		case eCramFormatJava:
+			return writeManifestInJava(handFile, strName, refOptions->refstrJavapak, refOptions->refstrManClass, refMan, refarrTexs);
+
+		case eCramFormatJavaPacked:
+			return writeManifestInJavaPacked(handFile, strName, refOptions->refstrJavapak, refMan, refarrTexs);
+
+		case eCramFormatBin:
+			return writeManifestInBin(handFile, refMan, refarrTexs);
+
+		default:
+			return writeManifestInTxt(handFile, refMan, refarrTexs);
+	}
+}
+
+errCode saveManifest(
+	const char *strPath,
+	const sCramOptions *refOptions,
+	const char *strName,
+	const sManifest *refMan,
+	const sTex **refarrTexs
+){
+	char buff[OUT_PATH_ROOM + OUT_SUFFIX_ROOM];
+	FILE *handFile;
+	errCode result;
+	int lenPath;
+
+	if(strPath == NULL || refOptions == NULL)
+		return ERROR;
+
+	lenPath = snprintf(buff, sizeof(buff), "%s%s", strPath, getManifestExtension(refOptions->format));
+	if(lenPath < 0 || (size_t)lenPath >= sizeof(buff)){
+		WARN("The path for the manifest %s is too long", strPath);
+		return PROBLEM;
+	}
+
+	handFile = fopen(buff, (refOptions->format == eCramFormatBin) ? "wb" : "w");
+
+	if(handFile == NULL){
+		WARN("Unable to write file %s", buff);
+		return PROBLEM;
+	}
+
+	result = writeManifest(handFile, refOptions, strName, refMan, refarrTexs);
+	fclose(handFile);
+
+	return result;
+}
+
+/*!\brief	Arranges the textures, and puts the manifest and sheets in the output. */
+static errCode packCramJob(sCram *cram, const char *strName, sCramJob *job, sCramOutput *outOutput){
+	char buff[256];
+	char *dynarrMan = NULL;
+	size_t sizeMan = 0;
+	FILE *handFile;
+	errCode result;
+
+	if(job->dynarrTextures == NULL){
+		WARN("No textures found");
+		return PROBLEM;
+	}
+
+	if(arrangeTextures(
+		job->dynarrTextures, &job->seqs, &job->stills, &job->fonts, &job->sheets, cram->options.maxSquare,
+		(cram->options.allowRotate != 0) ? TRUE : FALSE, NULL
+	) != NOPROB)
+		return PROBLEM;
+
+	if(cram->options.pow2Sheets != 0)
+		growSheetsToPow2(&job->sheets);
+
+	if(genMan(
+		strName, &job->seqs, &job->stills, &job->fonts, &job->sheets, (const sTex **)job->dynarrTextures, &job->theMan
+	) != NOPROB)
+		return PROBLEM;
+
+	handFile = open_memstream(&dynarrMan, &sizeMan);
+	if(handFile == NULL){
+		WARN("Unable to write the manifest to memory");
+		return PROBLEM;
+	}
+
+	result = writeManifest(handFile, &cram->options, strName, &job->theMan, (const sTex **)job->dynarrTextures);
+	fclose(handFile);
+
+	snprintf(buff, sizeof(buff), "%s%s", strName, getManifestExtension(cram->options.format));
+	copyString(&outOutput->manifest.strName, buff);
+	outOutput->manifest.dynarrData = (unsigned char*)dynarrMan;
+	outOutput->manifest.size = sizeMan;
+
+	if(result != NOPROB)
+		return result;
+
+	outOutput->numSheets = job->sheets.num;
+	outOutput->dynarrSheets = calloc_chk(job->sheets.num +1, sizeof(sCramFile));
+
+	return encodeSheets(strName, job->dynarrTextures, &job->sheets, cram->options.glyphFormat, outOutput->dynarrSheets, &cram->pool);
+}
+
+static void cleanupCramJob(sCramJob *job){
+	cleanupManifest(&job->theMan);	/** Before the lists it refers to. */
+	cleanupSheetList(&job->sheets);
+	cleanupStillList(&job->stills);
+	cleanupSeqList(&job->seqs);
+	cleanupFontList(&job->fonts);
+	cleanupTextures(&job->dynarrTextures);
+}
+
+/*!\brief	cramDir, with the tool's own error codes. */
+static errCode cramDirJob(sCram *cram, const char *strDir, const char *strName, const char *strIgnores, sCramOutput *outOutput){
+	sCramJob job;	memset(&job, 0, sizeof(sCramJob));
+	sDirListing listing;	memset(&listing, 0, sizeof(sDirListing));
+	sFileList files;	memset(&files, 0, sizeof(sFileList));
+	errCode result = PROBLEM;
+
+	if(cram == NULL || strDir == NULL || strName == NULL || outOutput == NULL)
+		return ERROR;
+
+	memset(outOutput, 0, sizeof(sCramOutput));
+
+	if(scanDir(strDir, &listing) != NOPROB){
+		WARN("Unable to read the directory %s", strDir);
+		return PROBLEM;
+	}
+
+	if(filterFiles(&listing.files, &files, strIgnores, IMAGE_PATTERN) != NOPROB)
+		goto cramDir_end;
+
+	if(files.num > 0){
+		if(genTextures(strDir, &files, &job.dynarrTextures) != NOPROB)
+			goto cramDir_end;
+
+		if(job.dynarrTextures != NULL && sortTextures(job.dynarrTextures, &job.seqs, &job.stills) != NOPROB)
+			goto cramDir_end;
+	}
+
+	if(addFontTextures(strDir, &listing.files, strIgnores, &job.dynarrTextures, &job.fonts, cram->options.refstrGlyphCache, &cram->pool) != NOPROB)
+		goto cramDir_end;
+
+	result = packCramJob(cram, strName, &job, outOutput);
+
+cramDir_end:
+	cleanupCramJob(&job);
+	cleanupFileList(&files);
+	cleanupDirListing(&listing);
+	return result;
+}
+
+/*!\brief	cramImages, with the tool's own error codes. */
+static errCode cramImagesJob(sCram *cram, const char *strName, const sCramFile *arrImages, unsigned int numImages, sCramOutput *outOutput){
+	sCramJob job;	memset(&job, 0, sizeof(sCramJob));
+	errCode result = PROBLEM;
+
+	if(cram == NULL || strName == NULL || outOutput == NULL)
+		return ERROR;
+
+	memset(outOutput, 0, sizeof(sCramOutput));
+
+	if(genTexturesFromMem(arrImages, numImages, &job.dynarrTextures, &cram->pool) != NOPROB)
+		goto cramImages_end;
+
+	if(job.dynarrTextures != NULL && sortTextures(job.dynarrTextures, &job.seqs, &job.stills) != NOPROB)
+		goto cramImages_end;
+
+	result = packCramJob(cram, strName, &job, outOutput);
+
+cramImages_end:
+	cleanupCramJob(&job);
+	return result;
+}
+
+/*!\brief	cramRaw, with the tool's own error codes. */
+static errCode cramRawJob(sCram *cram, const char *strName, const sCramRawImage *arrImages, unsigned int numImages, sCramOutput *outOutput){
+	sCramJob job;	memset(&job, 0, sizeof(sCramJob));
+	errCode resultRaw, result = PROBLEM;
+
+	if(cram == NULL || strName == NULL || outOutput == NULL)
+		return ERROR;
+
+	memset(outOutput, 0, sizeof(sCramOutput));
+
+	resultRaw = genTexturesFromRaw(arrImages, numImages, &job.dynarrTextures);
+	if(resultRaw == ERROR)
+		goto cramRaw_end;
+
+	if(job.dynarrTextures != NULL && sortTextures(job.dynarrTextures, &job.seqs, &job.stills) != NOPROB)
+		goto cramRaw_end;
+
+	result = packCramJob(cram, strName, &job, outOutput);
+	if(result == NOPROB)
+		result = resultRaw;
+
+cramRaw_end:
+	cleanupCramJob(&job);	/** Only frees the pixels that were handed over. */
+	return result;
+}
+
+eCramResult cramDir(sCram *cram, const char *strDir, const char *strName, const char *strIgnores, sCramOutput *outOutput){
+	return toCramResult(cramDirJob(cram, strDir, strName, strIgnores, outOutput));
+}
+
+eCramResult cramImages(sCram *cram, const char *strName, const sCramFile *arrImages, unsigned int numImages, sCramOutput *outOutput){
+	return toCramResult(cramImagesJob(cram, strName, arrImages, numImages, outOutput));
+}
+
+eCramResult cramRaw(sCram *cram, const char *strName, const sCramRawImage *arrImages, unsigned int numImages, sCramOutput *outOutput){
+	return toCramResult(cramRawJob(cram, strName, arrImages, numImages, outOutput));
+}
+
+void cleanupCramOutput(sCramOutput *output){
+	unsigned int i;
+
+	if(output == NULL)
+		return;
+
+	cleanupMemFile(&output->manifest);
+
+	if(output->dynarrSheets != NULL){
+		for(i=0; i < output->numSheets; ++i)
+			cleanupMemFile(&output->dynarrSheets[i]);
+	}
+
+	SAFE_DELETE(output->dynarrSheets);
+	output->numSheets = 0;
+}
@@ -0,0 +1,140 @@
+/*
+ *
+ *  Copyright (C) 2012  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *	libtexturecram: everything the tpak command does, without the command line. Pack a directory, PNGs that are
+ *	already in memory or pixels that are already decoded, and get the sheets and manifest back in memory, without
+ *	any files being written.
+ *	This is the only header you need, and it can be included from C or C++. Everything in it is prefixed, so it
+ *	won't clash with your own types. The steps that make up a pack are in texturepacker.h and font.h, but those
+ *	are the tool's own headers, and only for C.
+ *
+ */
+
+#ifndef TEXTURECRAM_H
+#define TEXTURECRAM_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	What the library's calls give back. */
+typedef enum defCramResult{
+	eCramNoProb = 0,	/*!< Everything went. */
+	eCramProblem,		/*!< Something couldn't be done, but what could be is still there. */
+	eCramError		/*!< Bad arguments, or it couldn't go ahead at all. */
+} eCramResult;
+
+/*!\brief	Zero or not, so it mixes with whichever bool the caller uses. */
+typedef int cramBool;
+
+typedef enum defCramFormat{
+	eCramFormatDefault, eCramFormatC, eCramFormatCPP, eCramFormatJava, eCramFormatBin, eCramFormatJavaPacked
+} eCramFormat;
+
+/*!\brief	What a sheet holding nothing but glyphs is written as. Sheets with any images on are always RGBA. */
+typedef enum defCramGlyphFormat{
+	eCramGlyphRGBA,	/*!< White, with the coverage in the alpha. */
+	eCramGlyphGray,	/*!< The coverage as a gray PNG. */
+	eCramGlyphGrayAlpha,	/*!< White, with the coverage in the alpha of a gray and alpha PNG. */
+	eCramGlyphR8		/*!< The coverage as raw bytes, a row at a time, in a '.r8' file instead of a PNG. */
+} eCramGlyphFormat;
+
+/*!\brief	A file's worth of bytes, kept in memory instead of being read from or written to disk. */
+typedef struct defCramFile{
+	char *strName;			/*!< Name as if it were a file, so "walk_2.png" is frame 2 of walk. Cleanup. */
+	unsigned char *dynarrData;	/*!< Cleanup. */
+	size_t size;
+} sCramFile;
+
+/*!\brief	Pixels that have already been decoded, 8 bit RGBA with the red byte first. */
+typedef struct defCramRawImage{
+	const char *strName;		/*!< Name as if it were a file, so "walk_2.png" is frame 2 of walk. */
+	const unsigned char *refPixels;	/*!< First byte of the top row. */
+	size_t stride;			/*!< Bytes from the start of one row to the next, at least w *4. */
+	unsigned int w, h;
+	cramBool handOver;		/*!< The texture takes the pixels and frees them, so they must come from malloc. */
+} sCramRawImage;
+
+/*!\brief	How to pack, the same as the command line switches. */
+typedef struct defCramOptions{
+	unsigned int maxSquare;		/*!< The max size each sheet can reach. */
+	eCramFormat format;		/*!< What the manifest is written as. */
+	char const *refstrJavapak;	/*!< Package for java manifests, can be null. */
+	char const *refstrManClass;	/*!< Class java manifest entries inherit off, can be null. */
+	unsigned int numThreads;	/*!< Zero for one on each core. */
+	eCramGlyphFormat glyphFormat;	/*!< What sheets with only glyphs on are written as. */
+	char const *refstrGlyphCache;	/*!< Directory rendered glyphs are kept in between runs, can be null. */
+	cramBool allowRotate;		/*!< Images can go on the sheets turned a quarter turn, when it packs them tighter. */
+	cramBool pow2Sheets;		/*!< Sheets are grown to a power of 2 across and down, for hardware that needs it. */
+} sCramOptions;
+
+/*!\brief	What a pack gives back, all in memory. */
+typedef struct defCramOutput{
+	sCramFile manifest;		/*!< Named with the extension for the format. Cleanup. */
+	sCramFile *dynarrSheets;	/*!< PNGs, or '.r8' for glyph sheets written as eCramGlyphR8, named the way the manifest refers to them. Cleanup. */
+	unsigned int numSheets;
+} sCramOutput;
+
+/*!\brief	Keeps the threads around between packs. Safe to pack with from more than one thread at a time. */
+typedef struct defCram sCram;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Fills in the same defaults the command line uses. */
+void initCramOptions(sCramOptions *outOptions);
+
+/*!\brief	Starts the threads that packing is done on.
+ *!\param	refOptions	Copied, so it doesn't need to stay around. Null for the defaults.
+ *!\return	Null if the threads couldn't be started. Stop it with stopCram.
+ */
+sCram* startCram(const sCramOptions *refOptions);
+
+/*!\brief	Waits for anything still running, then cleans up the threads and the cram itself. */
+void stopCram(sCram *cram);
+
+/*!\brief	Packs the PNGs and fonts in a directory, but doesn't look in the directories nested in it.
+ *!\param	strName		Name the sheets and manifest go under.
+ *!\param	strIgnores	Wildcard for files to leave out, can be null.
+ */
+eCramResult cramDir(sCram *cram, const char *strDir, const char *strName, const char *strIgnores, sCramOutput *outOutput);
+
+/*!\brief	Packs PNGs that are already in memory. The file names are used the same way as they are for a directory,
+ *!		so "walk_1.png" and "walk_2.png" are a sequence.
+ *!\param	arrImages	Only read, so they stay yours.
+ */
+eCramResult cramImages(sCram *cram, const char *strName, const sCramFile *arrImages, unsigned int numImages, sCramOutput *outOutput);
+
+/*!\brief	Packs pixels that are already decoded. They aren't copied until they're put on the sheets.
+ *!\param	arrImages	Pixels that aren't handed over are only read, and only need to last until this returns.
+ *!\return	eCramProblem if any images had a bad size. The rest are still packed.
+ */
+eCramResult cramRaw(sCram *cram, const char *strName, const sCramRawImage *arrImages, unsigned int numImages, sCramOutput *outOutput);
+
+/*!\brief	*/
+void cleanupCramOutput(sCramOutput *output);
+
+/*!\brief	Extension the manifest file has for the format, with the dot. */
+const char* getManifestExtension(eCramFormat format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
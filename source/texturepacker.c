@@ -21,16 +21,29 @@
 
 #include "texturepacker.h"
 #include "squarefit.h"
+#include "pixelrows.h"
+
+#include <sys/mman.h>
 
 #ifndef png_jmpbuf
 #	define png_jmpbuf(png_ptr) ((png_ptr)->png_jmpbuf)
 #endif
 
+const size_t PNGHEAD_SIZE = 8;
+const int DEFAULT_BITDEPTH = 8;
+const int DEFAULT_BYTE_PP = 4;
+const int DEFAULT_COLOURTYPE = PNG_COLOR_TYPE_RGB_ALPHA;
+const int DEFAULT_INTERLACE = PNG_INTERLACE_NONE;
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void myPNGWarnFoo(png_structp pngptrData, png_const_charp warning_msg){
-	printf("%s\n", warning_msg);
+	logText(eLogWarn, "%s\n", warning_msg);
+}
+
+unsigned int getTexBytesPP(const sTex *refTex){
+	return (refTex->colorType == PNG_COLOR_TYPE_GRAY) ? 1 : DEFAULT_BYTE_PP;
 }
 
 static errCode readTexToSheet(
@@ -40,7 +53,10 @@ static errCode readTexToSheet(
 	unsigned int sheetH,
 	const png_size_t sizeRow
 ){
-	if(refptrTex->x + refptrTex->w > sheetW || refptrTex->y + refptrTex->h > sheetH){
+	const unsigned int sheetTexW = (refptrTex->rotated == TRUE) ? refptrTex->h : refptrTex->w;
+	const unsigned int sheetTexH = (refptrTex->rotated == TRUE) ? refptrTex->w : refptrTex->h;
+
+	if(refptrTex->x + sheetTexW > sheetW || refptrTex->y + sheetTexH > sheetH){
 		WARN("Sheet overflow");
 		return PROBLEM;
 	}
@@ -51,6 +67,7 @@ static errCode readTexToSheet(
 	}
 
 	const unsigned int sizePix = (unsigned int)((sizeRow / sheetW) / sizeof(png_byte));
+	const unsigned int sizeTexPix = getTexBytesPP(refptrTex);
 	
 	unsigned int row;
 	for(row=0; row < refptrTex->h; ++row){
@@ -58,10 +75,27 @@ static errCode readTexToSheet(
 			WARN("Texture underflow");
 			return PROBLEM;
 		}
-		memcpy(
-			&buffImg[ refptrTex->y + row ][ refptrTex->x * sizePix ],
-			refptrTex->dynarrRows[row],
-			refptrTex->w * sizePix
+
+		if(refptrTex->rotated == TRUE){
+			continue;	/** Copied in one go once every row is known to be there. */
+
+		}else if(sizeTexPix == sizePix){
+			memcpy(
+				&buffImg[ refptrTex->y + row ][ refptrTex->x * sizePix ],
+				refptrTex->dynarrRows[row],
+				refptrTex->w * sizePix
+			);
+		}else{
+			/** Glyphs go on sheets with more channels as white, with their coverage in the alpha. */
+			expandCoverageRow(&buffImg[ refptrTex->y + row ][ refptrTex->x * sizePix ], refptrTex->dynarrRows[row], refptrTex->w, sizePix);
+		}
+	}
+
+	if(refptrTex->rotated == TRUE){
+		rotateRowsCW(
+			&buffImg[refptrTex->y], (size_t)refptrTex->x * sizePix,
+			(const unsigned char * const *)refptrTex->dynarrRows, refptrTex->w, refptrTex->h,
+			sizeTexPix, sizePix
 		);
 	}
 	return NOPROB;
@@ -82,213 +116,577 @@ errCode cleanupPNGImg(png_struct *pngptrData, png_byte ***buffImg){
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/*!\brief	Decodes a single PNG into a texture, from wherever the stream is reading. The stream is left open.
+ *!\param	strSource	Where the stream is reading from, for the log.
+ *!\return	NULL if it isn't a PNG. A texture that failed to decode is still returned, with no size.
+ */
+static sTex* readTexStream(FILE *handFile, const char *strSource, const char *strFileName){
+	png_byte header[PNGHEAD_SIZE];
+	sTex *refTex;
+
+	if(	fread(header, sizeof(png_byte), PNGHEAD_SIZE, handFile) == PNGHEAD_SIZE
+		&& png_sig_cmp(header, 0, PNGHEAD_SIZE) == 0
+	){
+		XTRA_LOG("File %s opened as PNG", strSource);
+
+	}else{
+		WARN("File %s isn't a PNG", strSource);
+		return NULL;
+	}
+
+	refTex = (sTex*)malloc_chk(sizeof(sTex));
+	memset(refTex, 0, sizeof(sTex));
+
+	refTex->pngptrData = png_create_read_struct(
+		PNG_LIBPNG_VER_STRING, NULL, NULL, &myPNGWarnFoo
+	);
+
+	if(refTex->pngptrData == NULL){
+		WARN("Unable to create png struct");
+		return refTex;
+	}
+
+	if(setjmp(png_jmpbuf(refTex->pngptrData)) != 0){ 	/** jumps here on errors. */
+		cleanupPNGImg(
+			refTex->pngptrData,
+			&refTex->dynarrRows
+		);
+		png_destroy_read_struct(
+			&(refTex->pngptrData),
+			&(refTex->pngptrInfo),
+			NULL
+		);
+		refTex->h = refTex->w = 0;
+
+	}else{
+		refTex->pngptrInfo = png_create_info_struct(
+			refTex->pngptrData
+		);
+
+		if(refTex->pngptrInfo == NULL){
+			WARN("Unable to create png info struct");
+			return refTex;
+		}
+
+		/** setup PNG decode */
+		png_init_io(refTex->pngptrData, handFile);
+		png_set_sig_bytes(refTex->pngptrData, PNGHEAD_SIZE);
+		png_read_info(refTex->pngptrData, refTex->pngptrInfo);
+
+		png_byte colorCurrent = png_get_color_type(
+			refTex->pngptrData, refTex->pngptrInfo
+		);
+
+		png_set_filler(refTex->pngptrData, 0, PNG_FILLER_AFTER);
+		png_set_packing(refTex->pngptrData);	/** if < 8 bits */
+
+		{
+			png_color_8p sig_bit;
+			if (png_get_sBIT(refTex->pngptrData, refTex->pngptrInfo, &sig_bit))
+				png_set_shift(refTex->pngptrData, sig_bit);
+		}
+
+		switch(colorCurrent){
+			case PNG_COLOR_TYPE_RGB_ALPHA:
+				/** already good */
+			break;
+			case PNG_COLOR_TYPE_RGB:
+				png_set_tRNS_to_alpha(refTex->pngptrData);
+			break;
+			case PNG_COLOR_TYPE_PALETTE:
+				png_set_palette_to_rgb( refTex->pngptrData );
+				png_set_tRNS_to_alpha(refTex->pngptrData);
+			break;
+			case PNG_COLOR_TYPE_GRAY:
+				png_set_expand_gray_1_2_4_to_8( refTex->pngptrData );
+				png_set_tRNS_to_alpha(refTex->pngptrData);
+			break;
+			default:
+				WARN("unsupported colour");
+			break;
+		}
+
+		png_read_update_info(refTex->pngptrData, refTex->pngptrInfo);
+
+		colorCurrent = png_get_color_type(
+			refTex->pngptrData, refTex->pngptrInfo
+		);
+
+		if(colorCurrent != PNG_COLOR_TYPE_RGB_ALPHA){
+			logText(eLogWarn, "<warning> %s didn't convert to the right colour type\n", strFileName);
+			png_destroy_read_struct(&refTex->pngptrData, &refTex->pngptrInfo, (png_infopp)NULL);
+			return refTex;
+		}
+
+		refTex->colorType = colorCurrent;
+
+		const int numPasses = png_set_interlace_handling( refTex->pngptrData );
+
+		/** setup other data */
+		copyString(&refTex->name, strFileName);
+
+		/** setup texture */
+		unsigned int row;
+		const png_uint_32 sizeRow = png_get_rowbytes( refTex->pngptrData, refTex->pngptrInfo );
+
+		refTex->w = png_get_image_width(
+			refTex->pngptrData, refTex->pngptrInfo
+		);
+		refTex->h = png_get_image_height(
+			refTex->pngptrData, refTex->pngptrInfo
+		);
+
+		if(sizeRow/refTex->w != DEFAULT_BYTE_PP){
+			WARN("%s didn't convert to the right bit depth", refTex->name);
+			png_destroy_read_struct(&refTex->pngptrData, &refTex->pngptrInfo, (png_infopp)NULL);
+			return refTex;
+		}
+
+		refTex->dynarrRows = calloc_chk((refTex->h +1), sizeof(png_byte*));
+		refTex->dynarrRows[refTex->h] = NULL;
+
+		for(row = 0; row < refTex->h; ++row)
+			refTex->dynarrRows[row] = png_malloc(refTex->pngptrData, sizeRow);
+
+		unsigned int pass;
+		for(pass=0; pass < numPasses; ++pass){
+			for(row = 0; row < refTex->h; ++row){
+				png_read_rows(
+					refTex->pngptrData,
+					&refTex->dynarrRows[row],
+					NULL,
+					1
+				);
+			}
+		}
+
+		png_read_end(refTex->pngptrData, refTex->pngptrInfo);
+	}
+
+	return refTex;
+}
+
+/*!\brief	Decodes a single PNG file into a texture.
+ *!\return	NULL if the file can't be opened or isn't a PNG. A texture that failed to decode is still returned, with no size.
+ */
+static sTex* readTex(const char *filePath, const char *strFileName){
+	FILE *handFile = fopen(filePath, "rb");
+	sTex *refTex;
+
+	if(handFile == NULL){
+		WARN("Can't open file %s", filePath);
+		return NULL;
+	}
+
+	refTex = readTexStream(handFile, filePath, strFileName);
+	fclose(handFile);
+	return refTex;
+}
+
+/*!\brief	Same as readTex, for a PNG that's already in memory. */
+static sTex* readTexMem(const sCramFile *refFile){
+	FILE *handFile = fmemopen(refFile->dynarrData, refFile->size, "rb");	/** Only read, so it's safe to hand over the data. */
+	sTex *refTex;
+
+	if(handFile == NULL){
+		WARN("Can't read %s from memory", refFile->strName);
+		return NULL;
+	}
+
+	refTex = readTexStream(handFile, refFile->strName, refFile->strName);
+	fclose(handFile);
+	return refTex;
+}
+
+/*!\brief	Adds a texture to the end of a null terminated array. */
+static void pushTex(sTex ***dynarrTextures, unsigned int *pNum, sTex *refTex){
+	++(*pNum);
+	(*dynarrTextures) = (sTex**)realloc_chk((*dynarrTextures), ((*pNum)+1) * sizeof(sTex*));
+	(*dynarrTextures)[(*pNum)-1] = refTex;
+	(*dynarrTextures)[*pNum] = NULL;
+}
+
+/*!\brief	Puts the root directory, with a trailing slash, into the file path buffer.
+ *!\return	Length of the directory part of the path.
+ */
+static size_t startFilePath(const char *rootDir, char *filePath, size_t lenBuff){
+	size_t lenRootDir = strlen(rootDir);
+
+	strncpy(filePath, rootDir, lenBuff);
+	if(lenRootDir>0 && lenRootDir < lenBuff -1 && filePath[lenRootDir-1]!='/'){
+		filePath[lenRootDir] = '/';
+		lenRootDir += 1;
+	}
+
+	return lenRootDir;
+}
+
 errCode genTextures(const char *rootDir, const sFileList *files, sTex ***dynarrTextures){
 	static const size_t BUFFLEN = 1024;
 
-	int numTexs=0;
+	unsigned int numTexs=0;
 	int idxFile = files->num;
 	sTex *refTex;
 
 	if(idxFile <= 0 || rootDir == NULL || rootDir[0] == '\0' || dynarrTextures == NULL)
 		return PROBLEM;
 
-	size_t lenRootDir = strlen(rootDir);
 	char filePath[BUFFLEN];
-	FILE *handFile;
-	png_byte header[PNGHEAD_SIZE];
+	size_t lenRootDir = startFilePath(rootDir, filePath, BUFFLEN);
 
-	strncpy(filePath, rootDir, 1024);
-	if(lenRootDir>0 && filePath[lenRootDir-1]!='/'){
-		filePath[lenRootDir] = '/';
-		lenRootDir += 1;
+	while(idxFile > 0){
+		--idxFile;
+
+		strncpy(&filePath[lenRootDir], files->dynarrFiles[idxFile], BUFFLEN - lenRootDir);
+
+		refTex = readTex(filePath, files->dynarrFiles[idxFile]);
+		if(refTex != NULL)
+			pushTex(dynarrTextures, &numTexs, refTex);
+	}
+	return NOPROB;
+}
+
+/*!\brief	A file that needs decoding, so the files can be decoded at the same time. */
+typedef struct defDecodeJob{
+	char *strPath;		/*!< Cleanup. */
+	const char *strFileName;
+	const sCramFile *refMem;	/*!< Decoded instead of the path, if not null. */
+	unsigned int idxEntry;
+	sLogContext logContext;	/*!< Whoever wanted the file decoded. */
+	sTex *result;
+} sDecodeJob;
+
+static void decodeTask(void *data){
+	sDecodeJob *job = (sDecodeJob*)data;
+	sLogContext prevContext;
+
+	getLogContext(&prevContext);
+	setLogContext(&job->logContext);
+	if(job->refMem != NULL){
+		XTRA_LOG("Decoding %s", job->refMem->strName);
+		job->result = readTexMem(job->refMem);
+	}else{
+		XTRA_LOG("Decoding %s", job->strPath);
+		job->result = readTex(job->strPath, job->strFileName);
 	}
+	setLogContext(&prevContext);
+}
+
+errCode genTexturesFromMem(const sCramFile *arrFiles, unsigned int numFiles, sTex ***dynarrTextures, sThreadPool *pool){
+	unsigned int i, numTexs = 0;
+	sDecodeJob *dynarrJobs;
+	sTaskGroup group;	memset(&group, 0, sizeof(sTaskGroup));
+
+	if(arrFiles == NULL || numFiles == 0 || dynarrTextures == NULL)
+		return PROBLEM;
+
+	dynarrJobs = calloc_chk(numFiles, sizeof(sDecodeJob));
+
+	for(i=0; i < numFiles; ++i){
+		dynarrJobs[i].refMem = &arrFiles[i];
+		getLogContext(&dynarrJobs[i].logContext);
+		dynarrJobs[i].logContext.refstrFile = arrFiles[i].strName;
+
+		if(pool != NULL)
+			submitTask(pool, &group, decodeTask, &dynarrJobs[i]);
+		else
+			decodeTask(&dynarrJobs[i]);
+	}
+
+	if(pool != NULL)
+		waitTaskGroup(pool, &group);
+
+	for(i=0; i < numFiles; ++i){	/** Same order as genTextures, which goes through the list backwards. */
+		if(dynarrJobs[numFiles -1 -i].result != NULL)
+			pushTex(dynarrTextures, &numTexs, dynarrJobs[numFiles -1 -i].result);
+	}
+
+	SAFE_DELETE(dynarrJobs);
+	return NOPROB;
+}
+
+static int compareTexCacheEntries(const void *a, const void *b){
+	return strcmp(
+		((const sTexCacheEntry*)a)->name,
+		((const sTexCacheEntry*)b)->name
+	);
+}
+
+errCode genTexturesCached(const char *rootDir, const sFileList *files, sTexCache *cache, sTex ***dynarrTextures, sThreadPool *pool){
+	static const size_t BUFFLEN = 1024;
+
+	unsigned int numTexs=0;
+	unsigned int i, numKept, numJobs, numOrder;
+	unsigned int numOld;	/*!< The entries from before, which are the sorted ones. */
+	int idxFile = files->num;
+	sFileStamp stamp;
+	sTexCacheEntry key;
+	sTexCacheEntry *refEntry;
+	sDecodeJob *dynarrJobs;
+	unsigned int *dynarrOrder;	/*!< Cache entries in the order the textures go in the array. */
+	sTaskGroup group;	memset(&group, 0, sizeof(sTaskGroup));
+
+	if(idxFile <= 0 || rootDir == NULL || rootDir[0] == '\0' || dynarrTextures == NULL || cache == NULL)
+		return PROBLEM;
+
+	char filePath[BUFFLEN];
+	size_t lenRootDir = startFilePath(rootDir, filePath, BUFFLEN);
+
+	numOld = cache->num;
+	for(i=0; i < cache->num; ++i)
+		cache->dynarrEntries[i].seen = FALSE;
+
+	dynarrJobs = calloc_chk(files->num, sizeof(sDecodeJob));
+	dynarrOrder = calloc_chk(files->num, sizeof(unsigned int));
+	numJobs = numOrder = 0;
 
 	while(idxFile > 0){
 		--idxFile;
 
-		strncpy(&filePath[lenRootDir], files->dynarrFiles[idxFile], 1024 - lenRootDir);
+		strncpy(&filePath[lenRootDir], files->dynarrFiles[idxFile], BUFFLEN - lenRootDir);
+
+		if(getFileStamp(filePath, &stamp) != NOPROB)
+			continue;
+
+		key.name = files->dynarrFiles[idxFile];
+		refEntry = (numOld > 0) ? bsearch(&key, cache->dynarrEntries, numOld, sizeof(sTexCacheEntry), compareTexCacheEntries) : NULL;
+		i = (refEntry != NULL) ? (unsigned int)(refEntry - cache->dynarrEntries) : cache->num;	/** A file isn't listed twice, so new ones are never looked for. */
 
-		handFile = fopen(filePath, "rb");
+		dynarrOrder[numOrder++] = i;
 
-		if(handFile == NULL){
-			WARN("Can't open file %s", filePath);
+		if(i < cache->num && cache->dynarrEntries[i].stamp.mtime == stamp.mtime && cache->dynarrEntries[i].stamp.size == stamp.size){
+			cache->dynarrEntries[i].seen = TRUE;
 			continue;
 		}
 
-		if(	fread(header, sizeof(png_byte), PNGHEAD_SIZE, handFile) == PNGHEAD_SIZE
-			&& png_sig_cmp(header, 0, PNGHEAD_SIZE) == 0
-		){
-			XTRA_LOG("File %s opened as PNG", filePath);
+		if(i == cache->num){
+			++cache->num;
+			cache->dynarrEntries = realloc_chk(cache->dynarrEntries, cache->num * sizeof(sTexCacheEntry));
+			refEntry = &cache->dynarrEntries[i];
+			memset(refEntry, 0, sizeof(sTexCacheEntry));
+			copyString(&refEntry->name, files->dynarrFiles[idxFile]);
 
 		}else{
-			WARN("File %s isn't a PNG", filePath);
-			fclose(handFile);
-			continue;
+			refEntry = &cache->dynarrEntries[i];
+			if(refEntry->tex != NULL)
+				cleanupTex(refEntry->tex);
+			SAFE_DELETE(refEntry->tex);
 		}
 
-		++numTexs;
-		(*dynarrTextures) = (sTex**)realloc_chk((*dynarrTextures), (numTexs+1) * sizeof(sTex*));
-		(*dynarrTextures)[numTexs]=NULL;
+		refEntry->stamp = stamp;
+		refEntry->seen = TRUE;
 
-		refTex = (*dynarrTextures)[numTexs-1] = (sTex*)malloc_chk(sizeof(sTex));
-		memset(refTex, 0, sizeof(sTex));
+		copyString(&dynarrJobs[numJobs].strPath, filePath);
+		dynarrJobs[numJobs].strFileName = files->dynarrFiles[idxFile];
+		dynarrJobs[numJobs].idxEntry = i;
+		getLogContext(&dynarrJobs[numJobs].logContext);
+		dynarrJobs[numJobs].logContext.refstrFile = files->dynarrFiles[idxFile];
+		++numJobs;
+	}
 
-		refTex->pngptrData = png_create_read_struct(
-			PNG_LIBPNG_VER_STRING, NULL, NULL, &myPNGWarnFoo
-		);
+	for(i=0; i < numJobs; ++i){
+		if(pool != NULL)
+			submitTask(pool, &group, decodeTask, &dynarrJobs[i]);
+		else
+			decodeTask(&dynarrJobs[i]);
+	}
 
-		if(refTex->pngptrData == NULL){
-			WARN("Unable to create png struct");
-			fclose(handFile);
-			continue;
-		}
+	if(pool != NULL)
+		waitTaskGroup(pool, &group);
 
-		if(setjmp(png_jmpbuf(refTex->pngptrData)) != 0){ 	/** jumps here on errors. */
-			cleanupPNGImg(
-				refTex->pngptrData,
-				&refTex->dynarrRows
-			);
-			png_destroy_read_struct(
-				&(refTex->pngptrData),
-				&(refTex->pngptrInfo),
-				NULL
-			);
-			refTex->h = refTex->w = 0;
+	for(i=0; i < numJobs; ++i){
+		cache->dynarrEntries[ dynarrJobs[i].idxEntry ].tex = dynarrJobs[i].result;
+		SAFE_DELETE(dynarrJobs[i].strPath);
+	}
 
+	for(i=0; i < numOrder; ++i){
+		refEntry = &cache->dynarrEntries[ dynarrOrder[i] ];
+		if(refEntry->tex != NULL)
+			pushTex(dynarrTextures, &numTexs, refEntry->tex);
+	}
+
+	SAFE_DELETE(dynarrJobs);
+	SAFE_DELETE(dynarrOrder);
+
+	numKept = 0;	/** Forget the files that have gone. */
+	for(i=0; i < cache->num; ++i){
+		refEntry = &cache->dynarrEntries[i];
+		if(refEntry->seen == FALSE){
+			if(refEntry->tex != NULL)
+				cleanupTex(refEntry->tex);
+			SAFE_DELETE(refEntry->tex);
+			SAFE_DELETE(refEntry->name);
 		}else{
-			refTex->pngptrInfo = png_create_info_struct(
-				refTex->pngptrData
-			);
+			cache->dynarrEntries[numKept++] = *refEntry;
+		}
+	}
+	cache->num = numKept;
 
-			if(refTex->pngptrInfo == NULL){
-				WARN("Unable to create png info struct");
-				fclose(handFile);
-				continue;
-			}
+	if(cache->num > 0)	/** Ready to be searched next time. */
+		qsort(cache->dynarrEntries, cache->num, sizeof(sTexCacheEntry), compareTexCacheEntries);
 
-			/** setup PNG decode */
-			png_init_io(refTex->pngptrData, handFile);
-			png_set_sig_bytes(refTex->pngptrData, PNGHEAD_SIZE);
-			png_read_info(refTex->pngptrData, refTex->pngptrInfo);
+	return NOPROB;
+}
 
-			png_byte colorCurrent = png_get_color_type(
-				refTex->pngptrData, refTex->pngptrInfo
-			);
+errCode genTexturesFromRaw(const sCramRawImage *arrImages, unsigned int numImages, sTex ***dynarrTextures){
+	unsigned int i, r, numTexs = 0;
+	const sCramRawImage *refImg;
+	sTex *refTex;
+	errCode result = NOPROB;
 
-			png_set_filler(refTex->pngptrData, 0, PNG_FILLER_AFTER);
-			png_set_packing(refTex->pngptrData);	/** if < 8 bits */
+	if(arrImages == NULL || dynarrTextures == NULL)
+		return ERROR;
 
-			{
-				png_color_8p sig_bit;
-				if (png_get_sBIT(refTex->pngptrData, refTex->pngptrInfo, &sig_bit))
-					png_set_shift(refTex->pngptrData, sig_bit);
-			}
+	for(i=numImages; i > 0; --i){	/** Same order as genTextures, which goes through the list backwards. */
+		refImg = &arrImages[i -1];
 
-			switch(colorCurrent){
-				case PNG_COLOR_TYPE_RGB_ALPHA:
-					/** already good */
-				break;
-				case PNG_COLOR_TYPE_RGB:
-					png_set_tRNS_to_alpha(refTex->pngptrData);
-				break;
-				case PNG_COLOR_TYPE_PALETTE:
-					png_set_palette_to_rgb( refTex->pngptrData );
-					png_set_tRNS_to_alpha(refTex->pngptrData);
-				break;
-				case PNG_COLOR_TYPE_GRAY:
-					png_set_expand_gray_1_2_4_to_8( refTex->pngptrData );
-					png_set_tRNS_to_alpha(refTex->pngptrData);
-				break;
-				default:
-					WARN("unsupported colour");
-				break;
-			}
+		if(refImg->strName == NULL || refImg->refPixels == NULL || refImg->w == 0 || refImg->h == 0
+			|| refImg->stride < (size_t)refImg->w * DEFAULT_BYTE_PP
+		){
+			WARN("Image %s has a bad size, leaving it out", (refImg->strName != NULL) ? refImg->strName : "without a name");
+			if(refImg->handOver != 0)
+				free((void*)refImg->refPixels);
+			result = PROBLEM;
+			continue;
+		}
 
-			png_read_update_info(refTex->pngptrData, refTex->pngptrInfo);
+		refTex = calloc_chk(1, sizeof(sTex));
+		copyString(&refTex->name, refImg->strName);
+		refTex->w = refImg->w;
+		refTex->h = refImg->h;
+		refTex->colorType = PNG_COLOR_TYPE_RGB_ALPHA;
+		refTex->sharedRows = TRUE;
+		if(refImg->handOver != 0)
+			refTex->dynarrPixels = (png_byte*)refImg->refPixels;
 
-			colorCurrent = png_get_color_type(
-				refTex->pngptrData, refTex->pngptrInfo
-			);
+		refTex->dynarrRows = calloc_chk(refTex->h +1, sizeof(png_byte*));
+		for(r=0; r < refTex->h; ++r)	/** Only ever read from, so it's fine to drop the const. */
+			refTex->dynarrRows[r] = (png_byte*)&refImg->refPixels[r * refImg->stride];
 
-			if(colorCurrent != PNG_COLOR_TYPE_RGB_ALPHA){
-				printf("<warning> %s didn't convert to the right colour type\n", files->dynarrFiles[idxFile]);
-				png_destroy_read_struct(&refTex->pngptrData, &refTex->pngptrInfo, (png_infopp)NULL);
-				fclose(handFile);
-				continue;
-			}
+		pushTex(dynarrTextures, &numTexs, refTex);
+	}
 
-			refTex->colorType = colorCurrent;
+	return result;
+}
 
-			const int numPasses = png_set_interlace_handling( refTex->pngptrData );
+/*!\brief	What a texture's name says about the sequence it belongs to. */
+typedef struct defFrameName{
+	unsigned int idxTex;
+	unsigned int group;	/*!< Index of the stem in the grouping, or NO_GROUP if it isn't a frame. */
+	unsigned long frame;
+} sFrameName;
+
+/*!\brief	Textures with the same stem. */
+typedef struct defStemGroup{
+	const char *refStem;	/*!< Start of the first name with this stem. */
+	size_t lenStem;
+	unsigned int hash;
+	unsigned int num;
+	int idxSeq;		/*!< Negative if there's only one, which makes it a still. */
+} sStemGroup;
+
+static const unsigned int NO_GROUP = (unsigned int)-1;
+
+/*!\brief	Splits a name such as 'walk_12.png' into the stem 'walk_' and the frame 12. The stem is everything before
+ *!		the digits in front of the last '.', the same as imgFNameToWSearch, so it's also the sequence's name.
+ *!\return	FALSE if there aren't any digits there, or nothing in front of them.
+ */
+static bool parseFrameName(const char *strName, size_t *outLenStem, unsigned long *outFrame){
+	const char *refDot = strrchr(strName, '.');
+	const char *refDigits = refDot;
 
-			/** setup other data */
-			copyString(&refTex->name, files->dynarrFiles[idxFile]);
+	if(refDot == NULL)
+		return FALSE;
 
-			/** setup texture */
-			unsigned int row;
-			const png_uint_32 sizeRow = png_get_rowbytes( refTex->pngptrData, refTex->pngptrInfo );
+	while(refDigits > strName && isNum(*(refDigits -1)))
+		--refDigits;
 
-			refTex->w = png_get_image_width(
-				refTex->pngptrData, refTex->pngptrInfo
-			);
-			refTex->h = png_get_image_height(
-				refTex->pngptrData, refTex->pngptrInfo
-			);
+	if(refDigits == refDot || refDigits == strName)
+		return FALSE;
 
-			if(sizeRow/refTex->w != DEFAULT_BYTE_PP){
-				WARN("%s didn't convert to the right bit depth", refTex->name);
-				png_destroy_read_struct(&refTex->pngptrData, &refTex->pngptrInfo, (png_infopp)NULL);
-				fclose(handFile);
-				continue;
-			}
+	*outLenStem = (size_t)(refDigits - strName);
+	*outFrame = strtoul(refDigits, NULL, 10);
+	return TRUE;
+}
 
-			refTex->dynarrRows = calloc_chk((refTex->h +1), sizeof(png_byte*));
-			refTex->dynarrRows[refTex->h] = NULL;
-
-			for(row = 0; row < refTex->h; ++row)
-				refTex->dynarrRows[row] = png_malloc(refTex->pngptrData, sizeRow);
-
-			unsigned int pass;
-			for(pass=0; pass < numPasses; ++pass){
-				for(row = 0; row < refTex->h; ++row){
-					png_read_rows(
-						refTex->pngptrData,
-						&refTex->dynarrRows[row],
-						NULL,
-						1
-					);
-				}
-			}
+/*!\brief	Finds the group for the stem, adding one if it's new.
+ *!\param	arrTable	Open addressed, holding the group index plus one, with a power of 2 length.
+ */
+static unsigned int findStemGroup(
+	const char *refStem, size_t lenStem, unsigned int *arrTable, unsigned int lenTable, sStemGroup *arrGroups, unsigned int *pNumGroups
+){
+	const unsigned int hash = hashMem(refStem, lenStem, HASH_START);
+	unsigned int slot = hash & (lenTable -1);
+	sStemGroup *refGroup;
 
-			png_read_end(refTex->pngptrData, refTex->pngptrInfo);
-		}
+	while(arrTable[slot] != 0){
+		refGroup = &arrGroups[ arrTable[slot] -1 ];
+		if(refGroup->hash == hash && refGroup->lenStem == lenStem && memcmp(refGroup->refStem, refStem, lenStem) == 0)
+			return arrTable[slot] -1;
 
-		fclose(handFile);
+		slot = (slot +1) & (lenTable -1);
 	}
-	return NOPROB;
+
+	refGroup = &arrGroups[*pNumGroups];
+	memset(refGroup, 0, sizeof(sStemGroup));
+	refGroup->refStem = refStem;
+	refGroup->lenStem = lenStem;
+	refGroup->hash = hash;
+	refGroup->idxSeq = -1;
+
+	arrTable[slot] = ++(*pNumGroups);
+	return arrTable[slot] -1;
+}
+
+static int compareFrames(const void *a, const void *b){
+	const sFrameName *refA = (const sFrameName*)a;
+	const sFrameName *refB = (const sFrameName*)b;
+
+	if(refA->group != refB->group)	/** Groups are numbered in the order they were first seen. */
+		return (refA->group > refB->group) - (refA->group < refB->group);
+
+	/** Lowest frame first. sortStrings lists walk_10, walk_3, walk_2, walk_1 and genTextures reads that list
+	 *  backwards, so the old adjacency scan always built its sequences as 1, 2, 3, 10. Keep that order. */
+	if(refA->frame != refB->frame)
+		return (refA->frame > refB->frame) - (refA->frame < refB->frame);
+
+	return (refA->idxTex > refB->idxTex) - (refA->idxTex < refB->idxTex);
 }
 
 errCode sortTextures(sTex **arrSortMe, sSeqList *outSeqs, sStillList *outStills){
-	char buff[128];
-	sTexSeq *currentSeq=NULL;
+	unsigned int i, numTexs, numNames, numGroups, numFrames, lenTable, f;
+	size_t lenStem;
+	unsigned long frame;
 	sTex *refTex;
-	bool makeSeq = FALSE;
+	sFrameName *dynarrNames;
+	sStemGroup *dynarrGroups;
+	unsigned int *dynarrTable;
+	sTexSeq *refSeq;
+	errCode result = NOPROB;
 
 	if(arrSortMe == NULL || outSeqs == NULL || outStills==NULL){
 		WARN("bad arguments");
 		return ERROR;
 	}
 
-	size_t i;
-	for(i=0; arrSortMe[i] != NULL; ++i){
-		refTex = arrSortMe[i];
+	for(numTexs=0; arrSortMe[numTexs] != NULL; ++numTexs)
+		;
 
-		if(refTex == NULL){
-			WARN("null in texture array.");
-			continue;
-		}
+	if(numTexs == 0)
+		return NOPROB;
 
-		if(refTex->name == '\0'){
+	for(lenTable=16; lenTable < numTexs *2; lenTable *= 2)
+		;
+
+	dynarrNames = calloc_chk(numTexs, sizeof(sFrameName));
+	dynarrGroups = calloc_chk(numTexs, sizeof(sStemGroup));
+	dynarrTable = calloc_chk(lenTable, sizeof(unsigned int));
+	numNames = numGroups = 0;
+
+	for(i=0; i < numTexs; ++i){	/** Work out each name's stem and frame, once. */
+		refTex = arrSortMe[i];
+
+		if(refTex->name == NULL || refTex->name[0] == '\0'){
 			WARN("texture has no name.");
 			continue;
 		}
@@ -298,75 +696,333 @@ errCode sortTextures(sTex **arrSortMe, sSeqList *outSeqs, sStillList *outStills)
 			continue;
 		}
 
-		if(currentSeq == NULL){
-			if(arrSortMe[i+1] != NULL){
-				imgFNameToWSearch(refTex->name, buff, 128);
-			
-				if(hasWildStr(arrSortMe[i+1]->name, buff) == TRUE){
-					makeSeq = TRUE;
-				}
-			}
+		dynarrNames[numNames].idxTex = i;
+		dynarrNames[numNames].group = NO_GROUP;
 
-		}else{
-			if(hasWildStr(refTex->name, buff) == FALSE)
-				currentSeq = NULL;
-			
-			if(currentSeq == NULL && arrSortMe[i+1] != NULL){
-				imgFNameToWSearch(refTex->name, buff, 128);
-				
-				if(hasWildStr(arrSortMe[i+1]->name, buff) == TRUE){
-					makeSeq = TRUE;
-				}
-			}
-		}
-		
-		if(makeSeq == TRUE){
-			++outSeqs->num;
-			outSeqs->dynarrSeqs = realloc_chk(
-				outSeqs->dynarrSeqs, 
-				outSeqs->num * sizeof(sTexSeq)
-			);
-			currentSeq = &outSeqs->dynarrSeqs[outSeqs->num -1];
-			memset(currentSeq, 0, sizeof(sTexSeq));
-			makeSeq = FALSE;
+		if(parseFrameName(refTex->name, &lenStem, &frame) == TRUE){
+			dynarrNames[numNames].group = findStemGroup(refTex->name, lenStem, dynarrTable, lenTable, dynarrGroups, &numGroups);
+			dynarrNames[numNames].frame = frame;
+			++dynarrGroups[ dynarrNames[numNames].group ].num;
 		}
+		++numNames;
+	}
+
+	for(i=0; i < numGroups; ++i){	/** A stem on its own isn't a sequence. */
+		if(dynarrGroups[i].num > 1)
+			dynarrGroups[i].idxSeq = (int)outSeqs->num++;
+	}
 
-		if(currentSeq == NULL){
+	for(i=0; i < numNames; ++i){
+		if(dynarrNames[i].group == NO_GROUP || dynarrGroups[ dynarrNames[i].group ].idxSeq < 0)
 			++outStills->num;
-			outStills->dynarrTexIDs = realloc_chk(
-				outStills->dynarrTexIDs,
-				(outStills->num) * sizeof(unsigned int)
-			);
-			outStills->dynarrSheetIDs = realloc_chk(
-				outStills->dynarrSheetIDs,
-				(outStills->num) * sizeof(unsigned int)
-			);
-			outStills->dynarrTexIDs[outStills->num -1] = i;
-			outStills->dynarrSheetIDs[outStills->num -1] = -1;
-			
+	}
+
+	if(outStills->num > 0){
+		outStills->dynarrTexIDs = calloc_chk(outStills->num, sizeof(unsigned int));
+		outStills->dynarrSheetIDs = calloc_chk(outStills->num, sizeof(unsigned int));
+	}
+
+	numFrames = f = 0;
+	for(i=0; i < numNames; ++i){	/** Stills keep the order of the textures, and the frames are moved to the front. */
+		if(dynarrNames[i].group == NO_GROUP || dynarrGroups[ dynarrNames[i].group ].idxSeq < 0){
+			outStills->dynarrTexIDs[f] = dynarrNames[i].idxTex;
+			outStills->dynarrSheetIDs[f] = -1;
+			++f;
 		}else{
-			if(currentSeq->num > 0){
-				sTex *firstFrame = arrSortMe[ currentSeq->dynarrTexIDs[0] ];
-				if(refTex->w != firstFrame->w || refTex->h != firstFrame->h){
-					WARN("Frame %s has a different size to other frames.", arrSortMe[i]->name);
-					return ERROR;
-				}
+			dynarrNames[numFrames++] = dynarrNames[i];
+		}
+	}
+
+	if(outSeqs->num > 0){
+		outSeqs->dynarrSeqs = calloc_chk(outSeqs->num, sizeof(sTexSeq));
+		qsort(dynarrNames, numFrames, sizeof(sFrameName), compareFrames);
+	}
+
+	for(i=0; i < numGroups; ++i){
+		if(dynarrGroups[i].idxSeq < 0)
+			continue;
+
+		refSeq = &outSeqs->dynarrSeqs[ dynarrGroups[i].idxSeq ];
+		refSeq->dynarrTexIDs = calloc_chk(dynarrGroups[i].num, sizeof(unsigned int));
+		refSeq->dynarrSheetIDs = calloc_chk(dynarrGroups[i].num, sizeof(unsigned int));
+	}
+
+	for(f=0; f < numFrames; ++f){
+		refSeq = &outSeqs->dynarrSeqs[ dynarrGroups[ dynarrNames[f].group ].idxSeq ];
+		refTex = arrSortMe[ dynarrNames[f].idxTex ];
+
+		if(refSeq->num > 0 && result == NOPROB){
+			sTex *firstFrame = arrSortMe[ refSeq->dynarrTexIDs[0] ];
+			if(refTex->w != firstFrame->w || refTex->h != firstFrame->h){
+				WARN("Frame %s has a different size to other frames.", refTex->name);
+				result = ERROR;
 			}
+		}
 
-			++currentSeq->num;
-			currentSeq->dynarrTexIDs = realloc_chk(
-				currentSeq->dynarrTexIDs,
-				(currentSeq->num) * sizeof(unsigned int)
-			);
-			currentSeq->dynarrSheetIDs = realloc_chk(
-				currentSeq->dynarrSheetIDs,
-				(currentSeq->num) * sizeof(unsigned int)
-			);
-			currentSeq->dynarrTexIDs[currentSeq->num -1] = i;
-			currentSeq->dynarrSheetIDs[currentSeq->num -1] = -1;
+		refSeq->dynarrTexIDs[refSeq->num] = dynarrNames[f].idxTex;
+		refSeq->dynarrSheetIDs[refSeq->num] = -1;
+		++refSeq->num;
+	}
+
+	SAFE_DELETE(dynarrTable);
+	SAFE_DELETE(dynarrGroups);
+	SAFE_DELETE(dynarrNames);
+	return result;
+}
+
+/*!\brief	Scratch space used while putting textures back where the previous layout had them. */
+typedef struct defLayoutSeed{
+	const sLayout *refPrev;
+	bool allowRotate;		/** If not, anything that was turned last time is placed again. */
+	bool *dynarrUsed;		/** One per layout entry, so repeated names don't all land on the same entry. */
+	sListSquares *dynarrHoles;	/** One per previous sheet. */
+	unsigned int *dynarrNumKept;	/** How many textures were put back on each sheet. */
+	int *dynarrFound;		/** The layout entry for each texture in the group we're trying. */
+	unsigned int lenFound;
+} sLayoutSeed;
+
+/*!\brief	Finds an unused layout entry for the texture that has the same dimensions, and wasn't turned unless turning is
+ *			allowed, or a negative if there isn't one. */
+static int findSeedEntry(sLayoutSeed *seed, const sTex *refTex){
+	const sLayoutEntry *refEntry;
+	int idxEntry = findLayoutEntry(seed->refPrev, refTex->name);
+
+	if(idxEntry < 0)
+		return -1;
+
+	for(; (unsigned int)idxEntry < seed->refPrev->num; ++idxEntry){
+		refEntry = &seed->refPrev->dynarrEntries[idxEntry];
+		if(strcmp(refEntry->name, refTex->name) != 0)
+			break;
+
+		if(seed->dynarrUsed[idxEntry] == FALSE && refEntry->w == refTex->w && refEntry->h == refTex->h
+			&& (refEntry->rotated == FALSE || seed->allowRotate == TRUE)
+		)
+			return idxEntry;
+	}
+	return -1;
+}
+
+/*!\brief	Puts every texture in the group back where the previous layout had it, or leaves all of them if any have changed size.
+ *			Nothing can overlap, because every layout entry is only used once and they didn't overlap last time.
+ *!\return	TRUE if the group was kept.
+ */
+static bool keepLayoutGroup(
+	sLayoutSeed *seed,
+	sTex **arrTexs,
+	const unsigned int *arrTexIDs,
+	unsigned int num,
+	sSheetList *pSheets,
+	unsigned int *outSheetIDs
+){
+	const sLayoutEntry *refEntry;
+	sSheet *refSheet;
+	sTex *curTex;
+	unsigned int t;
+
+	if(num == 0)
+		return FALSE;
+
+	if(num > seed->lenFound){
+		seed->dynarrFound = realloc_chk(seed->dynarrFound, num * sizeof(int));
+		seed->lenFound = num;
+	}
+
+	for(t=0; t < num; ++t){
+		seed->dynarrFound[t] = findSeedEntry(seed, arrTexs[ arrTexIDs[t] ]);
+		if(seed->dynarrFound[t] < 0)
+			break;
+
+		seed->dynarrUsed[ seed->dynarrFound[t] ] = TRUE;
+	}
+
+	if(t < num){
+		while(t > 0){
+			--t;
+			seed->dynarrUsed[ seed->dynarrFound[t] ] = FALSE;
 		}
+		return FALSE;
 	}
-	return NOPROB;
+
+	for(t=0; t < num; ++t){
+		curTex = arrTexs[ arrTexIDs[t] ];
+		refEntry = &seed->refPrev->dynarrEntries[ seed->dynarrFound[t] ];
+		refSheet = pSheets->dynarrSheets[refEntry->sheet];
+
+		curTex->x = refEntry->x;
+		curTex->y = refEntry->y;
+		curTex->rotated = refEntry->rotated;
+		outSheetIDs[t] = refEntry->sheet;
+
+		++refSheet->num;
+		refSheet->dynarrTexIDs = realloc_chk(refSheet->dynarrTexIDs, refSheet->num * sizeof(unsigned int));
+		refSheet->dynarrTexIDs[refSheet->num -1] = arrTexIDs[t];
+		++seed->dynarrNumKept[refEntry->sheet];
+
+		if(hashTex(curTex) != refEntry->hash)	/** Same spot, different pixels. */
+			refSheet->changed = TRUE;
+	}
+
+	return TRUE;
+}
+
+/*!\brief	Makes a sheet for every sheet in the previous layout, then puts back all the sequences, stills and fonts that haven't
+ *			changed size. Anything put back is marked as done in the index arrays, and the holes left on each sheet are
+ *			worked out ready for everything else.
+ *!\return	PROBLEM if the holes couldn't be worked out, in which case the layout can't be used.
+ */
+static errCode seedFromLayout(
+	sLayoutSeed *seed,
+	sTex **arrTexs,
+	sSeqList *pSeqs, unsigned int *dynarrSeqIdxs,
+	sStillList *pStills, unsigned int *dynarrStillIdxs,
+	sFontList *pFonts, unsigned int *dynarrFontIdxs,
+	sSheetList *pOutSheets
+){
+	const sLayout *refPrev = seed->refPrev;
+	sSquare *dynarrFills;
+	sSheet *refSheet;
+	sTexSeq *refSeq;
+	sFont *refFnt;
+	sTex *refTex;
+	unsigned int i, t;
+	errCode result = NOPROB;
+
+	seed->dynarrUsed = calloc_chk(refPrev->num +1, sizeof(bool));
+	seed->dynarrHoles = calloc_chk(refPrev->numSheets, sizeof(sListSquares));
+	seed->dynarrNumKept = calloc_chk(refPrev->numSheets, sizeof(unsigned int));
+
+	pOutSheets->num = refPrev->numSheets;
+	pOutSheets->dynarrSheets = calloc_chk(pOutSheets->num, sizeof(sSheet*));
+	for(i=0; i < refPrev->numSheets; ++i){
+		refSheet = pOutSheets->dynarrSheets[i] = malloc_chk(sizeof(sSheet));
+		memset(refSheet, 0, sizeof(sSheet));
+		refSheet->w = refPrev->dynarrSheets[i].w;
+		refSheet->h = refPrev->dynarrSheets[i].h;
+		refSheet->changed = FALSE;
+	}
+
+	for(i=0; i < pSeqs->num; ++i){
+		refSeq = &pSeqs->dynarrSeqs[i];
+		if(refSeq->dynarrSheetIDs == NULL)
+			refSeq->dynarrSheetIDs = calloc_chk(refSeq->num +1, sizeof(unsigned int));
+
+		if(keepLayoutGroup(seed, arrTexs, refSeq->dynarrTexIDs, refSeq->num, pOutSheets, refSeq->dynarrSheetIDs) == TRUE)
+			dynarrSeqIdxs[i] = (unsigned int)-1;
+	}
+
+	if(pStills->num > 0 && pStills->dynarrSheetIDs == NULL)
+		pStills->dynarrSheetIDs = calloc_chk(pStills->num, sizeof(unsigned int));
+
+	for(i=0; i < pStills->num; ++i){
+		if(keepLayoutGroup(seed, arrTexs, &pStills->dynarrTexIDs[i], 1, pOutSheets, &pStills->dynarrSheetIDs[i]) == TRUE)
+			dynarrStillIdxs[i] = (unsigned int)-1;
+	}
+
+	for(i=0; i < pFonts->num; ++i){
+		refFnt = pFonts->dynarrFonts[i];
+		if(refFnt->num == 0)
+			continue;
+
+		refFnt->dynarrSheetIDs = realloc_chk(refFnt->dynarrSheetIDs, refFnt->num * sizeof(unsigned int));
+		if(keepLayoutGroup(seed, arrTexs, refFnt->dynarrTexIDs, refFnt->num, pOutSheets, refFnt->dynarrSheetIDs) == TRUE)
+			dynarrFontIdxs[i] = (unsigned int)-1;
+	}
+
+	for(i=0; i < pOutSheets->num; ++i){
+		refSheet = pOutSheets->dynarrSheets[i];
+		dynarrFills = calloc_chk(refSheet->num +1, sizeof(sSquare));
+		for(t=0; t < refSheet->num; ++t){
+			refTex = arrTexs[ refSheet->dynarrTexIDs[t] ];
+			dynarrFills[t].x = refTex->x;
+			dynarrFills[t].y = refTex->y;
+			dynarrFills[t].w = (refTex->rotated == TRUE) ? refTex->h : refTex->w;
+			dynarrFills[t].h = (refTex->rotated == TRUE) ? refTex->w : refTex->h;
+		}
+
+		if(genSquaresAround(&seed->dynarrHoles[i], refSheet->w, refSheet->h, dynarrFills, refSheet->num) != NOPROB)
+			result = PROBLEM;
+		SAFE_DELETE(dynarrFills);
+	}
+
+	return result;
+}
+
+/*!\brief	Compares the seeded sheets with the previous layout to see which ones need writing again. Any sheets that
+ *			ended up empty are removed, and the sheet IDs are shuffled down to match.
+ */
+static void finishLayoutSeed(
+	sLayoutSeed *seed,
+	sSeqList *pSeqs,
+	sStillList *pStills,
+	sFontList *pFonts,
+	sSheetList *pOutSheets
+){
+	const sLayout *refPrev = seed->refPrev;
+	unsigned int *dynarrRemap;
+	unsigned int i, j, numKeep;
+	sSheet *refSheet;
+
+	for(i=0; i < refPrev->numSheets && i < pOutSheets->num; ++i){
+		refSheet = pOutSheets->dynarrSheets[i];
+		if(	refSheet->num != seed->dynarrNumKept[i]		/** Something new went onto the sheet. */
+			|| refPrev->dynarrSheets[i].num != seed->dynarrNumKept[i]	/** Something was taken off the sheet. */
+			|| refSheet->w != refPrev->dynarrSheets[i].w
+			|| refSheet->h != refPrev->dynarrSheets[i].h
+		)
+			refSheet->changed = TRUE;
+	}
+
+	dynarrRemap = calloc_chk(pOutSheets->num +1, sizeof(unsigned int));
+	numKeep = 0;
+	for(i=0; i < pOutSheets->num; ++i){
+		refSheet = pOutSheets->dynarrSheets[i];
+		if(refSheet->num == 0){
+			dynarrRemap[i] = (unsigned int)-1;
+			SAFE_DELETE(refSheet->dynarrTexIDs);
+			free(refSheet);
+			continue;
+		}
+
+		if(numKeep != i)	/** It's going to be written under a different name. */
+			refSheet->changed = TRUE;
+
+		dynarrRemap[i] = numKeep;
+		pOutSheets->dynarrSheets[numKeep] = refSheet;
+		++numKeep;
+	}
+
+	if(numKeep != pOutSheets->num){
+		pOutSheets->num = numKeep;
+
+		for(i=0; i < pSeqs->num; ++i)
+			for(j=0; j < pSeqs->dynarrSeqs[i].num; ++j)
+				pSeqs->dynarrSeqs[i].dynarrSheetIDs[j] = dynarrRemap[ pSeqs->dynarrSeqs[i].dynarrSheetIDs[j] ];
+
+		for(i=0; i < pStills->num; ++i)
+			pStills->dynarrSheetIDs[i] = dynarrRemap[ pStills->dynarrSheetIDs[i] ];
+
+		for(i=0; i < pFonts->num; ++i)
+			for(j=0; j < pFonts->dynarrFonts[i]->num; ++j)
+				pFonts->dynarrFonts[i]->dynarrSheetIDs[j] = dynarrRemap[ pFonts->dynarrFonts[i]->dynarrSheetIDs[j] ];
+	}
+
+	SAFE_DELETE(dynarrRemap);
+}
+
+static void cleanupLayoutSeed(sLayoutSeed *seed){
+	unsigned int i;
+
+	if(seed->refPrev != NULL){
+		for(i=0; seed->dynarrHoles != NULL && i < seed->refPrev->numSheets; ++i)
+			cleanupListSquares(&seed->dynarrHoles[i]);
+	}
+
+	SAFE_DELETE(seed->dynarrUsed);
+	SAFE_DELETE(seed->dynarrHoles);
+	SAFE_DELETE(seed->dynarrNumKept);
+	SAFE_DELETE(seed->dynarrFound);
+	memset(seed, 0, sizeof(sLayoutSeed));
 }
 
 errCode arrangeTextures(
@@ -375,11 +1031,15 @@ errCode arrangeTextures(
 	sStillList *pStills,
 	sFontList *pFonts,
 	sSheetList *pOutSheets,
-	unsigned int maxSquare
+	unsigned int maxSquare,
+	bool allowRotate,
+	const sLayout *refPrev
 ){
 	unsigned int curW, curH;
+	unsigned int idxSheet, numSeeded, idx;
+	sLayoutSeed seed;
 	int idxFit;
-	bool makeSheet, freshSheet;
+	bool makeSheet, freshSheet, turned;
 	unsigned int curSeq, curStill, curFrame, curFont;
 	sTex *curTex;
 	sSheet *curSheet;
@@ -430,26 +1090,69 @@ errCode arrangeTextures(
 	}else{
 		dynarrFontIdxs = NULL;
 	}
+
+	memset(&seed, 0, sizeof(sLayoutSeed));
+	numSeeded = 0;
+	if(refPrev != NULL && refPrev->numSheets > 0){
+		seed.refPrev = refPrev;
+		seed.allowRotate = allowRotate;
+
+		for(idx=0; idx < refPrev->numSheets; ++idx){
+			if(refPrev->dynarrSheets[idx].w > maxSquare || refPrev->dynarrSheets[idx].h > maxSquare)
+				break;
+		}
+
+		if(idx < refPrev->numSheets || seedFromLayout(
+			&seed, arrTexs,
+			pSeqs, dynarrSeqIdxs,
+			pStills, dynarrStillIdxs,
+			pFonts, dynarrFontIdxs,
+			pOutSheets
+		) != NOPROB){	/** Forget the layout and pack everything from scratch. */
+			WARN("The last layout can't be used, so everything is being packed again.");
+			cleanupLayoutSeed(&seed);
+			cleanupSheetList(pOutSheets);
+
+			for(idx=0; idx < pSeqs->num; ++idx)
+				dynarrSeqIdxs[idx] = idx;
+			for(idx=0; idx < pStills->num; ++idx)
+				dynarrStillIdxs[idx] = idx;
+			for(idx=0; idx < pFonts->num; ++idx)
+				dynarrFontIdxs[idx] = 0;
+		}
+
+		numSeeded = pOutSheets->num;
+	}
 	
 	/** Main arrangement stuff */
+	idxSheet = 0;
 	do{
 		sListSquares holes;	memset(&holes, 0, sizeof(sListSquares));
 
-		++pOutSheets->num;
-		pOutSheets->dynarrSheets = realloc_chk(
-			pOutSheets->dynarrSheets, 
-			pOutSheets->num * sizeof(sSheet*)
-		);
-		curSheet = malloc_chk(sizeof(sSheet));
-		memset(curSheet, 0, sizeof(sSheet));
-		pOutSheets->dynarrSheets[ pOutSheets->num -1 ] = curSheet;
+		if(idxSheet < numSeeded){	/** Fill the holes in the sheets from the last layout before making new ones. */
+			holes = seed.dynarrHoles[idxSheet];
+			memset(&seed.dynarrHoles[idxSheet], 0, sizeof(sListSquares));
+			curSheet = pOutSheets->dynarrSheets[idxSheet];
+			freshSheet = (curSheet->num == 0) ? TRUE : FALSE;
+
+		}else{
+			++pOutSheets->num;
+			pOutSheets->dynarrSheets = realloc_chk(
+				pOutSheets->dynarrSheets, 
+				pOutSheets->num * sizeof(sSheet*)
+			);
+			curSheet = malloc_chk(sizeof(sSheet));
+			memset(curSheet, 0, sizeof(sSheet));
+			curSheet->changed = TRUE;
+			pOutSheets->dynarrSheets[ pOutSheets->num -1 ] = curSheet;
+			freshSheet = TRUE;
+		}
 		
 		makeSheet = FALSE;
-		freshSheet = TRUE;
 		curSeq =curStill =curFont =0; /** retry all the differed stills and sequences*/
 		curW =curH =0;
 	
-		XTRA_LOG("Making sheet %i", (int)pOutSheets->num);
+		XTRA_LOG("Making sheet %i", (int)idxSheet +1);
 		
 		while(makeSheet==FALSE && (dynarrSeqIdxs != NULL || dynarrStillIdxs != NULL || dynarrFontIdxs != NULL) ){
 			const bool endOfSeqs = (curSeq < pSeqs->num) ? FALSE : TRUE;
@@ -485,7 +1188,7 @@ errCode arrangeTextures(
 									goto arrangeTextures_fail;
 								}
 
-								idxFit = fitNFillSquare(&tmpHoles, curTex->w, curTex->h, maxSquare, maxSquare);
+								idxFit = fitNFillSquareTurned(&tmpHoles, curTex->w, curTex->h, maxSquare, maxSquare, allowRotate, NULL);
 								if(idxFit < 0)
 									break;
 							
@@ -497,7 +1200,8 @@ errCode arrangeTextures(
 						}
 
 						if(idxFit >= 0 || freshSheet == TRUE){
-							refSeq->dynarrSheetIDs = calloc_chk(refSeq->num, sizeof(unsigned int));
+							if(refSeq->dynarrSheetIDs == NULL)
+								refSeq->dynarrSheetIDs = calloc_chk(refSeq->num, sizeof(unsigned int));
 
 							if(dynarrPrevFrame[curSeq] != (unsigned int)-1)
 								curFrame = dynarrPrevFrame[curSeq];
@@ -506,12 +1210,13 @@ errCode arrangeTextures(
 
 							while(curFrame < refSeq->num){
 								curTex = arrTexs[ refSeq->dynarrTexIDs[curFrame] ];
-								idxFit = fitNFillSquare(&holes, curTex->w, curTex->h, maxSquare, maxSquare);
+								idxFit = fitNFillSquareTurned(&holes, curTex->w, curTex->h, maxSquare, maxSquare, allowRotate, &turned);
 								if(idxFit >= 0){
 									refSqr = &(holes.dynarrSquares[idxFit]);
-									refSeq->dynarrSheetIDs[curFrame] = (unsigned int)(pOutSheets->num -1);
+									refSeq->dynarrSheetIDs[curFrame] = idxSheet;
 									curTex->x = refSqr->x;
 									curTex->y = refSqr->y;
+									curTex->rotated = turned;
 
 									++curSheet->num;
 									curSheet->dynarrTexIDs = realloc_chk(
@@ -555,12 +1260,13 @@ errCode arrangeTextures(
 						goto arrangeTextures_fail;
 					}
 				
-					idxFit = fitNFillSquare(&holes, curTex->w, curTex->h, maxSquare, maxSquare);
+					idxFit = fitNFillSquareTurned(&holes, curTex->w, curTex->h, maxSquare, maxSquare, allowRotate, &turned);
 					if(idxFit >= 0){
 						refSqr = &(holes.dynarrSquares[idxFit]);
 						curTex->x = refSqr->x;
 						curTex->y = refSqr->y;
-						pStills->dynarrSheetIDs[curStill] = (unsigned int)(pOutSheets->num -1);
+						curTex->rotated = turned;
+						pStills->dynarrSheetIDs[curStill] = idxSheet;
 						curSheet->dynarrTexIDs = realloc_chk(
 							curSheet->dynarrTexIDs, 
 							(curSheet->num +1) * sizeof(unsigned int)
@@ -594,7 +1300,7 @@ errCode arrangeTextures(
 
 						for(idxGlyph= dynarrFontIdxs[curFont]; idxGlyph < refFnt->num; ++idxGlyph){
 							curTex = arrTexs[ refFnt->dynarrTexIDs[idxGlyph] ];
-							idxFit = fitNFillSquare(&tmpHoles, curTex->w, curTex->h, maxSquare, maxSquare);
+							idxFit = fitNFillSquareTurned(&tmpHoles, curTex->w, curTex->h, maxSquare, maxSquare, allowRotate, NULL);
 							if(idxFit < 0)
 								break;
 						}
@@ -612,7 +1318,7 @@ errCode arrangeTextures(
 									dynarrFontIdxs[curFont]
 								]
 							];
-							idxFit = fitNFillSquare(&holes, curTex->w, curTex->h, maxSquare, maxSquare);
+							idxFit = fitNFillSquareTurned(&holes, curTex->w, curTex->h, maxSquare, maxSquare, allowRotate, &turned);
 							if(idxFit < 0){
 								ERROR_LOG("Unable to fit font, somehow?");
 								goto arrangeTextures_fail;
@@ -621,6 +1327,7 @@ errCode arrangeTextures(
 							refSqr = &(holes.dynarrSquares[idxFit]);
 							curTex->x = refSqr->x;
 							curTex->y = refSqr->y;
+							curTex->rotated = turned;
 							++dynarrFontIdxs[curFont];
 						}
 
@@ -633,7 +1340,7 @@ errCode arrangeTextures(
 
 							unsigned int s;
 							for(s=i; s < dynarrFontIdxs[curFont]; ++s)
-								refFnt->dynarrSheetIDs[s] = (unsigned int)(pOutSheets->num -1);
+								refFnt->dynarrSheetIDs[s] = idxSheet;
 
 							curSheet->num += dynarrFontIdxs[curFont] -i;
 							curSheet->dynarrTexIDs = realloc_chk(
@@ -687,45 +1394,255 @@ errCode arrangeTextures(
 					}
 				}
 
-				if(dynarrStillIdxs != NULL && endOfStills == TRUE){
-					for(curStill=0; curStill < pStills->num; ++curStill){
-						if(dynarrStillIdxs[curStill] != (unsigned int)(-1))
-							break;
-					}
+				if(dynarrStillIdxs != NULL && endOfStills == TRUE){
+					for(curStill=0; curStill < pStills->num; ++curStill){
+						if(dynarrStillIdxs[curStill] != (unsigned int)(-1))
+							break;
+					}
+
+					if(curStill == pStills->num){
+						SAFE_DELETE(dynarrStillIdxs);
+					}else{
+						makeSheet = TRUE;
+					}
+				}
+			}
+			
+			/** keep the sheet up to date. */
+			curSheet->w = holes.boundryW;
+			curSheet->h = holes.boundryH;
+		}
+
+		cleanupListSquares(&holes);
+		++idxSheet;
+		
+	}while(makeSheet==TRUE);
+
+	if(seed.refPrev != NULL){
+		finishLayoutSeed(&seed, pSeqs, pStills, pFonts, pOutSheets);
+		cleanupLayoutSeed(&seed);
+	}
+	
+	if(dynarrStillIdxs != NULL || dynarrSeqIdxs != NULL){
+		ERROR_LOG("Didn't cleanup memory");
+		return ERROR;
+	}
+	
+	return NOPROB;
+	
+arrangeTextures_fail:
+	
+	cleanupLayoutSeed(&seed);
+	SAFE_DELETE(dynarrSeqIdxs);
+	SAFE_DELETE(dynarrStillIdxs);
+	SAFE_DELETE(dynarrPrevFrame);
+	return ERROR;
+}
+
+
+
+void growSheetsToPow2(sSheetList *pSheets){
+	unsigned int i;
+	sSheet *refSheet;
+
+	for(i=0; i < pSheets->num; ++i){
+		refSheet = pSheets->dynarrSheets[i];
+		if(refSheet->w > 1)	/** closestPow2 always goes higher, even from a power of 2. */
+			refSheet->w = closestPow2(refSheet->w -1);
+		if(refSheet->h > 1)
+			refSheet->h = closestPow2(refSheet->h -1);
+	}
+}
+
+/*!\brief	A name that goes in the name hash. */
+typedef struct defHashKey{
+	const char *name;
+	unsigned int entry;
+	unsigned int bucket;
+	unsigned int sizeBucket;
+} sHashKey;
+
+static const unsigned int MAX_HASH_SEED = 1 << 24;	/*!< Buckets are placed biggest first, so one never needs anywhere near this many tries. */
+
+unsigned int hashName(unsigned int seed, const char *strName){
+	unsigned int h = 2166136261u ^ seed;
+
+	for(; *strName != '\0'; ++strName){
+		h ^= (unsigned char)*strName;
+		h *= 16777619u;
+	}
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+
+	return h & 0x7FFFFFFFu;
+}
+
+int findNameHash(const sNameHash *refHash, const char *strName){
+	int seed;
+
+	if(refHash == NULL || strName == NULL || refHash->numSlots == 0)
+		return -1;
+
+	seed = refHash->dynarrSeeds[ hashName(0, strName) % refHash->numSeeds ];
+	if(seed < 0)
+		return (int)refHash->dynarrSlots[ -seed -1 ];
+
+	return (int)refHash->dynarrSlots[ hashName((unsigned int)seed, strName) % refHash->numSlots ];
+}
+
+static int compareHashKeyNames(const void *a, const void *b){
+	const sHashKey *keyA = (const sHashKey*)a;
+	const sHashKey *keyB = (const sHashKey*)b;
+	int diff = strcmp(keyA->name, keyB->name);
+
+	if(diff != 0)
+		return diff;
+
+	return (keyA->entry < keyB->entry) ? -1 : (keyA->entry > keyB->entry);
+}
+
+/*!\brief	Biggest bucket first, keeping each bucket's keys together. */
+static int compareHashKeyBuckets(const void *a, const void *b){
+	const sHashKey *keyA = (const sHashKey*)a;
+	const sHashKey *keyB = (const sHashKey*)b;
+
+	if(keyA->sizeBucket != keyB->sizeBucket)
+		return (keyA->sizeBucket > keyB->sizeBucket) ? -1 : 1;
+
+	return (keyA->bucket < keyB->bucket) ? -1 : (keyA->bucket > keyB->bucket);
+}
+
+/*!\brief	Builds the name hash using hash and displace. The keys are put in buckets, and starting with the biggest
+ *!		bucket, seeds are tried until all its keys land on free slots. Buckets of one key are put straight into
+ *!		whatever slots are left.
+ */
+static errCode genNameHash(sManifest *man){
+	sHashKey *dynarrKeys;
+	unsigned int *dynarrBucketSizes = NULL;
+	unsigned int *dynarrTrySlots = NULL;
+	bool *dynarrTaken = NULL;
+	unsigned int numKeys = 0, numUnique = 0, numStart = 0, i, k, seed, freeSlot;
+	unsigned int numAll = man->refStills->num + man->refSeqs->num + man->refFonts->num;
+	errCode result = NOPROB;
+
+	memset(&man->nameHash, 0, sizeof(sNameHash));
+	if(numAll == 0)
+		return NOPROB;
+
+	dynarrKeys = calloc_chk(numAll, sizeof(sHashKey));
+
+	for(i=0; i < man->refStills->num; ++i){
+		if(man->dynarrStrStillNames[i] == NULL)
+			continue;
+		dynarrKeys[numKeys].name = man->dynarrStrStillNames[i];
+		dynarrKeys[numKeys++].entry = i;
+	}
+
+	for(i=0; i < man->refSeqs->num; ++i){
+		if(man->dynarrStrSeqNames[i] == NULL)
+			continue;
+		dynarrKeys[numKeys].name = man->dynarrStrSeqNames[i];
+		dynarrKeys[numKeys++].entry = man->refStills->num + i;
+	}
+
+	for(i=0; i < man->refFonts->num; ++i){
+		if(man->dynarrStrFontNames[i] == NULL)
+			continue;
+		dynarrKeys[numKeys].name = man->dynarrStrFontNames[i];
+		dynarrKeys[numKeys++].entry = man->refStills->num + man->refSeqs->num + i;
+	}
+
+	/** The same name twice would never hash apart, so only the first one can be found by name. */
+	qsort(dynarrKeys, numKeys, sizeof(sHashKey), compareHashKeyNames);
+	for(i=0; i < numKeys; ++i){
+		if(numUnique > 0 && strcmp(dynarrKeys[numUnique -1].name, dynarrKeys[i].name) == 0){
+			WARN("More than one thing is called %s, only the first can be looked up by name", dynarrKeys[i].name);
+			continue;
+		}
+		dynarrKeys[numUnique++] = dynarrKeys[i];
+	}
+
+	if(numUnique == 0)
+		goto genNameHash_end;
+
+	man->nameHash.numSeeds = numUnique;
+	man->nameHash.numSlots = numUnique;
+	man->nameHash.dynarrSeeds = calloc_chk(numUnique, sizeof(int));
+	man->nameHash.dynarrSlots = calloc_chk(numUnique, sizeof(unsigned int));
+	dynarrBucketSizes = calloc_chk(numUnique, sizeof(unsigned int));
+	dynarrTrySlots = calloc_chk(numUnique, sizeof(unsigned int));
+	dynarrTaken = calloc_chk(numUnique, sizeof(bool));
+
+	for(i=0; i < numUnique; ++i){
+		dynarrKeys[i].bucket = hashName(0, dynarrKeys[i].name) % numUnique;
+		++dynarrBucketSizes[ dynarrKeys[i].bucket ];
+	}
+
+	for(i=0; i < numUnique; ++i)
+		dynarrKeys[i].sizeBucket = dynarrBucketSizes[ dynarrKeys[i].bucket ];
 
-					if(curStill == pStills->num){
-						SAFE_DELETE(dynarrStillIdxs);
-					}else{
-						makeSheet = TRUE;
-					}
-				}
+	qsort(dynarrKeys, numUnique, sizeof(sHashKey), compareHashKeyBuckets);
+
+	for(numStart=0; numStart < numUnique && dynarrKeys[numStart].sizeBucket > 1; numStart += dynarrKeys[numStart].sizeBucket){
+		const sHashKey *refBucket = &dynarrKeys[numStart];
+
+		for(seed=1; seed < MAX_HASH_SEED; ++seed){
+			for(k=0; k < refBucket->sizeBucket; ++k){
+				unsigned int j;
+
+				dynarrTrySlots[k] = hashName(seed, refBucket[k].name) % numUnique;
+				if(dynarrTaken[ dynarrTrySlots[k] ])
+					break;
+
+				for(j=0; j < k && dynarrTrySlots[j] != dynarrTrySlots[k]; ++j)
+					;
+				if(j < k)
+					break;
 			}
-			
-			/** keep the sheet up to date. */
-			curSheet->w = holes.boundryW;
-			curSheet->h = holes.boundryH;
+
+			if(k == refBucket->sizeBucket)
+				break;
 		}
 
-		cleanupListSquares(&holes);
-		
-	}while(makeSheet==TRUE);
-	
-	if(dynarrStillIdxs != NULL || dynarrSeqIdxs != NULL){
-		ERROR_LOG("Didn't cleanup memory");
-		return ERROR;
+		if(seed == MAX_HASH_SEED){
+			WARN("Unable to make the name lookup table");
+			result = PROBLEM;
+			goto genNameHash_end;
+		}
+
+		man->nameHash.dynarrSeeds[ refBucket->bucket ] = (int)seed;
+		for(k=0; k < refBucket->sizeBucket; ++k){
+			dynarrTaken[ dynarrTrySlots[k] ] = TRUE;
+			man->nameHash.dynarrSlots[ dynarrTrySlots[k] ] = refBucket[k].entry;
+		}
+	}
+
+	for(freeSlot=0; numStart < numUnique; ++numStart){
+		while(dynarrTaken[freeSlot])
+			++freeSlot;
+
+		dynarrTaken[freeSlot] = TRUE;
+		man->nameHash.dynarrSeeds[ dynarrKeys[numStart].bucket ] = -(int)freeSlot -1;
+		man->nameHash.dynarrSlots[freeSlot] = dynarrKeys[numStart].entry;
 	}
-	
-	return NOPROB;
-	
-arrangeTextures_fail:
-	
-	SAFE_DELETE(dynarrSeqIdxs);
-	SAFE_DELETE(dynarrStillIdxs);
-	SAFE_DELETE(dynarrPrevFrame);
-	return ERROR;
-}
 
+genNameHash_end:
+	if(result != NOPROB){
+		SAFE_DELETE(man->nameHash.dynarrSeeds);
+		SAFE_DELETE(man->nameHash.dynarrSlots);
+		memset(&man->nameHash, 0, sizeof(sNameHash));
+	}
 
+	SAFE_DELETE(dynarrTaken);
+	SAFE_DELETE(dynarrTrySlots);
+	SAFE_DELETE(dynarrBucketSizes);
+	SAFE_DELETE(dynarrKeys);
+	return result;
+}
 
 errCode genMan(
 	const char *strManName,
@@ -793,9 +1710,9 @@ errCode genMan(
 		memset(outMan->dynarrStrFontNames, 0, refFonts->num * sizeof(char*));
 
 		for(i=0; i < refFonts->num; ++i){
-			refTex = refarrTexs[ refFonts->dynarrFonts[i]->dynarrTexIDs[0] ];
 			if(refFonts->dynarrFonts[i]->num == 0)
 				continue;
+			refTex = refarrTexs[ refFonts->dynarrFonts[i]->dynarrTexIDs[0] ];
 
 			refCCodeDelim = strrchr(refTex->name, (unsigned int)'_');
 			if(refCCodeDelim == NULL)
@@ -814,125 +1731,489 @@ errCode genMan(
 		}
 	}
 
-	return NOPROB;
+	return genNameHash(outMan);
 }
 
 
-errCode writeSheets(
-	const char *strPath, 
-	const char *strManName,
-	sTex **refArrTex,
-	sSheetList *pSheets
-){
-	char buff[128];
-	size_t s, r, i;
-	FILE *handFile;
-	png_byte **dynarrImg;
-	png_structp pngptrWriteData;
-	png_infop pngptrWriteInfo;
-	png_size_t sizeRow;
-	unsigned int w, h;
-	
-	for(s=0; s < pSheets->num; ++s){
-		handFile = NULL;
-		dynarrImg = NULL;
-		pngptrWriteData = NULL;
-		pngptrWriteInfo = NULL;
-		
-		w = pSheets->dynarrSheets[s]->w;
-		h = pSheets->dynarrSheets[s]->h;
-		
-		if(w==0 || h==0){
-			WARN("bad sheet dimensions.");
-			continue;
-		}
-		
-		snprintf(buff, 128, "%s%s%i.png", 
-			(strPath!=NULL) ? strPath : "", 
-			strManName, 
-			(int)s
-		);
-		handFile = fopen(buff, "wb");
-		
-		if(handFile == NULL){
-			WARN("Unable to write to file %s", buff);
-			goto fail_loop_writeSheets;
-		}
-				
-		pngptrWriteData = png_create_write_struct(
-			PNG_LIBPNG_VER_STRING, NULL, NULL, myPNGWarnFoo
-		);
-		
-		if(pngptrWriteData == NULL){
-			WARN("Can't make png write data");
-			goto fail_loop_writeSheets;
-		}
-		
-		pngptrWriteInfo = png_create_info_struct(pngptrWriteData);
+/*!\brief	What we wrote for a sheet last time. */
+typedef struct defSheetDigest{
+	char *name;	/*!< Cleanup. */
+	unsigned long long digest;
+	long size;	/*!< Size of the PNG file we wrote. */
+} sSheetDigest;
+
+typedef struct defDigestList{
+	sSheetDigest *dynarrDigests;
+	unsigned int num;
+} sDigestList;
+
+static const char *DIGEST_HEAD_VERSION = "digest_version=";
+static const char *DIGEST_EXTENSION = ".digest";
+static const unsigned int DIGEST_VERSION = 2;	/*!< Version 1 hashed the pixels a byte at a time, so its digests can't be compared. */
+
+static void addSheetDigest(sDigestList *list, const char *strName, unsigned long long digest, long size){
+	sSheetDigest *ref;
+
+	++list->num;
+	list->dynarrDigests = realloc_chk(list->dynarrDigests, list->num * sizeof(sSheetDigest));
+	ref = &list->dynarrDigests[list->num -1];
+	ref->name = NULL;
+	copyString(&ref->name, strName);
+	ref->digest = digest;
+	ref->size = size;
+}
 
-		if(pngptrWriteInfo == NULL){
-			WARN("Can't make png write info");
-			goto fail_loop_writeSheets;
-		}
-		
-		if(setjmp (png_jmpbuf (pngptrWriteData))){
-			goto fail_loop_writeSheets;
-		}
-		
-		png_set_IHDR(
-			pngptrWriteData, pngptrWriteInfo,
-			w, h,
-			DEFAULT_BITDEPTH, DEFAULT_COLOURTYPE, DEFAULT_INTERLACE,
-			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT
+static const sSheetDigest* findSheetDigest(const sDigestList *list, const char *strName){
+	unsigned int i;
+	for(i=0; i < list->num; ++i){
+		if(strcmp(list->dynarrDigests[i].name, strName) == 0)
+			return &list->dynarrDigests[i];
+	}
+	return NULL;
+}
+
+static void cleanupDigestList(sDigestList *list){
+	unsigned int i;
+	for(i=0; i < list->num; ++i)
+		SAFE_DELETE(list->dynarrDigests[i].name);
+
+	SAFE_DELETE(list->dynarrDigests);
+	memset(list, 0, sizeof(sDigestList));
+}
+
+/*!\brief	Loads the digests from the last run. Leaves the list empty if there aren't any. */
+static void readDigests(const char *strFile, sDigestList *outList){
+	char buff[256] = "";
+	char strName[256];
+	unsigned long long digest;
+	size_t lenHead;
+	long size;
+	FILE *handFile = fopen(strFile, "r");
+
+	if(handFile == NULL)
+		return;
+
+	snprintf(strName, sizeof(strName), "%s%u\n", DIGEST_HEAD_VERSION, DIGEST_VERSION);
+	if(fgets(buff, sizeof(buff), handFile) == NULL || strcmp(buff, strName) != 0){
+		lenHead = strlen(DIGEST_HEAD_VERSION);
+		if(strncmp(buff, DIGEST_HEAD_VERSION, lenHead) == 0 && strtoul(&buff[lenHead], NULL, 10) < DIGEST_VERSION)	/** Every sheet is checked again, then it's rewritten. */
+			XTRA_LOG("Digest file %s is from an older version, ignoring it.", strFile);
+		else
+			WARN("Digest file %s is an unknown version, ignoring it.", strFile);
+		fclose(handFile);
+		return;
+	}
+
+	while(fgets(buff, sizeof(buff), handFile) != NULL){
+		if(sscanf(buff, "%255[^,],%llx,%ld", strName, &digest, &size) == 3)
+			addSheetDigest(outList, strName, digest, size);
+	}
+
+	fclose(handFile);
+}
+
+static void writeDigests(const char *strFile, const sDigestList *list){
+	unsigned int i;
+	FILE *handFile = fopen(strFile, "w");
+
+	if(handFile == NULL){
+		WARN("Unable to write digest file %s", strFile);
+		return;
+	}
+
+	fprintf(handFile, "%s%u\n", DIGEST_HEAD_VERSION, DIGEST_VERSION);
+	for(i=0; i < list->num; ++i){
+		fprintf(handFile, "%s,%016llx,%ld\n",
+			list->dynarrDigests[i].name,
+			list->dynarrDigests[i].digest,
+			list->dynarrDigests[i].size
 		);
+	}
 
-		png_set_gamma(pngptrWriteData, 2.2, 1.0/2.2);
-		
-		sizeRow = png_get_rowbytes( pngptrWriteData, pngptrWriteInfo );
-		dynarrImg = calloc_chk( (h +1), sizeof(png_byte*) );
-		dynarrImg[h] = NULL;
-		
-		for(r=0; r < h; ++r){
-			dynarrImg[r] = png_malloc(pngptrWriteData, sizeRow);
-			memset(dynarrImg[r], 0, sizeRow);
+	fclose(handFile);
+}
+
+/*!\brief	Everything needed to write a single sheet, so the sheets can be written at the same time. */
+typedef struct defSheetJob{
+	const char *strPath;
+	const char *strManName;
+	sTex **refArrTex;
+	const sSheet *refSheet;
+	unsigned int idxSheet;
+	const sDigestList *refPrevDigests;
+	eCramGlyphFormat glyphFormat;
+	sCramFile *outMem;	/*!< The PNG goes here instead of to a file, if not null. */
+	char *dynarrEncoded;	/*!< Where the memory stream puts the PNG, kept out of the stack because of setjmp. */
+	size_t sizeEncoded;
+	sLogContext logContext;	/*!< Whoever wanted the sheet written. */
+	sSheetDigest result;	/*!< The name is only set if there's a digest to keep. Cleanup. */
+} sSheetJob;
+
+/*!\brief	Sheets are RGBA, unless there's nothing but glyphs on them and we've been asked for something smaller. */
+static int getSheetColourType(sTex **refArrTex, const sSheet *refSheet, eCramGlyphFormat glyphFormat){
+	unsigned int i;
+
+	if(glyphFormat == eCramGlyphRGBA || refSheet->num == 0)
+		return DEFAULT_COLOURTYPE;
+
+	for(i=0; i < refSheet->num; ++i){
+		if(refArrTex[ refSheet->dynarrTexIDs[i] ]->colorType != PNG_COLOR_TYPE_GRAY)
+			return DEFAULT_COLOURTYPE;
+	}
+
+	return (glyphFormat == eCramGlyphGrayAlpha) ? PNG_COLOR_TYPE_GRAY_ALPHA : PNG_COLOR_TYPE_GRAY;
+}
+
+const char* getSheetExtension(sTex **refArrTex, const sSheet *refSheet, eCramGlyphFormat glyphFormat){
+	if(glyphFormat == eCramGlyphR8 && getSheetColourType(refArrTex, refSheet, glyphFormat) == PNG_COLOR_TYPE_GRAY)
+		return ".r8";
+
+	return ".png";
+}
+
+/*!\brief	Puts the path to one of the files written for the manifest into the buffer, the sheet's if it's numbered.
+ *!\return	PROBLEM if it doesn't fit, rather than leaving a path that's been cut short.
+ */
+static errCode makeOutFilePath(char *outBuff, size_t lenBuff, const char *strPath, const char *strManName, int idxSheet, const char *strExt){
+	int lenOut;
+
+	if(idxSheet >= 0)
+		lenOut = snprintf(outBuff, lenBuff, "%s%s%i%s", (strPath!=NULL) ? strPath : "", strManName, idxSheet, strExt);
+	else
+		lenOut = snprintf(outBuff, lenBuff, "%s%s%s", (strPath!=NULL) ? strPath : "", strManName, strExt);
+
+	if(lenOut < 0 || (size_t)lenOut >= lenBuff){
+		WARN("The path for %s%s is too long", strManName, strExt);
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
+
+/*!\brief	Composes a sheet, and writes it if the pixels are different to what's already there. */
+static void writeSheet(sSheetJob *job){
+	char buff[OUT_PATH_ROOM + OUT_SUFFIX_ROOM];
+	size_t r, i;
+	FILE * volatile handFile = NULL;	/** Set after setjmp. */
+	png_byte ** volatile dynarrImg = NULL;	/** So is this. */
+	png_structp pngptrWriteData = NULL;
+	png_infop pngptrWriteInfo = NULL;
+	png_size_t sizeRow;
+	unsigned long long digest;
+	volatile long sizeFile = -1;	/** Read after setjmp. */
+	sSheetDigest const * volatile refPrevDigest = NULL;	/** So is this. */
+	const char *refSheetName;	/*!< Digests are keyed on the name without the path, so the output can be moved. */
+	const size_t lenPath = (job->strPath!=NULL && job->outMem == NULL) ? strlen(job->strPath) : 0;
+	const unsigned int w = job->refSheet->w;
+	const unsigned int h = job->refSheet->h;
+	const int colourType = getSheetColourType(job->refArrTex, job->refSheet, job->glyphFormat);
+	const bool raw = (colourType == PNG_COLOR_TYPE_GRAY && job->glyphFormat == eCramGlyphR8);
+
+	if(w==0 || h==0){
+		WARN("bad sheet dimensions.");
+		return;
+	}
+
+	if(makeOutFilePath(
+		buff, sizeof(buff),
+		(lenPath > 0) ? job->strPath : NULL,
+		job->strManName,
+		(int)job->idxSheet,
+		getSheetExtension(job->refArrTex, job->refSheet, job->glyphFormat)
+	) != NOPROB)
+		return;
+
+	refSheetName = &buff[ lenPath < strlen(buff) ? lenPath : 0 ];
+
+	if(job->outMem == NULL){
+		refPrevDigest = findSheetDigest(job->refPrevDigests, refSheetName);
+		sizeFile = getFileSize(buff);
+
+		if(job->refSheet->changed == FALSE && refPrevDigest != NULL && sizeFile == refPrevDigest->size){
+			XTRA_LOG("Sheet %s hasn't changed", buff);
+			copyString(&job->result.name, refSheetName);
+			job->result.digest = refPrevDigest->digest;
+			job->result.size = refPrevDigest->size;
+			return;
 		}
-		
-		for(i=0; i < pSheets->dynarrSheets[s]->num; ++i){
-			if(readTexToSheet(
-				refArrTex[
-					pSheets->dynarrSheets[s]->dynarrTexIDs[i]
-				], 
-				dynarrImg, 
-				w, 
-				h,
-				sizeRow
-			)==PROBLEM)
-				goto fail_loop_writeSheets;
+	}
+
+	pngptrWriteData = png_create_write_struct(
+		PNG_LIBPNG_VER_STRING, NULL, NULL, myPNGWarnFoo
+	);
+	
+	if(pngptrWriteData == NULL){
+		WARN("Can't make png write data");
+		goto writeSheet_end;
+	}
+	
+	pngptrWriteInfo = png_create_info_struct(pngptrWriteData);
+
+	if(pngptrWriteInfo == NULL){
+		WARN("Can't make png write info");
+		goto writeSheet_end;
+	}
+	
+	if(setjmp (png_jmpbuf (pngptrWriteData))){
+		goto writeSheet_end;
+	}
+	
+	png_set_IHDR(
+		pngptrWriteData, pngptrWriteInfo,
+		w, h,
+		DEFAULT_BITDEPTH, colourType, DEFAULT_INTERLACE,
+		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT
+	);
+
+	png_set_gamma(pngptrWriteData, 2.2, 1.0/2.2);
+	
+	sizeRow = png_get_rowbytes( pngptrWriteData, pngptrWriteInfo );
+	dynarrImg = calloc_chk( (h +1), sizeof(png_byte*) );
+	dynarrImg[h] = NULL;
+	
+	for(r=0; r < h; ++r){
+		dynarrImg[r] = png_malloc(pngptrWriteData, sizeRow);
+		memset(dynarrImg[r], 0, sizeRow);
+	}
+	
+	for(i=0; i < job->refSheet->num; ++i){
+		if(readTexToSheet(
+			job->refArrTex[
+				job->refSheet->dynarrTexIDs[i]
+			], 
+			dynarrImg, 
+			w, 
+			h,
+			sizeRow
+		)==PROBLEM)
+			goto writeSheet_end;
+	}
+
+	if(job->outMem == NULL){
+		digest = HASH64_START;
+		digest = hashMem64(&w, sizeof(w), digest);
+		digest = hashMem64(&h, sizeof(h), digest);
+		for(r=0; r < h; ++r)
+			digest = hashWords64(dynarrImg[r], sizeRow, digest);
+
+		if(refPrevDigest != NULL && refPrevDigest->digest == digest && sizeFile == refPrevDigest->size){
+			XTRA_LOG("Sheet %s has the same pixels as last time", buff);
+			copyString(&job->result.name, refSheetName);
+			job->result.digest = digest;
+			job->result.size = sizeFile;
+			goto writeSheet_end;
 		}
-		
-		XTRA_LOG("About to write %s\n", buff);
+
+		handFile = fopen(buff, "wb");
+	}else{
+		digest = 0;
+		handFile = open_memstream(&job->dynarrEncoded, &job->sizeEncoded);
+	}
+	
+	if(handFile == NULL){
+		WARN("Unable to write to file %s", buff);
+		goto writeSheet_end;
+	}
+	
+	XTRA_LOG("About to write %s\n", buff);
+	if(raw){
+		for(r=0; r < h; ++r)
+			fwrite(dynarrImg[r], 1, sizeRow, handFile);
+	}else{
 		png_init_io(pngptrWriteData, handFile);
 		png_set_rows(pngptrWriteData, pngptrWriteInfo, dynarrImg);
 		png_write_info(pngptrWriteData, pngptrWriteInfo);
 		png_write_image(pngptrWriteData, dynarrImg);
 		png_write_end(pngptrWriteData, pngptrWriteInfo);
-		
-	fail_loop_writeSheets:
-		if(pngptrWriteInfo != NULL && pngptrWriteData != NULL){
-			if(dynarrImg != NULL)
-				cleanupPNGImg(pngptrWriteData, &dynarrImg);
-			
-			png_destroy_write_struct(&pngptrWriteData, &pngptrWriteInfo);
+	}
+
+	fclose(handFile);
+	handFile = NULL;
+
+	if(job->outMem != NULL){
+		copyString(&job->outMem->strName, refSheetName);
+		job->outMem->dynarrData = (unsigned char*)job->dynarrEncoded;
+		job->outMem->size = job->sizeEncoded;
+		job->dynarrEncoded = NULL;
+	}else{
+		copyString(&job->result.name, refSheetName);
+		job->result.digest = digest;
+		job->result.size = getFileSize(buff);
+	}
+	
+writeSheet_end:
+	if(pngptrWriteInfo != NULL && pngptrWriteData != NULL){
+		if(dynarrImg != NULL){
+			png_byte **refImg = dynarrImg;	/** As it can't be passed on volatile. */
+			cleanupPNGImg(pngptrWriteData, &refImg);
 		}
 		
-		if(handFile != NULL)
-			fclose(handFile);
+		png_destroy_write_struct(&pngptrWriteData, &pngptrWriteInfo);
+	}
+	
+	if(handFile != NULL)
+		fclose(handFile);
+
+	SAFE_DELETE(job->dynarrEncoded);	/** Only set if the encode failed part way. */
+}
+
+static void writeSheetTask(void *data){
+	sSheetJob *job = (sSheetJob*)data;
+	sLogContext prevContext;
+
+	getLogContext(&prevContext);
+	setLogContext(&job->logContext);
+	writeSheet(job);
+	setLogContext(&prevContext);
+}
+
+/*!\brief	Writes every sheet, at the same time if there's a pool. The jobs only need the fields that differ from sheet to sheet filled. */
+static void runSheetJobs(
+	const char *strPath, 
+	const char *strManName,
+	sTex **refArrTex,
+	const sSheetList *pSheets,
+	const sDigestList *refPrevDigests,
+	eCramGlyphFormat glyphFormat,
+	sSheetJob *arrJobs,
+	sThreadPool *pool
+){
+	unsigned int s;
+	sTaskGroup group;	memset(&group, 0, sizeof(sTaskGroup));
+
+	for(s=0; s < pSheets->num; ++s){
+		arrJobs[s].strPath = strPath;
+		arrJobs[s].strManName = strManName;
+		arrJobs[s].refArrTex = refArrTex;
+		arrJobs[s].refSheet = pSheets->dynarrSheets[s];
+		arrJobs[s].idxSheet = s;
+		arrJobs[s].refPrevDigests = refPrevDigests;
+		arrJobs[s].glyphFormat = glyphFormat;
+		getLogContext(&arrJobs[s].logContext);
+
+		if(pool != NULL)
+			submitTask(pool, &group, writeSheetTask, &arrJobs[s]);
+		else
+			writeSheet(&arrJobs[s]);
+	}
+
+	if(pool != NULL)
+		waitTaskGroup(pool, &group);
+}
+
+/*!\brief	Removes what's left of sheets from an earlier run, once a repack has made fewer of them. That's every numbered
+ *			sheet past the last one, as either a PNG or a '.r8', and the other of the two for the sheets that are still
+ *			written, in case a sheet has changed from one to the other. Their digests go when the digest file is rewritten.
+ */
+static void removeStaleSheets(const char *strPath, const char *strManName, sTex **refArrTex, const sSheetList *pSheets, eCramGlyphFormat glyphFormat){
+	static const char *arrExts[] = { ".png", ".r8" };
+	char buff[OUT_PATH_ROOM + OUT_SUFFIX_ROOM];
+	unsigned int s, e;
+	bool found;
+
+	for(s=0; ; ++s){
+		found = FALSE;
+		for(e=0; e < sizeof(arrExts) / sizeof(arrExts[0]); ++e){
+			if(s < pSheets->num && strcmp(arrExts[e], getSheetExtension(refArrTex, pSheets->dynarrSheets[s], glyphFormat)) == 0)
+				continue;
+
+			if(makeOutFilePath(buff, sizeof(buff), strPath, strManName, (int)s, arrExts[e]) != NOPROB)
+				return;
+
+			if(remove(buff) == 0){
+				XTRA_LOG("Removed old sheet %s", buff);
+				found = TRUE;
+			}
+		}
+
+		if(s >= pSheets->num && found == FALSE)	/** Sheets were always numbered from zero, so there's none past a gap. */
+			break;
+	}
+}
+
+errCode writeSheets(
+	const char *strPath, 
+	const char *strManName,
+	sTex **refArrTex,
+	sSheetList *pSheets,
+	eCramGlyphFormat glyphFormat,
+	sThreadPool *pool
+){
+	char buff[OUT_PATH_ROOM + OUT_SUFFIX_ROOM];
+	unsigned int s;
+	sDigestList prevDigests;	memset(&prevDigests, 0, sizeof(sDigestList));
+	sDigestList newDigests;		memset(&newDigests, 0, sizeof(sDigestList));
+	sSheetJob *dynarrJobs;
+
+	if(makeOutFilePath(buff, sizeof(buff), strPath, strManName, -1, DIGEST_EXTENSION) != NOPROB)
+		return PROBLEM;
+
+	readDigests(buff, &prevDigests);
+
+	dynarrJobs = calloc_chk(pSheets->num +1, sizeof(sSheetJob));
+	runSheetJobs(strPath, strManName, refArrTex, pSheets, &prevDigests, glyphFormat, dynarrJobs, pool);
+
+	for(s=0; s < pSheets->num; ++s){	/** Keep them in sheet order. */
+		if(dynarrJobs[s].result.name == NULL)
+			continue;
+
+		addSheetDigest(&newDigests, dynarrJobs[s].result.name, dynarrJobs[s].result.digest, dynarrJobs[s].result.size);
+		SAFE_DELETE(dynarrJobs[s].result.name);
 	}
 
+	SAFE_DELETE(dynarrJobs);
+
+	removeStaleSheets(strPath, strManName, refArrTex, pSheets, glyphFormat);
+
+	writeDigests(buff, &newDigests);	/** Still the digest path, from the start. */
+
+	cleanupDigestList(&prevDigests);
+	cleanupDigestList(&newDigests);
 
 	return NOPROB;
 }
 
+errCode encodeSheets(const char *strManName, sTex **refArrTex, const sSheetList *pSheets, eCramGlyphFormat glyphFormat, sCramFile *outFiles, sThreadPool *pool){
+	unsigned int s;
+	errCode result = NOPROB;
+	sSheetJob *dynarrJobs;
+
+	if(strManName == NULL || refArrTex == NULL || pSheets == NULL || outFiles == NULL)
+		return ERROR;
+
+	dynarrJobs = calloc_chk(pSheets->num +1, sizeof(sSheetJob));
+	for(s=0; s < pSheets->num; ++s){
+		memset(&outFiles[s], 0, sizeof(sCramFile));
+		dynarrJobs[s].outMem = &outFiles[s];
+	}
+
+	runSheetJobs(NULL, strManName, refArrTex, pSheets, NULL, glyphFormat, dynarrJobs, pool);
+
+	for(s=0; s < pSheets->num; ++s){
+		if(outFiles[s].dynarrData == NULL)
+			result = PROBLEM;
+	}
+
+	SAFE_DELETE(dynarrJobs);
+	return result;
+}
+
+unsigned int hashTex(const sTex *refTex){
+	unsigned int hash = HASH_START;
+	unsigned int row;
+
+	hash = hashMem(&refTex->w, sizeof(refTex->w), hash);
+	hash = hashMem(&refTex->h, sizeof(refTex->h), hash);
+
+	if(refTex->dynarrRows == NULL)
+		return hash;
+
+	for(row=0; row < refTex->h; ++row)
+		hash = hashMem(refTex->dynarrRows[row], refTex->w * getTexBytesPP(refTex), hash);
+
+	return hash;
+}
+
 void appendTexArr(sTex ***pAppendHere, sTex **pFrom){
 	if(pAppendHere	== NULL)
 		return;
@@ -957,7 +2238,30 @@ void appendTexArr(sTex ***pAppendHere, sTex **pFrom){
 }
 
 void cleanupTex(sTex *pTex){
+	unsigned int r;
+
 	SAFE_DELETE(pTex->name);
+
+	if(pTex->sharedRows == TRUE){	/** Rows into a block of pixels, which might not be ours. */
+		SAFE_DELETE(pTex->dynarrRows);
+		SAFE_DELETE(pTex->dynarrPixels);
+		pTex->sharedRows = FALSE;
+	}
+
+	if(pTex->refMapped != NULL){
+		if(--pTex->refMapped->numTexs == 0){
+			munmap(pTex->refMapped->addr, pTex->refMapped->size);
+			free(pTex->refMapped);
+		}
+		pTex->refMapped = NULL;
+	}
+
+	if(pTex->pngptrData == NULL && pTex->dynarrRows != NULL){	/** Rows we made ourselves, like the glyphs. */
+		for(r=0; r < pTex->h; ++r)
+			SAFE_DELETE(pTex->dynarrRows[r]);
+		SAFE_DELETE(pTex->dynarrRows);
+	}
+
 	cleanupPNGImg(pTex->pngptrData, &(pTex->dynarrRows) );
 	png_destroy_read_struct(
 		&(pTex->pngptrData),
@@ -966,6 +2270,23 @@ void cleanupTex(sTex *pTex){
 	);
 }
 
+void cleanupTexCache(sTexCache *cache){
+	unsigned int i;
+
+	if(cache == NULL)
+		return;
+
+	for(i=0; i < cache->num; ++i){
+		if(cache->dynarrEntries[i].tex != NULL)
+			cleanupTex(cache->dynarrEntries[i].tex);
+		SAFE_DELETE(cache->dynarrEntries[i].tex);
+		SAFE_DELETE(cache->dynarrEntries[i].name);
+	}
+
+	SAFE_DELETE(cache->dynarrEntries);
+	cache->num = 0;
+}
+
 void cleanupTextures(sTex ***textures){
 	if(textures == NULL || (*textures) == NULL)
 		return;
@@ -1006,10 +2327,11 @@ void cleanupSheetList(sSheetList *list){
 	for(i=0; i < list->num; ++i){
 		SAFE_DELETE(list->dynarrSheets[i]->name);
 		SAFE_DELETE(list->dynarrSheets[i]->dynarrTexIDs);
+		SAFE_DELETE(list->dynarrSheets[i]);
 	}
 
 	SAFE_DELETE(list->dynarrSheets);
-	memset(list, 0, sizeof(list));
+	memset(list, 0, sizeof(sSheetList));
 }
 
 void cleanupFontList(sFontList *list){
@@ -1024,9 +2346,13 @@ void cleanupFontList(sFontList *list){
 		SAFE_DELETE(refFnt->dynarrSheetIDs);
 		SAFE_DELETE(refFnt->dynarrCharcodes);
 		SAFE_DELETE(refFnt->dynarrOffsetY);
+		SAFE_DELETE(refFnt->dynarrMetrics);
+		SAFE_DELETE(refFnt->dynarrKerning);
+		SAFE_DELETE(list->dynarrFonts[i]);
 	}
 
-	memset(list, 0, sizeof(list));
+	SAFE_DELETE(list->dynarrFonts);
+	memset(list, 0, sizeof(sFontList));
 }
 
 void cleanupManifest(sManifest *man){
@@ -1052,10 +2378,22 @@ void cleanupManifest(sManifest *man){
 	}
 	SAFE_DELETE(man->dynarrStrFontNames);
 
+	SAFE_DELETE(man->nameHash.dynarrSeeds);
+	SAFE_DELETE(man->nameHash.dynarrSlots);
+
 	memset(man, 0, sizeof(sManifest));
 
 }
 
+void cleanupMemFile(sCramFile *file){
+	if(file == NULL)
+		return;
+
+	SAFE_DELETE(file->strName);
+	SAFE_DELETE(file->dynarrData);
+	file->size = 0;
+}
+
 void imgFNameToWSearch(const char *fName, char *outBuff, unsigned int sizeOutBuff){
 
 	if(fName == NULL) goto FAIL_imgFNameToWSearch;
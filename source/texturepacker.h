@@ -24,8 +24,10 @@
 #define TEXTUREPACKER_H
 
 #include <png.h>
+#include "texturecram.h"	/** The formats, and the files and images passed in and out of the library. */
 #include "strtools.h"
 #include "filetools.h"
+#include "threadpool.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -35,21 +37,32 @@ extern const int DEFAULT_COLOURTYPE;
 extern const int DEFAULT_INTERLACE;
 extern const size_t PNGHEAD_SIZE;
 
+#define OUT_PATH_ROOM 256	/*!< Room for the output path, that the name of each file written goes on the end of. */
+#define OUT_SUFFIX_ROOM 24	/*!< Room for what goes after it, like a sheet's number and extension, or the manifest's extension. */
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef enum defOutputFormat{
-	eFormatDefault, eFormatC, eFormatCPP, eFormatJava
-} eOutputFormat;
+/*!\brief	A file mapped in, that the pixels of several textures point into. It's unmapped along with the last of them. */
+typedef struct defMappedPixels{
+	void *addr;
+	size_t size;
+	unsigned int numTexs;	/*!< How many textures still point into it. */
+} sMappedPixels;
 
 typedef struct defsTex{
 	char *name;		/** Filename with the extension stripped off. */
 	unsigned int x, y;	 /** These are the pack coordinates. */
 	unsigned int w, h;	/** These are the pixel sizes of the image. */
+	bool rotated;		/*!< Turned a quarter turn clockwise on the sheet, so it covers h across and w down from x, y. */
 
 	png_byte **dynarrRows;		/** Number of rows is equal to the height of this texture. */
 	png_struct *pngptrData;
 	png_info *pngptrInfo;
-	png_byte colorType;
+	png_byte colorType;	/*!< PNG_COLOR_TYPE_GRAY for glyphs, which keep one byte a pixel, otherwise the rows are RGBA. */
+
+	bool sharedRows;		/*!< The rows point into one block of pixels, rather than each being allocated. */
+	png_byte *dynarrPixels;		/*!< The block the rows point into, when it's ours. Null when it's borrowed. Cleanup. */
+	sMappedPixels *refMapped;	/*!< The mapped file the rows point into, if they do. Shared, and let go of by cleanupTex. */
 } sTex;
 
 typedef struct defsPack{
@@ -80,6 +93,7 @@ typedef struct defsSheet{
 
 	unsigned int *dynarrTexIDs;
 	unsigned int num;
+	bool changed;	/*!< False only when the sheet is known to be identical to what was written on the last run. */
 } sSheet;
 
 typedef struct defSheetList{
@@ -87,12 +101,30 @@ typedef struct defSheetList{
 	unsigned int num;
 } sSheetList;
 
+/*!\brief	Where to draw a glyph and how far along it moves the pen, in pixels at the size it's on the sheets. */
+typedef struct defGlyphMetrics{
+	int advance;
+	int bearingX;	/*!< From the pen to the left of the glyph's rect. */
+	int bearingY;	/*!< From the baseline up to the top of the glyph's rect. */
+} sGlyphMetrics;
+
+/*!\brief	How much to add to the advance of the left glyph when the right one follows it. Both are glyphs of the same font. */
+typedef struct defKernPair{
+	unsigned int left, right;
+	int amount;
+} sKernPair;
+
 typedef struct defFont{
 	unsigned int *dynarrTexIDs;
 	unsigned int *dynarrSheetIDs;
 	unsigned int *dynarrCharcodes;
 	unsigned int *dynarrOffsetY;
+	sGlyphMetrics *dynarrMetrics;
+	sKernPair *dynarrKerning;	/*!< Sorted by the left glyph, then the right, and only the pairs that aren't zero. */
 	unsigned int num;
+	unsigned int numKerning;
+	unsigned int sdfSpread;	/*!< Non zero if the glyphs are signed distance fields, reaching this many pixels either side of the edge. */
+	unsigned char colour[3];	/*!< The glyphs are white on the sheets, so this is what to tint them with. */
 } sFont;
 
 typedef struct defFontList{
@@ -100,6 +132,19 @@ typedef struct defFontList{
 	unsigned int num;
 } sFontList;
 
+/*!\brief	A minimal perfect hash over every name in a manifest, so a name can be found without building a table at runtime.
+ *!		To look a name up, take the seed at hashName(0, name) % numSeeds. A negative seed is the slot, as -slot -1,
+ *!		otherwise the slot is hashName(seed, name) % numSlots. The slot holds the entry: stills come first, then
+ *!		sequences, then fonts, each in manifest order. Names that aren't in the manifest land on some other entry, so
+ *!		compare the name to be sure.
+ */
+typedef struct defNameHash{
+	int *dynarrSeeds;		/*!< Cleanup. */
+	unsigned int numSeeds;
+	unsigned int *dynarrSlots;	/*!< Cleanup. */
+	unsigned int numSlots;		/*!< Zero if there are no names. */
+} sNameHash;
+
 typedef struct defsMenifest{
 	sSheetList const *refSheets;
 
@@ -111,8 +156,47 @@ typedef struct defsMenifest{
 
 	char **dynarrStrFontNames;
 	sFontList const *refFonts;
+
+	sNameHash nameHash;
 } sManifest;
 
+/*!\brief	Where a texture was placed on a previous run. */
+typedef struct defLayoutEntry{
+	char *name;	/*!< Cleanup. */
+	unsigned int sheet;
+	unsigned int x, y, w, h;
+	bool rotated;
+	unsigned int hash;	/*!< hashTex of the texture when it was placed. */
+} sLayoutEntry;
+
+typedef struct defLayoutSheet{
+	unsigned int w, h;
+	unsigned int num;	/*!< How many textures were on this sheet. */
+} sLayoutSheet;
+
+/*!\brief	The arrangement from a previous run, loaded from the layout file written next to the manifest. */
+typedef struct defLayout{
+	sLayoutEntry *dynarrEntries;	/*!< Sorted by name. Cleanup. */
+	unsigned int num;
+
+	sLayoutSheet *dynarrSheets;	/*!< Cleanup. */
+	unsigned int numSheets;
+} sLayout;
+
+/*!\brief	A decoded texture, and the state of the file it came from. */
+typedef struct defTexCacheEntry{
+	char *name;	/*!< File name, relative to the directory. Cleanup. */
+	sFileStamp stamp;
+	sTex *tex;	/*!< Can be null if the file couldn't be read. Cleanup. */
+	bool seen;
+} sTexCacheEntry;
+
+/*!\brief	Keeps textures decoded between runs, so only the files that have changed are read again. */
+typedef struct defTexCache{
+	sTexCacheEntry *dynarrEntries;	/*!< Sorted by name, between calls to genTexturesCached. Cleanup. */
+	unsigned int num;
+} sTexCache;
+
 //*!\brief	Stores info about the spot we last wrote to the sheet. */
 typedef struct defsSpotSheetWrite{
 	unsigned int x, y, h, w, lineH;
@@ -125,7 +209,26 @@ typedef struct defsSpotSheetWrite{
  */
 errCode genTextures(const char *rootDir, const sFileList *files, sTex ***dynarrTextures);
 
-/*!\brief	Sorts the list of textures into stills and sequences.
+/*!\brief	Same as genTextures, except textures are taken from the cache when their file hasn't changed.
+ *!\note	The cache owns the textures, so only clean up the array it gives you, not its content.
+ *!		Entries for files that are no longer in the list are dropped from the cache.
+ *!\param	pool	If not null, the files that need decoding are decoded at the same time on the pool.
+ */
+errCode genTexturesCached(const char *rootDir, const sFileList *files, sTexCache *cache, sTex ***dynarrTextures, sThreadPool *pool);
+
+/*!\brief	Same as genTextures, except the PNGs are already in memory. The files are only read, so they stay yours.
+ *!\param	pool	If not null, the files are decoded at the same time on the pool.
+ */
+errCode genTexturesFromMem(const sCramFile *arrFiles, unsigned int numFiles, sTex ***dynarrTextures, sThreadPool *pool);
+
+/*!\brief	Makes textures out of pixels that are already decoded, without copying them. The textures' rows point
+ *!		straight into the images, so pixels that aren't handed over have to stay put until the sheets are written.
+ *!\return	PROBLEM if any of the images were left out for having a bad size. Their pixels are still freed if they were handed over.
+ */
+errCode genTexturesFromRaw(const sCramRawImage *arrImages, unsigned int numImages, sTex ***dynarrTextures);
+
+/*!\brief	Sorts the list of textures into stills and sequences. Textures whose names only differ by the number in
+ *!		front of the extension are frames of a sequence, ordered by that number, wherever they are in the list.
  */
 errCode sortTextures(sTex **arrSortMe, sSeqList *outSeqs, sStillList *outStills);
 
@@ -135,6 +238,9 @@ errCode sortTextures(sTex **arrSortMe, sSeqList *outSeqs, sStillList *outStills)
  *!\param	pFonts
  *!\param	dynarrOutSheets	Output a NULL terminated list of sheets which relates the textures to the sheets. You'll need to clean this list up.
  *!\param	maxSquare	The max size each sheet can reach.	
+ *!\param	allowRotate	Textures can be turned a quarter turn clockwise, when it fits them in tighter. See sTex::rotated.
+ *!\param	refPrev		Layout from the previous run, can be null. Stills, sequences and fonts that are the same size as last
+ *!				time are put back in the same spot, and everything else is fitted into the holes left over.
  */
 errCode arrangeTextures(
 	sTex **arrTexs,
@@ -142,9 +248,14 @@ errCode arrangeTextures(
 	sStillList *pStills,
 	sFontList *pFonts,
 	sSheetList *pOutSheets, 
-	unsigned int maxSquare
+	unsigned int maxSquare,
+	bool allowRotate,
+	const sLayout *refPrev
 );
 
+/*!\brief	Grows every sheet to the next power of 2 across and down, if it isn't one already. The extra is left clear. */
+void growSheetsToPow2(sSheetList *pSheets);
+
 /*!\brief	Generates the manifest.
  */
 errCode genMan(
@@ -157,13 +268,118 @@ errCode genMan(
 	sManifest *outMan
 );
 
-/*!\brief	Outputs the sheets.
+/*!\brief	The hash the name lookup tables are built with, FNV-1a with the seed mixed into the start, then scrambled.
+ *!		Kept to 31 bits so it's the same in languages without unsigned numbers.
+ */
+unsigned int hashName(unsigned int seed, const char *strName);
+
+/*!\brief	Finds where a name would be in the manifest, using its name hash.
+ *!\return	The entry, or a negative if there are no names. The entry still has to be checked, see sNameHash.
+ */
+int findNameHash(const sNameHash *refHash, const char *strName);
+
+/*!\brief	Loads the layout file written by writeLayout.
+ *!\return	PROBLEM if there is no layout file or it can't be read, in which case outLayout is left empty.
+ */
+errCode readLayout(const char *strFile, sLayout *outLayout);
+
+/*!\brief	Writes where every texture on the sheets was placed, so the next run can reuse it. */
+errCode writeLayout(const char *strFile, const sSheetList *refSheets, const sTex **refarrTexs);
+
+/*!\brief	Fills a layout from the current arrangement, the same as writing and then reading the layout file. */
+errCode genLayout(const sSheetList *refSheets, const sTex **refarrTexs, sLayout *outLayout);
+
+/*!\brief	Returns the index of the first layout entry with the given name, or a negative if there isn't one. */
+int findLayoutEntry(const sLayout *refLayout, const char *strName);
+
+/*!\brief	*/
+void cleanupLayout(sLayout *layout);
+
+/*!\brief	Hashes the dimensions and pixels of a texture. */
+unsigned int hashTex(const sTex *refTex);
+
+/*!\brief	How many bytes each pixel takes up in the texture's rows. */
+unsigned int getTexBytesPP(const sTex *refTex);
+
+/*!\brief	Outputs the sheets. Sheets that haven't changed since the last run, and are still on disk, are skipped.
+ *!\note	A digest of every sheet's pixels is kept in a '.digest' file next to the sheets. When a sheet's digest is the
+ *!		same as last time and the file is still there, it isn't encoded and written again.
  *!\param	strPath		Path to write the sheet to.
  *!\param	strManName	The name of the file.
  *!\param	arrSheets	The
  *!\param	pow2		Should the sheets be padded to be a
+ *!\param	glyphFormat	What sheets with only glyphs on are written as.
+ *!\param	pool		If not null, the sheets are composed and encoded at the same time on the pool.
+ */
+errCode writeSheets(const char *strPath, const char *strManName, sTex **refArrTex, sSheetList *pSheets, eCramGlyphFormat glyphFormat, sThreadPool *pool);
+
+/*!\brief	What writeSheets names the sheet with, '.r8' if it's written as raw glyph coverage, otherwise '.png'. */
+const char* getSheetExtension(sTex **refArrTex, const sSheet *refSheet, eCramGlyphFormat glyphFormat);
+
+/*!\brief	Same as writeSheets, except the PNGs are kept in memory, and there's no digest to skip sheets that haven't changed.
+ *!\param	outFiles	One for each sheet, named after the sheet. Clean each of them up.
+ */
+errCode encodeSheets(const char *strManName, sTex **refArrTex, const sSheetList *pSheets, eCramGlyphFormat glyphFormat, sCramFile *outFiles, sThreadPool *pool);
+
+/*!\brief	Writes the standard pack info file. */
+errCode writeManifestInTxt(FILE *handFile, const sManifest *writeMe, const sTex **refarrTexs);
+
+/*!\brief	Writes the manifest as a C or C++ header that you can include in your project. Everything is in constant
+ *!		tables, with an enum for each still, sequence and font, so nothing is parsed or built at runtime.
+ *!\param	strName	Prefixes everything in the header, so more than one manifest can be included.
+ *!\param	cpp	Makes the tables and lookup constexpr, which needs C++14.
+ */
+errCode writeManifestInC(FILE *handFile, const char *strName, bool cpp, const sManifest *writeMe, const sTex **refarrTexs);
+
+/*!\brief	Writes the manifest as a binary file that can be mapped into memory and used in place. The layout is in manbin.h.
+ *!\note	The file has to be opened in binary mode.
+ */
+errCode writeManifestInBin(FILE *handFile, const sManifest *writeMe, const sTex **refarrTexs);
+
+/*!\brief	Writes the manifest as a java file that you can includes in your project.
+ *!\param	strClassName	Has to be the same as the file name, without the extension.
+ */
+errCode writeManifestInJava(
+	FILE *handFile,
+	const char *strClassName,
+	const char *javapakName,
+	const char *refstrClass,
+	const sManifest *writeMe,
+	const sTex **refarrTexs
+);
+
+/*!\brief	Same as writeManifestInJava, except everything is in a few int arrays indexed by generated constants, rather
+ *!		than an object for every entry. Much quicker to load, especially on android.
+ */
+errCode writeManifestInJavaPacked(
+	FILE *handFile,
+	const char *strClassName,
+	const char *javapakName,
+	const sManifest *writeMe,
+	const sTex **refarrTexs
+);
+
+/*!\brief	Writes the manifest in the format from the options.
+ *!\param	strName	Name the sheets and manifest go under. Java uses it for the class name.
  */
-errCode writeSheets(const char *strPath, const char *strManName, sTex **refArrTex, sSheetList *pSheets);
+errCode writeManifest(
+	FILE *handFile,
+	const sCramOptions *refOptions,
+	const char *strName,
+	const sManifest *refMan,
+	const sTex **refarrTexs
+);
+
+/*!\brief	Same as writeManifest, to a file.
+ *!\param	strPath	Where to write to, without the extension.
+ */
+errCode saveManifest(
+	const char *strPath,
+	const sCramOptions *refOptions,
+	const char *strName,
+	const sManifest *refMan,
+	const sTex **refarrTexs
+);
 
 /*!\brief	*/
 void appendTexArr(sTex ***pAppendHere, sTex **pFrom);
@@ -171,6 +387,9 @@ void appendTexArr(sTex ***pAppendHere, sTex **pFrom);
 /*!\brief	Cleanups up a single textures. */
 void cleanupTex(sTex *pTex);
 
+/*!\brief	Cleans up the cache and every texture in it. */
+void cleanupTexCache(sTexCache *cache);
+
 /*!\brief	Cleans up the textures and their dynamic array.	*/
 void cleanupTextures(sTex ***dynarrTextures);
 
@@ -189,6 +408,9 @@ void cleanupFontList(sFontList *list);
 /*!\brief	*/
 void cleanupManifest(sManifest *man);
 
+/*!\brief	*/
+void cleanupMemFile(sCramFile *file);
+
 /*!brief	Converts the frame name to a search string. */
 void imgFNameToWSearch(const char *fName, char *outBuff, unsigned int sizeOutBuff);
 
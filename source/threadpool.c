@@ -0,0 +1,308 @@
+/*
+ *
+ *  Copyright (C) 2011  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threadpool.h"
+
+#include <unistd.h>
+
+/*!\brief	What a worker thread needs to know about itself. */
+typedef struct defWorkerArgs{
+	sThreadPool *pool;
+	unsigned int idx;
+} sWorkerArgs;
+
+static __thread sThreadPool *gWorkerPool = NULL;	/*!< The pool this thread works for, if any. */
+static __thread unsigned int gIdxWorker = 0;
+
+static const unsigned int DEQUE_START_CAP = 16;
+
+/*!\brief	Index of the deque the calling thread should push to, and take from first. */
+static unsigned int ownDeque(const sThreadPool *pool){
+	return (gWorkerPool == pool) ? gIdxWorker : pool->numWorkers;
+}
+
+static void pushDeque(sTaskDeque *deque, const sTask *refTask){
+	unsigned int i, newCap;
+	sTask *dynarrNew;
+
+	pthread_mutex_lock(&deque->lock);
+
+	if(deque->num == deque->cap){	/** Unwrap into a bigger ring. */
+		newCap = (deque->cap == 0) ? DEQUE_START_CAP : deque->cap * 2;
+		dynarrNew = malloc_chk(newCap * sizeof(sTask));
+		for(i=0; i < deque->num; ++i)
+			dynarrNew[i] = deque->dynarrTasks[(deque->head + i) % deque->cap];
+
+		SAFE_DELETE(deque->dynarrTasks);
+		deque->dynarrTasks = dynarrNew;
+		deque->cap = newCap;
+		deque->head = 0;
+	}
+
+	deque->dynarrTasks[(deque->head + deque->num) % deque->cap] = *refTask;
+	++deque->num;
+
+	pthread_mutex_unlock(&deque->lock);
+}
+
+/*!\brief	Takes the newest task if it's our deque, otherwise the oldest.
+ *!\return	FALSE if there was nothing to take.
+ */
+static bool takeDeque(sTaskDeque *deque, bool newest, sTask *outTask){
+	bool found = FALSE;
+
+	pthread_mutex_lock(&deque->lock);
+
+	if(deque->num > 0){
+		if(newest == TRUE){
+			*outTask = deque->dynarrTasks[(deque->head + deque->num -1) % deque->cap];
+		}else{
+			*outTask = deque->dynarrTasks[deque->head];
+			deque->head = (deque->head +1) % deque->cap;
+		}
+		--deque->num;
+		found = TRUE;
+	}
+
+	pthread_mutex_unlock(&deque->lock);
+	return found;
+}
+
+/*!\brief	Looks in our own deque first, then goes round the others looking for something to steal. */
+static bool findTask(sThreadPool *pool, sTask *outTask){
+	const unsigned int numDeques = pool->numWorkers +1;
+	const unsigned int idxOwn = ownDeque(pool);
+	unsigned int i;
+	bool found = takeDeque(&pool->dynarrDeques[idxOwn], TRUE, outTask);
+
+	for(i=1; found == FALSE && i < numDeques; ++i)
+		found = takeDeque(&pool->dynarrDeques[(idxOwn + i) % numDeques], FALSE, outTask);
+
+	if(found == TRUE){
+		pthread_mutex_lock(&pool->lockSleep);
+		--pool->numQueued;
+		pthread_mutex_unlock(&pool->lockSleep);
+	}
+
+	return found;
+}
+
+static void runTask(sThreadPool *pool, sTask *refTask){
+	refTask->foo(refTask->data);
+
+	pthread_mutex_lock(&pool->lockSleep);
+	--refTask->group->pending;
+	if(refTask->group->pending == 0)
+		pthread_cond_broadcast(&pool->wake);	/** Someone might be waiting on the group. */
+	pthread_mutex_unlock(&pool->lockSleep);
+}
+
+static void* workerMain(void *data){
+	sWorkerArgs *args = (sWorkerArgs*)data;
+	sThreadPool *pool = args->pool;
+	sTask task;
+
+	gWorkerPool = pool;
+	gIdxWorker = args->idx;
+	SAFE_DELETE(args);
+
+	for(;;){
+		if(findTask(pool, &task) == TRUE){
+			runTask(pool, &task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lockSleep);
+		while(pool->numQueued == 0 && pool->stop == FALSE)
+			pthread_cond_wait(&pool->wake, &pool->lockSleep);
+
+		if(pool->stop == TRUE && pool->numQueued == 0){
+			pthread_mutex_unlock(&pool->lockSleep);
+			break;
+		}
+		pthread_mutex_unlock(&pool->lockSleep);
+	}
+
+	return NULL;
+}
+
+unsigned int getNumCores(void){
+	long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+	return (numCores > 0) ? (unsigned int)numCores : 1;
+}
+
+errCode startThreadPool(sThreadPool *pool, unsigned int numThreads){
+	unsigned int i;
+	sWorkerArgs *args;
+
+	if(pool == NULL)
+		return ERROR;
+
+	memset(pool, 0, sizeof(sThreadPool));
+
+	if(numThreads == 0)
+		numThreads = getNumCores();
+
+	pool->numWorkers = numThreads -1;	/** The waiting thread makes up the last one. */
+	pthread_mutex_init(&pool->lockSleep, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+
+	pool->dynarrDeques = calloc_chk(pool->numWorkers +1, sizeof(sTaskDeque));
+	for(i=0; i < pool->numWorkers +1; ++i)
+		pthread_mutex_init(&pool->dynarrDeques[i].lock, NULL);
+
+	if(pool->numWorkers > 0)
+		pool->dynarrThreads = calloc_chk(pool->numWorkers, sizeof(pthread_t));
+
+	for(i=0; i < pool->numWorkers; ++i){
+		args = malloc_chk(sizeof(sWorkerArgs));
+		args->pool = pool;
+		args->idx = i;
+
+		if(pthread_create(&pool->dynarrThreads[i], NULL, workerMain, args) != 0){
+			WARN("Only able to start %u worker threads", i);
+			SAFE_DELETE(args);
+			pool->numWorkers = i;	/** The waiting thread still gets the last deque, and the rest go unused. */
+			break;
+		}
+	}
+
+	return NOPROB;
+}
+
+void submitTask(sThreadPool *pool, sTaskGroup *group, fooTask foo, void *data){
+	sTask task;
+
+	task.foo = foo;
+	task.data = data;
+	task.group = group;
+
+	pthread_mutex_lock(&pool->lockSleep);	/** Counted before it's pushed, so a thief that takes it straight away can't take the count below zero. */
+	++group->pending;
+	++pool->numQueued;
+	pthread_mutex_unlock(&pool->lockSleep);
+
+	pushDeque(&pool->dynarrDeques[ownDeque(pool)], &task);
+
+	pthread_mutex_lock(&pool->lockSleep);
+	pthread_cond_signal(&pool->wake);
+	pthread_mutex_unlock(&pool->lockSleep);
+}
+
+void waitTaskGroup(sThreadPool *pool, sTaskGroup *group){
+	sTask task;
+
+	for(;;){
+		if(findTask(pool, &task) == TRUE){
+			runTask(pool, &task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lockSleep);
+		while(pool->numQueued == 0 && group->pending > 0)
+			pthread_cond_wait(&pool->wake, &pool->lockSleep);
+
+		if(group->pending == 0){
+			pthread_mutex_unlock(&pool->lockSleep);
+			break;
+		}
+		pthread_mutex_unlock(&pool->lockSleep);
+	}
+}
+
+void stopThreadPool(sThreadPool *pool){
+	unsigned int i;
+
+	if(pool == NULL || pool->dynarrDeques == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lockSleep);
+	pool->stop = TRUE;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lockSleep);
+
+	for(i=0; i < pool->numWorkers; ++i)
+		pthread_join(pool->dynarrThreads[i], NULL);
+
+	for(i=0; i < pool->numWorkers +1; ++i){
+		pthread_mutex_destroy(&pool->dynarrDeques[i].lock);
+		SAFE_DELETE(pool->dynarrDeques[i].dynarrTasks);
+	}
+
+	SAFE_DELETE(pool->dynarrDeques);
+	SAFE_DELETE(pool->dynarrThreads);
+	pthread_mutex_destroy(&pool->lockSleep);
+	pthread_cond_destroy(&pool->wake);
+	memset(pool, 0, sizeof(sThreadPool));
+}
+
+void initBoundQueue(sBoundQueue *queue, unsigned int cap){
+	memset(queue, 0, sizeof(sBoundQueue));
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->notFull, NULL);
+	pthread_cond_init(&queue->notEmpty, NULL);
+	queue->cap = (cap > 0) ? cap : 1;
+	queue->dynarrItems = calloc_chk(queue->cap, sizeof(void*));
+}
+
+void pushBoundQueue(sBoundQueue *queue, void *item){
+	pthread_mutex_lock(&queue->lock);
+
+	while(queue->num == queue->cap)
+		pthread_cond_wait(&queue->notFull, &queue->lock);
+
+	queue->dynarrItems[(queue->head + queue->num) % queue->cap] = item;
+	++queue->num;
+
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+void* popBoundQueue(sBoundQueue *queue){
+	void *item = NULL;
+
+	pthread_mutex_lock(&queue->lock);
+
+	while(queue->num == 0 && queue->closed == FALSE)
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+
+	if(queue->num > 0){
+		item = queue->dynarrItems[queue->head];
+		queue->head = (queue->head +1) % queue->cap;
+		--queue->num;
+		pthread_cond_signal(&queue->notFull);
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+	return item;
+}
+
+void closeBoundQueue(sBoundQueue *queue){
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = TRUE;
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+void cleanupBoundQueue(sBoundQueue *queue){
+	SAFE_DELETE(queue->dynarrItems);
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->notFull);
+	pthread_cond_destroy(&queue->notEmpty);
+	memset(queue, 0, sizeof(sBoundQueue));
+}
@@ -0,0 +1,110 @@
+/*
+ *
+ *  Copyright (C) 2011  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include "utils.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*fooTask)(void *data);
+
+/*!\brief	Tasks that are waited on together. */
+typedef struct defTaskGroup{
+	unsigned int pending;	/*!< Tasks that haven't finished yet. Guarded by the pool. */
+} sTaskGroup;
+
+typedef struct defTask{
+	fooTask foo;
+	void *data;
+	sTaskGroup *group;
+} sTask;
+
+/*!\brief	Tasks waiting to run on a worker. The worker takes the newest task, and other workers steal the oldest. */
+typedef struct defTaskDeque{
+	pthread_mutex_t lock;
+	sTask *dynarrTasks;	/*!< Ring buffer. Cleanup. */
+	unsigned int head, num, cap;
+} sTaskDeque;
+
+/*!\brief	Worker threads which each keep their own queue of tasks, and steal from the others when they run out. */
+typedef struct defThreadPool{
+	pthread_t *dynarrThreads;	/*!< Cleanup. */
+	sTaskDeque *dynarrDeques;	/*!< One for each worker, then one for the threads outside the pool. Cleanup. */
+	unsigned int numWorkers;
+
+	pthread_mutex_t lockSleep;
+	pthread_cond_t wake;
+	unsigned int numQueued;	/*!< Tasks sitting in the deques. Guarded by lockSleep. */
+	bool stop;
+} sThreadPool;
+
+/*!\brief	A queue with a limit on how much it holds, for passing work from one thread to the next. Pushing to a full
+ *!		queue waits until there's room, so a fast thread can't get too far ahead of a slow one.
+ */
+typedef struct defBoundQueue{
+	pthread_mutex_t lock;
+	pthread_cond_t notFull, notEmpty;
+	void **dynarrItems;	/*!< Ring buffer. Cleanup. */
+	unsigned int head, num, cap;
+	bool closed;		/*!< Nothing more is coming. */
+} sBoundQueue;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Returns how many cores we can use. */
+unsigned int getNumCores(void);
+
+/*!\brief	Starts the worker threads.
+ *!\param	numThreads	How many threads do the work, counting the one that waits on the tasks, as it helps out while
+ *!				it waits. Zero uses every core, and one means everything runs on the waiting thread.
+ */
+errCode startThreadPool(sThreadPool *pool, unsigned int numThreads);
+
+/*!\brief	Queues a task to run on the pool. Tasks added by a worker go on its own queue, so they stay on that worker
+ *!		unless another worker is idle and steals them.
+ *!\param	group	Counts the task as pending until it's finished.
+ */
+void submitTask(sThreadPool *pool, sTaskGroup *group, fooTask foo, void *data);
+
+/*!\brief	Runs queued tasks until every task in the group is done. It's safe to wait from inside a task. */
+void waitTaskGroup(sThreadPool *pool, sTaskGroup *group);
+
+/*!\brief	Waits for the workers to finish what they're doing, then cleans up the pool. */
+void stopThreadPool(sThreadPool *pool);
+
+/*!\brief	*/
+void initBoundQueue(sBoundQueue *queue, unsigned int cap);
+
+/*!\brief	Adds to the end of the queue, waiting if it's full. */
+void pushBoundQueue(sBoundQueue *queue, void *item);
+
+/*!\brief	Takes from the front of the queue, waiting if it's empty.
+ *!\return	NULL once the queue is closed and empty.
+ */
+void* popBoundQueue(sBoundQueue *queue);
+
+/*!\brief	Tells whoever is popping that nothing more is coming. */
+void closeBoundQueue(sBoundQueue *queue);
+
+/*!\brief	*/
+void cleanupBoundQueue(sBoundQueue *queue);
+
+#endif
@@ -3,11 +3,6 @@
 #include <stdlib.h>
 #include <memory.h>
 
-char gbuff[512];
-
-const char *STR_WARN_FORMAT = "<warning> %s [%s : %i]\n";
-const char *STR_ERROR_FORMAT = "<fatal error> %s [%s : %i]\n";
-
 static const char refstrMemFault[] = "Out of memory\n";
 void memcheck(const void *memptr){
 	if(memptr == NULL){
@@ -24,6 +19,44 @@ unsigned int closestPow2(unsigned int num){
 	return a;
 }
 
+unsigned int hashMem(const void *data, size_t len, unsigned int hash){
+	const unsigned char *itr = (const unsigned char*)data;
+	const unsigned char *end = itr + len;
+
+	while(itr < end){
+		hash ^= *itr;
+		hash *= 16777619u;
+		++itr;
+	}
+	return hash;
+}
+
+unsigned long long hashMem64(const void *data, size_t len, unsigned long long hash){
+	const unsigned char *itr = (const unsigned char*)data;
+	const unsigned char *end = itr + len;
+
+	while(itr < end){
+		hash ^= *itr;
+		hash *= 1099511628211ull;
+		++itr;
+	}
+	return hash;
+}
+
+unsigned long long hashWords64(const void *data, size_t len, unsigned long long hash){
+	const unsigned char *itr = (const unsigned char*)data;
+	const unsigned char *end = itr + (len - len % sizeof(unsigned long long));
+	unsigned long long word;
+
+	for(; itr < end; itr += sizeof(word)){
+		memcpy(&word, itr, sizeof(word));	/** Rows aren't always lined up on 8 bytes. */
+		hash ^= word;
+		hash *= 1099511628211ull;
+		hash ^= hash >> 32;	/** Otherwise the top bytes of a word would only ever reach the top of the hash. */
+	}
+	return hashMem64(itr, len % sizeof(unsigned long long), hash);
+}
+
 errCode eoe(errCode in, const char *file, unsigned int line){
 	if(in == ERROR){
 		printf("<FAIL> Got error code at '%s' at line %i.\n", file, line);
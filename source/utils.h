@@ -25,31 +25,15 @@
 
 #define SAFE_DELETE(x) { if(x!=NULL) free(x); x = NULL; }
 #define EOE(code) eoe(code, __FILE__, __LINE__)
+#define HASH_START 2166136261u
+#define HASH64_START 14695981039346656037ull
 
-extern char gbuff[512];
-extern const char *STR_WARN_FORMAT;
-extern const char *STR_ERROR_FORMAT;
-
-#define WARN(...) {\
-	snprintf(gbuff, 512, __VA_ARGS__);\
-	printf(STR_WARN_FORMAT, gbuff, __FILE__, __LINE__);\
-}
-
-#define LOG(...) {\
-	snprintf(gbuff, 512, __VA_ARGS__);\
-	printf("%s\n", gbuff);\
-}
-
-#define ERROR_LOG(...){\
-	snprintf(gbuff, 512, __VA_ARGS__);\
-	printf(STR_ERROR_FORMAT, gbuff, __FILE__, __LINE__);\
-}
+#define WARN(...) logLine(eLogWarn, __FILE__, __LINE__, __VA_ARGS__)
+#define LOG(...) logLine(eLogInfo, __FILE__, __LINE__, __VA_ARGS__)
+#define ERROR_LOG(...) logLine(eLogError, __FILE__, __LINE__, __VA_ARGS__)
 
 #ifdef DEBUG
-#	define DBUG_LOG(...) {\
-			snprintf(gbuff, 512, __VA_ARGS__);\
-			printf("%s [%s : %i]\n", gbuff, __FILE__, __LINE__);\
-		}
+#	define DBUG_LOG(...) logLine(eLogDebug, __FILE__, __LINE__, __VA_ARGS__)
 #	define DBUG_WARN(...) WARN(__VA_ARGS__)
 #	ifdef XTRA_LOGGING
 #		define XTRA_LOG(...) LOG(__VA_ARGS__)
@@ -79,6 +63,8 @@ typedef struct defListUint{
 	size_t num;
 } sListUint;
 
+#include "log.h"	/** The logging macros need it, and it needs the types above. */
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /*!\brief	Checks if a null pointer, and exits if it is.*/
@@ -87,6 +73,17 @@ void memcheck(const void *memptr);
 /*!\brief	*/
 unsigned int closestPow2(unsigned int num);
 
+/*!\brief	FNV-1a hash of a block of memory. Pass HASH_START for a fresh hash, or a previous result to keep hashing more blocks. */
+unsigned int hashMem(const void *data, size_t len, unsigned int hash);
+
+/*!\brief	64 bit version of hashMem, for when a collision would go unnoticed. Start with HASH64_START. */
+unsigned long long hashMem64(const void *data, size_t len, unsigned long long hash);
+
+/*!\brief	Same idea as hashMem64, but takes 8 bytes at a time, for when there's a lot to get through. Gives different
+ *!		results to hashMem64, so stick to one or the other for anything that's kept.
+ */
+unsigned long long hashWords64(const void *data, size_t len, unsigned long long hash);
+
 /*!\brief	Exit On Error: Prints message and exits the program if it gets an ERROR. Otherwise it passes the other error codes out. */
 errCode eoe(errCode in, const char *file, unsigned int line);
 
@@ -0,0 +1,216 @@
+/*
+ *
+ *  Copyright (C) 2011  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "watch.h"
+
+#if defined __linux
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+#if defined __linux
+
+static const uint32_t WATCH_EVENTS =
+	IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_DELETE_SELF;
+
+errCode startWatching(sWatcher *watcher){
+	if(watcher == NULL)
+		return ERROR;
+
+	memset(watcher, 0, sizeof(sWatcher));
+	watcher->fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	if(watcher->fd < 0){
+		WARN("Unable to start watching for changes");
+		return PROBLEM;
+	}
+
+	return NOPROB;
+}
+
+errCode addWatch(sWatcher *watcher, const char *strDir, unsigned int id, const char *strIgnore){
+	unsigned int i;
+	sWatchDir *refDir;
+	int wd;
+
+	if(watcher == NULL || strDir == NULL || watcher->fd < 0)
+		return ERROR;
+
+	wd = inotify_add_watch(watcher->fd, strDir, WATCH_EVENTS | IN_ONLYDIR);
+	if(wd < 0){
+		WARN("Unable to watch %s", strDir);
+		return PROBLEM;
+	}
+
+	refDir = NULL;
+	for(i=0; i < watcher->num; ++i){
+		if(watcher->dynarrDirs[i].wd == wd){
+			refDir = &watcher->dynarrDirs[i];
+			cleanupWildStr(&refDir->ignore);
+			break;
+		}
+	}
+
+	if(refDir == NULL){
+		++watcher->num;
+		watcher->dynarrDirs = realloc_chk(watcher->dynarrDirs, watcher->num * sizeof(sWatchDir));
+		refDir = &watcher->dynarrDirs[watcher->num -1];
+		memset(refDir, 0, sizeof(sWatchDir));
+		refDir->wd = wd;
+	}
+
+	refDir->id = id;
+	compileWildStr(strIgnore, &refDir->ignore);
+
+	return NOPROB;
+}
+
+/*!\brief	Reads every event that's waiting, without blocking, and adds the IDs of the directories that had something worth repacking.
+ *!\return	TRUE if any of the events were worth repacking for.
+ */
+static bool readEvents(sWatcher *watcher, sListUint *outIDs){
+	char buff[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *refEvent;
+	sWatchDir const *refDir;
+	ssize_t lenRead;
+	char *itr;
+	unsigned int i;
+	bool found = FALSE;
+
+	for(;;){
+		lenRead = read(watcher->fd, buff, sizeof(buff));
+		if(lenRead <= 0)
+			break;
+
+		for(itr = buff; itr < buff + lenRead; itr += sizeof(struct inotify_event) + refEvent->len){
+			refEvent = (const struct inotify_event*)itr;
+
+			refDir = NULL;
+			for(i=0; i < watcher->num; ++i){
+				if(watcher->dynarrDirs[i].wd == refEvent->wd){
+					refDir = &watcher->dynarrDirs[i];
+					break;
+				}
+			}
+
+			if(refDir == NULL)
+				continue;
+
+			if((refEvent->mask & IN_CREATE) != 0 && (refEvent->mask & IN_ISDIR) == 0)
+				continue;	/** Wait for the file to be closed. */
+
+			if(refEvent->len > 0){
+				if(refEvent->name[0] == '.')	/** Hidden and editor swap files. */
+					continue;
+
+				if(matchWildStr(refEvent->name, &refDir->ignore) == TRUE)
+					continue;
+			}
+
+			XTRA_LOG("Change in %s", (refEvent->len > 0) ? refEvent->name : "watched directory");
+
+			for(i=0; i < outIDs->num && outIDs->arr[i] != refDir->id; ++i)
+				;
+
+			if(i == outIDs->num)
+				pushListUint(outIDs, refDir->id);
+
+			found = TRUE;
+		}
+	}
+
+	return found;
+}
+
+errCode waitForChanges(sWatcher *watcher, unsigned int debounceMs, sListUint *outIDs){
+	struct pollfd pollWatch;
+	int rtnPoll;
+
+	if(watcher == NULL || outIDs == NULL || watcher->fd < 0)
+		return ERROR;
+
+	pollWatch.fd = watcher->fd;
+	pollWatch.events = POLLIN;
+
+	do{	/** Block until there's something we care about. */
+		rtnPoll = poll(&pollWatch, 1, -1);
+		if(rtnPoll < 0)
+			return PROBLEM;
+
+	}while(readEvents(watcher, outIDs) == FALSE);
+
+	for(;;){	/** Then wait for it to go quiet. */
+		pollWatch.revents = 0;
+		rtnPoll = poll(&pollWatch, 1, (int)debounceMs);
+		if(rtnPoll < 0)
+			return PROBLEM;
+
+		if(rtnPoll == 0)
+			break;
+
+		readEvents(watcher, outIDs);
+	}
+
+	return NOPROB;
+}
+
+void stopWatching(sWatcher *watcher){
+	unsigned int i;
+
+	if(watcher == NULL)
+		return;
+
+	for(i=0; i < watcher->num; ++i)
+		cleanupWildStr(&watcher->dynarrDirs[i].ignore);
+
+	SAFE_DELETE(watcher->dynarrDirs);
+	watcher->num = 0;
+
+	if(watcher->fd >= 0)
+		close(watcher->fd);
+	watcher->fd = -1;
+}
+
+#else
+
+errCode startWatching(sWatcher *watcher){
+	if(watcher == NULL)
+		return ERROR;
+
+	memset(watcher, 0, sizeof(sWatcher));
+	watcher->fd = -1;
+	WARN("Watching for changes is only supported on linux");
+	return PROBLEM;
+}
+
+errCode addWatch(sWatcher *watcher, const char *strDir, unsigned int id, const char *strIgnore){
+	return PROBLEM;
+}
+
+errCode waitForChanges(sWatcher *watcher, unsigned int debounceMs, sListUint *outIDs){
+	return PROBLEM;
+}
+
+void stopWatching(sWatcher *watcher){
+	if(watcher != NULL){
+		SAFE_DELETE(watcher->dynarrDirs);
+		watcher->num = 0;
+	}
+}
+
+#endif
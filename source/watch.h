@@ -0,0 +1,64 @@
+/*
+ *
+ *  Copyright (C) 2011  Stuart Bridgens
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License (version 3) as published by
+ *  the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "utils.h"
+#include "strtools.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	A directory being watched, and the ID the caller gave it. */
+typedef struct defWatchDir{
+	int wd;		/*!< Watch descriptor. */
+	unsigned int id;
+	sWildMatch ignore;	/*!< Changes to files matching this are ignored. Cleanup. */
+} sWatchDir;
+
+/*!\brief	Watches directories for changes to their files. */
+typedef struct defWatcher{
+	int fd;
+	sWatchDir *dynarrDirs;	/*!< Cleanup. */
+	unsigned int num;
+} sWatcher;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!\brief	Gets ready to watch directories.
+ *!\return	PROBLEM if watching isn't supported on this platform.
+ */
+errCode startWatching(sWatcher *watcher);
+
+/*!\brief	Starts watching a directory. Watching the same directory again only updates its ID.
+ *!\param	id		Given back by waitForChanges when something in this directory changes.
+ *!\param	strIgnore	Wildcard for files to ignore, such as the ones we write ourselves. Can be null.
+ */
+errCode addWatch(sWatcher *watcher, const char *strDir, unsigned int id, const char *strIgnore);
+
+/*!\brief	Blocks until something changes, then waits until nothing has changed for debounceMs, so a burst of saves
+ *!		is treated as one change.
+ *!\param	outIDs	Gets the IDs of every directory that changed, without repeats.
+ *!\return	PROBLEM if we were interrupted or the watch failed.
+ */
+errCode waitForChanges(sWatcher *watcher, unsigned int debounceMs, sListUint *outIDs);
+
+/*!\brief	*/
+void stopWatching(sWatcher *watcher);
+
+#endif